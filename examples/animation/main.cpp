@@ -53,6 +53,7 @@ struct Application
 	std::array<ObjectData, 5> objects;
 	std::array<BallData, 3> balls;
 	std::array<HGEGraphics::Mesh*, 5> meshs;
+	std::array<HGEGraphics::constant_range_t, 5> object_ubos;
 };
 
 void _init_resource(Application& app)
@@ -252,7 +253,6 @@ void on_draw(oval_device_t* device, HGEGraphics::rendergraph_t& rg, HGEGraphics:
 
 	Application* app = (Application*)device->descriptor.userdata;
 
-	auto ubo_handle = rendergraph_declare_uniform_buffer_quick(&rg, app->objects.size() * sizeof(ObjectData), app->objects.data());
 
 	auto depth_handle = rendergraph_declare_texture(&rg);
 	rg_texture_set_extent(&rg, depth_handle, rg_texture_get_width(&rg, rg_back_buffer), rg_texture_get_height(&rg, rg_back_buffer));
@@ -262,12 +262,15 @@ void on_draw(oval_device_t* device, HGEGraphics::rendergraph_t& rg, HGEGraphics:
 	uint32_t color = 0xff000000;
 	renderpass_add_color_attachment(&passBuilder, rg_back_buffer, ECGPULoadAction::CGPU_LOAD_ACTION_CLEAR, color, ECGPUStoreAction::CGPU_STORE_ACTION_STORE);
 	renderpass_add_depth_attachment(&passBuilder, depth_handle, CGPU_LOAD_ACTION_CLEAR, 0, CGPU_STORE_ACTION_DISCARD, CGPU_LOAD_ACTION_CLEAR, 0, CGPU_STORE_ACTION_DISCARD);
-	renderpass_use_buffer(&passBuilder, ubo_handle);
+	for (size_t i = 0; i < app->objects.size(); ++i)
+	{
+		app->object_ubos[i] = rendergraph_allocate_constants(&rg, sizeof(ObjectData), &app->objects[i]);
+		renderpass_use_buffer(&passBuilder, app->object_ubos[i].buffer);
+	}
 
 	struct MainPassPassData
 	{
 		Application* app;
-		HGEGraphics::buffer_handle_t ubo_handle;
 	};
 	MainPassPassData* passdata;
 	renderpass_set_executable(&passBuilder, [](RenderPassEncoder* encoder, void* passdata)
@@ -278,12 +281,11 @@ void on_draw(oval_device_t* device, HGEGraphics::rendergraph_t& rg, HGEGraphics:
 			set_global_sampler(encoder, app.texture_sampler, 0, 1);
 			for (size_t i = 0; i < app.objects.size(); ++i)
 			{
-				set_global_buffer_with_offset_size(encoder, resolved_passdata->ubo_handle, 0, 2, i * sizeof(ObjectData), sizeof(ObjectData));
+				set_global_buffer_with_offset_size(encoder, app.object_ubos[i].buffer, 0, 2, app.object_ubos[i].offset, app.object_ubos[i].size);
 				draw(encoder, app.shader, app.meshs[i]);
 			}
 		}, sizeof(MainPassPassData), (void**)&passdata);
 	passdata->app = app;
-	passdata->ubo_handle = ubo_handle;
 }
 
 extern "C"
@@ -201,16 +201,16 @@ void on_draw(oval_device_t* device, HGEGraphics::rendergraph_t& rg, HGEGraphics:
 	{
 		particle_vertex_buffer_handle = rendergraph_import_buffer(&rg, oval_mesh_get_vertex_buffer(app->device, app->particle_mesh));
 
-		auto particl_update_ubo_handle = rendergraph_declare_uniform_buffer_quick(&rg, sizeof(ParticleUpdateData), &app->particle_update_data);
+		auto particl_update_ubo = rendergraph_allocate_constants(&rg, sizeof(ParticleUpdateData), &app->particle_update_data);
 
 		auto upvPassBuilder = rendergraph_add_computepass(&rg, u8"update particle vertex");
 		computepass_readwrite_buffer(&upvPassBuilder, particle_vertex_buffer_handle);
-		computepass_use_buffer(&upvPassBuilder, particl_update_ubo_handle);
+		computepass_use_buffer(&upvPassBuilder, particl_update_ubo.buffer);
 		struct ComputePassPassData
 		{
 			Application* app;
 			buffer_handle_t particle_vertex_buffer_handle;
-			buffer_handle_t particl_update_ubo_handle;
+			constant_range_t particl_update_ubo;
 		};
 		ComputePassPassData* passdata1;
 		computepass_set_executable(&upvPassBuilder, [](RenderPassEncoder* encoder, void* passdata)
@@ -218,12 +218,12 @@ void on_draw(oval_device_t* device, HGEGraphics::rendergraph_t& rg, HGEGraphics:
 				ComputePassPassData* resolved_passdata = (ComputePassPassData*)passdata;
 				Application& app = *resolved_passdata->app;
 				set_global_buffer(encoder, resolved_passdata->particle_vertex_buffer_handle, 0, 0);
-				set_global_buffer(encoder, resolved_passdata->particl_update_ubo_handle, 0, 1);
+				set_global_buffer_with_offset_size(encoder, resolved_passdata->particl_update_ubo.buffer, 0, 1, resolved_passdata->particl_update_ubo.offset, resolved_passdata->particl_update_ubo.size);
 				dispatch(encoder, app.particle_updater, PARTICLE_COUNT / 256, 1, 1);
 			}, sizeof(ComputePassPassData), (void**)&passdata1);
 		passdata1->app = app;
 		passdata1->particle_vertex_buffer_handle = particle_vertex_buffer_handle;
-		passdata1->particl_update_ubo_handle = particl_update_ubo_handle;
+		passdata1->particl_update_ubo = particl_update_ubo;
 	}
 
 	auto passBuilder = rendergraph_add_renderpass(&rg, u8"Main Pass");
@@ -275,6 +275,7 @@ int SDL_main(int argc, char *argv[])
 		.height = height,
 		.enable_capture = false,
 		.enable_profile = false,
+		.enable_async_compute = true,
 	};
 	app.device = oval_create_device(&device_descriptor);
 	_init_resource(app);
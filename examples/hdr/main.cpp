@@ -182,9 +182,9 @@ void on_draw(oval_device_t* device, HGEGraphics::rendergraph_t& rg, HGEGraphics:
 
 	Application* app = (Application*)device->descriptor.userdata;
 
-	auto skybox_ubo_handle = rendergraph_declare_uniform_buffer_quick(&rg, sizeof(SkyboxData), &app->skybox_data);
-	auto object_ubo_handle = rendergraph_declare_uniform_buffer_quick(&rg, sizeof(UnlitObjectData), &app->object_data);
-	auto hdr_ubo_handle = rendergraph_declare_uniform_buffer_quick(&rg, sizeof(HDRObjectData), &app->hdr_data);
+	auto skybox_ubo = rendergraph_allocate_constants(&rg, sizeof(SkyboxData), &app->skybox_data);
+	auto object_ubo = rendergraph_allocate_constants(&rg, sizeof(UnlitObjectData), &app->object_data);
+	auto hdr_ubo = rendergraph_allocate_constants(&rg, sizeof(HDRObjectData), &app->hdr_data);
 
 	auto depth_handle = rendergraph_declare_texture(&rg);
 	rg_texture_set_extent(&rg, depth_handle, rg_texture_get_width(&rg, rg_back_buffer), rg_texture_get_height(&rg, rg_back_buffer));
@@ -194,16 +194,16 @@ void on_draw(oval_device_t* device, HGEGraphics::rendergraph_t& rg, HGEGraphics:
 	uint32_t color = 0xff000000;
 	renderpass_add_color_attachment(&passBuilder, rg_back_buffer, ECGPULoadAction::CGPU_LOAD_ACTION_CLEAR, color, ECGPUStoreAction::CGPU_STORE_ACTION_STORE);
 	renderpass_add_depth_attachment(&passBuilder, depth_handle, CGPU_LOAD_ACTION_CLEAR, 0, CGPU_STORE_ACTION_DISCARD, CGPU_LOAD_ACTION_CLEAR, 0, CGPU_STORE_ACTION_DISCARD);
-	renderpass_use_buffer(&passBuilder, skybox_ubo_handle);
-	renderpass_use_buffer(&passBuilder, object_ubo_handle);
-	renderpass_use_buffer(&passBuilder, hdr_ubo_handle);
+	renderpass_use_buffer(&passBuilder, skybox_ubo.buffer);
+	renderpass_use_buffer(&passBuilder, object_ubo.buffer);
+	renderpass_use_buffer(&passBuilder, hdr_ubo.buffer);
 
 	struct MainPassPassData
 	{
 		Application* app;
-		HGEGraphics::buffer_handle_t skybox_ubo_handle;
-		HGEGraphics::buffer_handle_t object_ubo_handle;
-		HGEGraphics::buffer_handle_t hdr_ubo_handle;
+		HGEGraphics::constant_range_t skybox_ubo;
+		HGEGraphics::constant_range_t object_ubo;
+		HGEGraphics::constant_range_t hdr_ubo;
 	};
 	MainPassPassData* passdata;
 	renderpass_set_executable(&passBuilder, [](RenderPassEncoder* encoder, void* passdata)
@@ -212,24 +212,24 @@ void on_draw(oval_device_t* device, HGEGraphics::rendergraph_t& rg, HGEGraphics:
 			Application& app = *resolved_passdata->app;
 			set_global_texture(encoder, app.cubemap, 0, 0);
 			set_global_sampler(encoder, app.cubemap_sampler, 0, 1);
-			set_global_buffer(encoder, resolved_passdata->skybox_ubo_handle, 0, 2);
+			set_global_buffer_with_offset_size(encoder, resolved_passdata->skybox_ubo.buffer, 0, 2, resolved_passdata->skybox_ubo.offset, resolved_passdata->skybox_ubo.size);
 			draw_procedure(encoder, app.skybox_shader, CGPU_PRIM_TOPO_TRI_LIST, 3);
 
 			set_global_texture(encoder, app.colormap, 0, 0);
 			set_global_sampler(encoder, app.cubemap_sampler, 0, 1);
-			set_global_buffer(encoder, resolved_passdata->object_ubo_handle, 0, 2);
+			set_global_buffer_with_offset_size(encoder, resolved_passdata->object_ubo.buffer, 0, 2, resolved_passdata->object_ubo.offset, resolved_passdata->object_ubo.size);
 			//draw(encoder, app.unlit_shader, app.quad);
 
-			set_global_buffer(encoder, resolved_passdata->hdr_ubo_handle, 0, 0);
+			set_global_buffer_with_offset_size(encoder, resolved_passdata->hdr_ubo.buffer, 0, 0, resolved_passdata->hdr_ubo.offset, resolved_passdata->hdr_ubo.size);
 			set_global_texture(encoder, app.colormap, 0, 1);
 			set_global_sampler(encoder, app.cubemap_sampler, 0, 2);
 			set_global_texture(encoder, app.cubemap, 0, 3);
 			draw(encoder, app.hdr_shader, app.sphere);
 		}, sizeof(MainPassPassData), (void**)&passdata);
 	passdata->app = app;
-	passdata->skybox_ubo_handle = skybox_ubo_handle;
-	passdata->object_ubo_handle = object_ubo_handle;
-	passdata->hdr_ubo_handle = hdr_ubo_handle;
+	passdata->skybox_ubo = skybox_ubo;
+	passdata->object_ubo = object_ubo;
+	passdata->hdr_ubo = hdr_ubo;
 }
 
 extern "C"
@@ -286,7 +286,7 @@ void on_draw(oval_device_t* device, HGEGraphics::rendergraph_t& rg, HGEGraphics:
 
 	Application* app = (Application*)device->descriptor.userdata;
 
-	auto object_ubo_handle = rendergraph_declare_uniform_buffer_quick(&rg, sizeof(ObjectData), &app->object_data);
+	auto object_ubo = rendergraph_allocate_constants(&rg, sizeof(ObjectData), &app->object_data);
 
 	auto depth_handle = rendergraph_declare_texture(&rg);
 	rg_texture_set_extent(&rg, depth_handle, rg_texture_get_width(&rg, rg_back_buffer), rg_texture_get_height(&rg, rg_back_buffer));
@@ -296,12 +296,12 @@ void on_draw(oval_device_t* device, HGEGraphics::rendergraph_t& rg, HGEGraphics:
 	uint32_t color = 0xff000000;
 	renderpass_add_color_attachment(&passBuilder, rg_back_buffer, ECGPULoadAction::CGPU_LOAD_ACTION_CLEAR, color, ECGPUStoreAction::CGPU_STORE_ACTION_STORE);
 	renderpass_add_depth_attachment(&passBuilder, depth_handle, CGPU_LOAD_ACTION_CLEAR, 0, CGPU_STORE_ACTION_DISCARD, CGPU_LOAD_ACTION_CLEAR, 0, CGPU_STORE_ACTION_DISCARD);
-	renderpass_use_buffer(&passBuilder, object_ubo_handle);
+	renderpass_use_buffer(&passBuilder, object_ubo.buffer);
 
 	struct MainPassPassData
 	{
 		Application* app;
-		buffer_handle_t object_ubo_handle;
+		constant_range_t object_ubo;
 	};
 	MainPassPassData* passdata;
 	renderpass_set_executable(&passBuilder, [](RenderPassEncoder* encoder, void* passdata)
@@ -311,11 +311,11 @@ void on_draw(oval_device_t* device, HGEGraphics::rendergraph_t& rg, HGEGraphics:
 
 			set_global_texture(encoder, app.noisemap, 0, 0);
 			set_global_sampler(encoder, app.sampler, 0, 1);
-			set_global_buffer(encoder, resolved_passdata->object_ubo_handle, 0, 2);
+			set_global_buffer_with_offset_size(encoder, resolved_passdata->object_ubo.buffer, 0, 2, resolved_passdata->object_ubo.offset, resolved_passdata->object_ubo.size);
 			draw(encoder, app.texture3d, app.quad);
 		}, sizeof(MainPassPassData), (void**)&passdata);
 	passdata->app = app;
-	passdata->object_ubo_handle = object_ubo_handle;
+	passdata->object_ubo = object_ubo;
 }
 
 extern "C"
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "cgpu/api.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <memory_resource>
+
+namespace HGEGraphics
+{
+	struct Texture;
+
+	// device wide texture array that shaders index with a slot passed through push constants or instance data
+	// a shader opts in by declaring a texture array named bindless_textures, that set is then bound once instead of per draw
+	class BindlessHeap
+	{
+	public:
+		static constexpr uint32_t invalid_index = UINT32_MAX;
+		static constexpr const char8_t* resource_name = u8"bindless_textures";
+
+		BindlessHeap(std::pmr::memory_resource* const memory_resource);
+
+		// false when the adapter lacks descriptor indexing, textures are then only bound through per draw descriptor sets
+		bool init(CGPUDeviceId device, uint32_t capacity);
+		bool enabled() const { return !slots.empty(); }
+		uint32_t capacity() const { return (uint32_t)slots.size(); }
+
+		// sets the texture's bindless_index, which stays invalid_index when the heap is disabled or full
+		uint32_t allocate(Texture* texture);
+		void release(Texture* texture);
+		// the view or prepared state of a texture in the heap changed
+		void touch() { ++contentVersion; }
+		// changes whenever the array content does, descriptor sets holding the array are cached by it
+		uint64_t version() const { return contentVersion.load(std::memory_order_relaxed); }
+		// slots without a prepared texture get the fallback view
+		void fill(CGPUTextureViewId fallback, CGPUTextureViewId* views, uint32_t count) const;
+
+	private:
+		mutable std::mutex mutex;
+		std::pmr::vector<Texture*> slots;
+		std::pmr::vector<uint32_t> free_slots;
+		std::atomic<uint64_t> contentVersion{ 0 };
+	};
+}
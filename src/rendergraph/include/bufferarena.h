@@ -0,0 +1,52 @@
+#pragma once
+
+#include "cgpu/api.h"
+#include "resource_type.h"
+#include <vector>
+#include <memory_resource>
+
+namespace HGEGraphics
+{
+	struct Buffer;
+	struct rendergraph_t;
+
+	// linear allocator over persistently mapped memory, owned by one frame in flight and reclaimed once its fence is waited
+	class BufferArena
+	{
+	public:
+		struct Allocation
+		{
+			buffer_handle_t buffer;
+			uint64_t offset;
+			uint8_t* address;
+		};
+
+		BufferArena(CGPUDeviceId device, const char8_t* name, CGPUResourceTypes descriptors, ECGPUMemoryUsage usage, ECGPUResourceState state, uint64_t alignment, uint64_t blockSize, std::pmr::memory_resource* memory_resource);
+
+		Allocation allocate(rendergraph_t* rg, uint64_t size);
+		// overflow blocks of the last use are folded into a single larger one
+		void newFrame();
+		void destroy();
+
+	private:
+		struct Block
+		{
+			Buffer* buffer;
+			uint8_t* mapped;
+			uint64_t size;
+			buffer_handle_t handle;
+		};
+
+		Block createBlock(uint64_t size);
+
+		CGPUDeviceId device;
+		const char8_t* name;
+		CGPUResourceTypes descriptors;
+		ECGPUMemoryUsage usage;
+		ECGPUResourceState state;
+		uint64_t alignment;
+		uint64_t blockSize;
+		uint64_t cursor;
+		std::pmr::vector<Block> blocks;
+	};
+}
@@ -42,6 +42,7 @@ namespace HGEGraphics
 	protected:
 		BufferWrap* getResource_impl(const CGPUBufferDescriptor& descriptor) override;
 		void destroyResource_impl(BufferWrap* resource) override;
+		uint64_t resourceBytes_impl(const BufferWrap* resource) const override;
 
 	private:
 		CGPUDeviceId device{ CGPU_NULLPTR };
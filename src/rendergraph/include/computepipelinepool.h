@@ -8,6 +8,7 @@
 namespace HGEGraphics
 {
 	struct ComputeShader;
+	class PipelineCache;
 
 	struct CPSOKey
 	{
@@ -47,6 +48,8 @@ namespace HGEGraphics
 		ComputePipelinePool(CGPUDeviceId device, ComputePipelinePool* upstream, std::pmr::memory_resource* const memory_resource);
 
 		ComputePipeline* getComputePipeline(ComputeShader* shader);
+		ComputePipeline* prewarm(ComputeShader* shader);
+		void setPipelineCache(PipelineCache* cache) { pipeline_cache = cache; }
 
 		// ͨ ResourcePool ̳
 		virtual ComputePipeline* getResource_impl(const CPSOKey& descriptor) override;
@@ -55,6 +58,7 @@ namespace HGEGraphics
 
 	private:
 		CGPUDeviceId device{ CGPU_NULLPTR };
+		PipelineCache* pipeline_cache{ nullptr };
 		std::pmr::polymorphic_allocator<> allocator;
 	};
 }
\ No newline at end of file
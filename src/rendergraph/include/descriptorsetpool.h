@@ -3,50 +3,125 @@
 #include "cgpu/api.h"
 #include "resourcepool.h"
 #include "hash.h"
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
 
 namespace HGEGraphics
 {
+	// one resource written to a set, resource is the view, sampler or buffer handle
+	struct DescriptorBinding
+	{
+		const void* resource;
+		uint64_t offset;
+		uint64_t size;
+		uint32_t binding;
+		uint32_t type;
+	};
+
+	// a set is looked up by the hash of its bindings and matched by the bindings themselves
+	// a key passed in may point at bindings of the caller, the key a cached set keeps points at the set's own copy
+	struct DescriptorSetKey
+	{
+		CGPURootSignatureId root_signature;
+		uint32_t set_index;
+		uint32_t binding_count;
+		uint64_t content_hash;
+		const DescriptorBinding* bindings;
+	};
+
+	uint64_t hash_descriptor_bindings(const DescriptorBinding* bindings, uint32_t count);
+
 	struct DescriptorSet
 	{
-		CGPUDescriptorSetDescriptor descriptor() const
+		DescriptorSetKey descriptor() const
 		{
 			return _descriptor;
 		}
 		CGPUDescriptorSetId handle;
-		CGPUDescriptorSetDescriptor _descriptor;
+		DescriptorSetKey _descriptor;
+		std::pmr::vector<DescriptorBinding> bindings;
 	};
 
-	struct CGPUDescriptorSetDescriptorHasher
+	struct DescriptorSetKeyHasher
 	{
-		inline size_t operator()(const CGPUDescriptorSetDescriptor& a) const
+		inline size_t operator()(const DescriptorSetKey& a) const
 		{
-			return MurmurHashFn<CGPUDescriptorSetDescriptor>()(a);
+			size_t hash = MurmurHashFn<CGPURootSignatureId>()(a.root_signature);
+			hash = murmur3_combine_fast(hash, a.set_index);
+			hash = murmur3_combine_fast(hash, a.binding_count);
+			return murmur3_combine_fast(hash, a.content_hash);
 		}
 	};
 
-	struct CGPUDescriptorSetDescriptorEq
+	struct DescriptorSetKeyEq
 	{
-		inline bool operator()(const CGPUDescriptorSetDescriptor& a, const CGPUDescriptorSetDescriptor& b) const
+		inline bool operator()(const DescriptorSetKey& a, const DescriptorSetKey& b) const
 		{
-			return !(bool)memcmp(&a, &b, sizeof(CGPUDescriptorSetDescriptor));
+			if (a.root_signature != b.root_signature || a.set_index != b.set_index || a.binding_count != b.binding_count || a.content_hash != b.content_hash)
+				return false;
+			for (uint32_t i = 0; i < a.binding_count; ++i)
+			{
+				auto& x = a.bindings[i];
+				auto& y = b.bindings[i];
+				if (x.resource != y.resource || x.offset != y.offset || x.size != y.size || x.binding != y.binding || x.type != y.type)
+					return false;
+			}
+			return true;
 		}
 	};
 
+	// a freed view, sampler or buffer drops the cached sets that were written with it, so a handle reusing its address never matches them
+	void invalidate_resource_bindings(const void* resource);
+
+	// written sets stay cached by content across draws and frames, evicted ones are kept per layout to be rewritten
+	// the pool belongs to one recording worker of a frame context, so anything it hands out again is no longer in use by the gpu
 	class DescriptorSetPool
-		: public ResourcePool<CGPUDescriptorSetDescriptor, DescriptorSet, false, true, CGPUDescriptorSetDescriptorHasher, CGPUDescriptorSetDescriptorEq>
+		: public ResourcePool<DescriptorSetKey, DescriptorSet, true, true, DescriptorSetKeyHasher, DescriptorSetKeyEq>
 	{
 	public:
 		DescriptorSetPool(CGPUDeviceId device, std::pmr::memory_resource* const memory_resource);
 
-		DescriptorSet* getDescriptorSet(const CGPUDescriptorSetDescriptor& descriptor);
+		// written is false for a set that has just been created or recycled and still has to be filled with the content of key
+		DescriptorSet* getDescriptorSet(const DescriptorSetKey& key, bool& written);
+		void newFrame();
+		void destroy();
+
+		// filled by invalidate_resource_bindings from any thread, kept on the heap so the pool stays movable
+		struct FreedResources
+		{
+			std::mutex mutex;
+			std::atomic<bool> pending{ false };
+			std::vector<const void*> resources;
+		};
 
 	protected:
 		// ͨ ResourcePool ̳
-		virtual DescriptorSet* getResource_impl(const CGPUDescriptorSetDescriptor& descriptor) override;
+		virtual DescriptorSet* getResource_impl(const DescriptorSetKey& descriptor) override;
 		virtual void destroyResource_impl(DescriptorSet* resource) override;
+		virtual DescriptorSetKey keptDescriptor_impl(const DescriptorSetKey& descriptor, const DescriptorSet* resource) const override;
+		virtual CGPUDescriptorSetId createSet(const DescriptorSetKey& key);
+		virtual void freeSet(CGPUDescriptorSetId set);
 
 	private:
+		struct FreeSet
+		{
+			DescriptorSet* set;
+			uint64_t freed;
+		};
+
+		static uint64_t layoutOf(const DescriptorSetKey& key);
+		void dropFreedBindings();
+
 		CGPUDeviceId device{ CGPU_NULLPTR };
 		std::pmr::polymorphic_allocator<> allocator;
+		std::pmr::unordered_map<uint64_t, std::pmr::vector<FreeSet>> free_sets;
+		// cached sets by every resource written to them
+		std::pmr::unordered_multimap<const void*, DescriptorSet*> sets_by_resource;
+		FreedResources* freed{ nullptr };
+		// set by getResource_impl, the set it returns is unwritten
+		bool created{ false };
+		// set while sets using freed resources are dropped in the middle of a frame
+		bool retiring{ false };
 	};
 }
\ No newline at end of file
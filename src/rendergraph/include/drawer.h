@@ -15,6 +15,7 @@ namespace HGEGraphics
 	struct Buffer;
 
 	void push_constants(RenderPassEncoder* encoder, Shader* shader, const char8_t* name, const void* data);
+	void push_constants(RenderPassEncoder* encoder, ComputeShader* shader, const char8_t* name, const void* data);
 	void draw(RenderPassEncoder* encoder, Shader* shader, Mesh* mesh);
 	void draw_submesh(RenderPassEncoder* encoder, Shader* shader, Mesh* mesh, uint32_t index_count, uint32_t first_index, uint32_t vertex_count, uint32_t first_vertex);
 	void draw_procedure(RenderPassEncoder* encoder, Shader* shader, ECGPUPrimitiveTopology mesh_topology, uint32_t vertex_count);
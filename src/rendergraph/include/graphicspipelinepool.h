@@ -4,24 +4,28 @@
 #include "cgpu/api.h"
 #include "hash.h"
 #include <string.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 
 namespace HGEGraphics
 {
 	struct Shader;
 	struct Mesh;
 	struct RenderPassEncoder;
+	class PipelineCache;
+	class WorkerPool;
 
+	// the shader owns its fixed function states and the vertex layout is referred to by id, so a key stays cheap to hash and compare
 	struct PSOKey
 	{
 		Shader* shader;
-		CGPUVertexLayout vertex_layout;
-		ECGPUPrimitiveTopology prim_topology;
-		CGPUBlendStateDescriptor blend_desc;
-		CGPUDepthStateDesc depth_desc;
-		CGPURasterizerStateDescriptor rasterizer_state;
+		uint64_t vertex_layout_id;
 		CGPURenderPassId render_pass;
 		uint32_t subpass;
 		uint32_t render_target_count;
+		ECGPUPrimitiveTopology prim_topology;
+		uint32_t reserved;
 	};
 
 	struct PSOKeyHasher
@@ -40,6 +44,14 @@ namespace HGEGraphics
 		}
 	};
 
+	// owned outside the pool, a worker finishing a compile touches it last, under mutex, so whoever waits on finished may free the pool right after
+	struct PipelineCompileJobs
+	{
+		std::atomic<uint32_t> pending{ 0 };
+		std::mutex mutex;
+		std::condition_variable finished;
+	};
+
 	struct GraphicsPipeline
 	{
 		PSOKey descriptor() const
@@ -48,6 +60,9 @@ namespace HGEGraphics
 		}
 		CGPURenderPipelineId handle;
 		PSOKey _descriptor;
+		CGPUVertexLayout vertex_layout;
+		// false while a worker is still creating handle
+		std::atomic<bool> ready{ true };
 	};
 
 	class GraphicsPipelinePool
@@ -57,7 +72,11 @@ namespace HGEGraphics
 		GraphicsPipelinePool(CGPUDeviceId device, GraphicsPipelinePool* upstream, std::pmr::memory_resource* const memory_resource);
 
 		GraphicsPipeline* getGraphicsPipeline(RenderPassEncoder* encoder, Shader* shader, Mesh* mesh);
-		GraphicsPipeline* getGraphicsPipeline(RenderPassEncoder* encoder, Shader* shader, ECGPUPrimitiveTopology prim_topology, const CGPUVertexLayout& vertex_layout);
+		GraphicsPipeline* getGraphicsPipeline(RenderPassEncoder* encoder, Shader* shader, ECGPUPrimitiveTopology prim_topology, const CGPUVertexLayout& vertex_layout, uint64_t vertex_layout_id);
+		GraphicsPipeline* prewarm(const PSOKey& key, const CGPUVertexLayout& vertex_layout, const CGPURenderPassDescriptor& render_pass);
+		void setPipelineCache(PipelineCache* cache) { pipeline_cache = cache; }
+		// with a worker pool new pipelines are created on its threads and returned before they are ready, pending counts them until they are
+		void setAsyncCompile(WorkerPool* worker_pool, PipelineCompileJobs* jobs) { async_worker_pool = worker_pool; compile_jobs = jobs; }
 
 		// ͨ ResourcePool ̳
 		virtual GraphicsPipeline* getResource_impl(const PSOKey& descriptor) override;
@@ -68,8 +87,21 @@ namespace HGEGraphics
 		bool dynamicStateT2Enabled() const { return dynamic_state_t2; }
 		bool dynamicStateT3Enabled() const { return dynamic_state_t3; }
 
+	protected:
+		// the only device calls of the pool, may run on a worker thread
+		virtual CGPURenderPipelineId createPipeline(const PSOKey& key, const CGPUVertexLayout& vertex_layout);
+		virtual void freePipeline(CGPURenderPipelineId pipeline);
+
 	private:
+		GraphicsPipeline* getGraphicsPipeline(const PSOKey& key, const CGPUVertexLayout* vertex_layout, const CGPURenderPassDescriptor* render_pass);
+
 		CGPUDeviceId device{ CGPU_NULLPTR };
+		PipelineCache* pipeline_cache{ nullptr };
+		WorkerPool* async_worker_pool{ nullptr };
+		PipelineCompileJobs* compile_jobs{ nullptr };
+		// the key only refers to these, getResource_impl needs them in full
+		const CGPUVertexLayout* creating_vertex_layout{ nullptr };
+		const CGPURenderPassDescriptor* creating_render_pass{ nullptr };
 		CGPUDynamicStateFeatures _dynamic_state_features{ 0 };
 		bool dynamic_state_t1{ false };
 		bool dynamic_state_t2{ false };
@@ -33,6 +33,17 @@ namespace HGEGraphics
         }
     };
 
+    // 64 bit FNV-1a over raw bytes, stable across runs so it can key data saved to disk
+    inline uint64_t fnv1a64(const void* data, size_t length, uint64_t seed = 0xcbf29ce484222325ull) noexcept {
+        const uint8_t* bytes = (const uint8_t*)data;
+        uint64_t h = seed;
+        for (size_t i = 0; i < length; ++i) {
+            h ^= bytes[i];
+            h *= 0x100000001b3ull;
+        }
+        return h;
+    }
+
     // combines two hashes together, faster but less good
     template<class T>
     inline size_t murmur3_combine_fast(size_t seed, const T& v) noexcept {
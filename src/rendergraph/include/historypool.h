@@ -0,0 +1,58 @@
+#pragma once
+
+#include "cgpu/api.h"
+#include <string>
+#include <vector>
+#include <memory_resource>
+
+namespace HGEGraphics
+{
+	struct Texture;
+
+	// textures that live across frames, every name owns two of them which swap roles each frame it is declared
+	class HistoryPool
+	{
+	public:
+		struct Versions
+		{
+			Texture* current;
+			// null when nothing was written to it last frame, e.g. on first use or after a resize
+			Texture* previous;
+		};
+
+		HistoryPool(CGPUDeviceId device, uint32_t frame_before_release, std::pmr::memory_resource* const memory_resource);
+
+		Versions acquire(const char8_t* name, uint16_t width, uint16_t height, ECGPUFormat format);
+		// frees the textures of names not declared for frame_before_release frames
+		void newFrame();
+		void destroy();
+
+	private:
+		struct Entry
+		{
+			std::pmr::u8string name;
+			uint16_t width;
+			uint16_t height;
+			ECGPUFormat format;
+			Texture* textures[2];
+			uint8_t current;
+			bool continuous;
+			uint64_t lastUsed;
+		};
+
+		struct Retired
+		{
+			Texture* texture;
+			uint64_t frame;
+		};
+
+		void createTextures(Entry& entry);
+		void retireTextures(Entry& entry);
+
+		CGPUDeviceId device;
+		uint32_t frame_before_release;
+		uint64_t frame;
+		std::pmr::vector<Entry> entries;
+		std::pmr::vector<Retired> retired;
+	};
+}
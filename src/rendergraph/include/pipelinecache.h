@@ -0,0 +1,69 @@
+#pragma once
+
+#include "cgpu/api.h"
+#include <mutex>
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <memory_resource>
+
+namespace HGEGraphics
+{
+	struct Shader;
+	struct ComputeShader;
+	struct ExecutorContext;
+	class GraphicsPipelinePool;
+	class ComputePipelinePool;
+	class RenerPassPool;
+
+	// a graphics pipeline key that stays valid across runs, the shader and render pass are stored by content instead of by handle
+	// only the fields the renderer sets are kept, the manifest writes them one by one and semantic names as strings
+	struct GraphicsPipelineRecord
+	{
+		uint64_t shader_hash;
+		CGPUVertexLayout vertex_layout;
+		ECGPUPrimitiveTopology prim_topology;
+		CGPUBlendStateDescriptor blend_desc;
+		CGPUDepthStateDesc depth_desc;
+		CGPURasterizerStateDescriptor rasterizer_state;
+		CGPURenderPassDescriptor render_pass;
+		uint32_t subpass;
+		uint32_t render_target_count;
+	};
+
+	struct ComputePipelineRecord
+	{
+		uint64_t shader_hash;
+	};
+
+	// manifest of the pipelines created by earlier runs, so they can be created when their shader is loaded instead of at first draw
+	class PipelineCache
+	{
+	public:
+		PipelineCache(std::pmr::memory_resource* const memory_resource);
+
+		bool load(const char* path);
+		bool save(const char* path) const;
+
+		void record(const GraphicsPipelineRecord& record);
+		void record(const ComputePipelineRecord& record);
+		// creates every pipeline of the manifest using the shader in the context's pools
+		void prewarm(ExecutorContext& context, Shader* shader);
+		void prewarm(ExecutorContext& context, ComputeShader* shader);
+		void prewarm(GraphicsPipelinePool& pipelines, RenerPassPool& render_passes, Shader* shader);
+		void prewarm(ComputePipelinePool& pipelines, ComputeShader* shader);
+
+		uint32_t prewarmed() const { return prewarmedCount; }
+		// pipelines created while recording that no earlier run had seen
+		uint32_t uncached() const { return uncachedCount; }
+
+	private:
+		mutable std::mutex mutex;
+		// semantic names of the recorded vertex layouts, callers may free theirs
+		std::pmr::unordered_set<std::pmr::u8string> names;
+		std::pmr::vector<GraphicsPipelineRecord> graphics;
+		std::pmr::vector<ComputePipelineRecord> compute;
+		uint32_t prewarmedCount = 0;
+		uint32_t uncachedCount = 0;
+	};
+}
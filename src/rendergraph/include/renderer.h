@@ -16,10 +16,13 @@
 #include <optional>
 #include "profiler.h"
 #include "resource_type.h"
+#include "workerpool.h"
+#include "subresourcestates.h"
 
 namespace HGEGraphics
 {
 	struct rendergraph_t;
+	class BindlessHeap;
 
 	struct Shader
 	{
@@ -29,6 +32,8 @@ namespace HGEGraphics
 		CGPUBlendStateDescriptor blend_desc;
 		CGPUDepthStateDesc depth_desc;
 		CGPURasterizerStateDescriptor rasterizer_state;
+		// hash of the shader code, identifies the shader across runs
+		uint64_t hash;
 	};
 
 	Shader* create_shader(CGPUDeviceId device, const std::string& vertPath, const std::string& fragPath, const CGPUBlendStateDescriptor& blend_desc, const CGPUDepthStateDesc& depth_desc, const CGPURasterizerStateDescriptor& rasterizer_state);
@@ -39,6 +44,7 @@ namespace HGEGraphics
 	{
 		CGPURootSignatureId root_sig;
 		CGPUShaderEntryDescriptor cs;
+		uint64_t hash;
 	};
 
 	ComputeShader* create_compute_shader(CGPUDeviceId device, const std::string& compPath);
@@ -59,6 +65,7 @@ namespace HGEGraphics
 	struct Mesh
 	{
 		CGPUVertexLayout vertex_layout;
+		uint64_t vertex_layout_id;
 		ECGPUPrimitiveTopology prim_topology;
 		uint32_t vertex_stride;
 		uint32_t index_stride;
@@ -69,6 +76,10 @@ namespace HGEGraphics
 		bool prepared;
 	};
 
+	// the index of the layout in a process wide table, equal layouts share it so pipeline keys can compare layouts by id
+	uint64_t intern_vertex_layout(const CGPUVertexLayout& vertex_layout);
+	// compares semantic names by content
+	bool same_vertex_layout(const CGPUVertexLayout& a, const CGPUVertexLayout& b);
 	Mesh* create_empty_mesh();
 	void init_mesh(Mesh* mesh, CGPUDeviceId device, uint32_t vertex_count, uint32_t index_count, ECGPUPrimitiveTopology prim_topology, const CGPUVertexLayout& vertex_layout, uint32_t index_stride, bool update_vertex_data_from_compute_shader, bool update_index_data_from_compute_shader);
 	Mesh* create_mesh(CGPUDeviceId device, uint32_t vertex_count, uint32_t index_count, ECGPUPrimitiveTopology prim_topology, const CGPUVertexLayout& vertex_layout, uint32_t index_stride, bool update_vertex_data_from_compute_shader, bool update_index_data_from_compute_shader);
@@ -82,10 +93,12 @@ namespace HGEGraphics
 	{
 		CGPUTextureId handle;
 		CGPUTextureViewId view;
-		std::vector<ECGPUResourceState> cur_states;
-		bool states_consistent;
+		SubresourceStates cur_states;
 		bool prepared;
+		bool unordered_access;
 		texture_handle_t dynamic_handle;
+		// slot in the BindlessHeap, UINT32_MAX while it has none
+		uint32_t bindless_index = UINT32_MAX;
 	};
 
 	Texture* create_empty_texture();
@@ -123,6 +136,68 @@ namespace HGEGraphics
 		uint64_t offset, size;
 	};
 
+	struct QueueSubmission
+	{
+		ECGPUQueueType queue;
+		CGPUCommandBufferId* cmds;
+		uint32_t cmd_count;
+		CGPUSemaphoreId wait_semaphore;
+		CGPUSemaphoreId signal_semaphore;
+	};
+
+	struct ExecutorContext;
+	struct TextureViewLookup
+	{
+		CGPUTextureViewDescriptor desc;
+		CGPUTextureViewId view;
+	};
+
+	struct ExecutorWorker
+	{
+		CGPUCommandPoolId cmdPool = { CGPU_NULLPTR };
+		std::pmr::vector<CGPUCommandBufferId> cmds;
+		std::pmr::vector<CGPUCommandBufferId> allocated_cmds;
+		CGPUCommandPoolId computeCmdPool = { CGPU_NULLPTR };
+		std::pmr::vector<CGPUCommandBufferId> compute_cmds;
+		std::pmr::vector<CGPUCommandBufferId> allocated_compute_cmds;
+		std::pmr::vector<ShaderTextureBinder> global_texture_table;
+		std::pmr::vector<ShaderSamplerBinder> global_sampler_table;
+		std::pmr::vector<ShaderBufferBinder> global_buffer_table;
+		// set and slot of globals set by earlier passes of this frame, only filled in debug builds
+		std::pmr::vector<uint32_t> dropped_globals;
+		// sets are looked up on every draw, so each recording thread keeps its own pool and takes no lock for them
+		DescriptorSetPool descriptorSetPool;
+		// views already resolved by this worker in this frame, misses go to the shared pool under poolMutex
+		TextureViewLookup view_lookup[16] = {};
+
+		ExecutorWorker(CGPUDeviceId device, CGPUQueueId gfx_queue, CGPUQueueId compute_queue, std::pmr::memory_resource* memory_resource);
+
+		void newFrame();
+		// globals only last for the pass that sets them, however passes are split across recording threads
+		void resetGlobals();
+		bool droppedGlobal(uint32_t set, uint32_t slot) const;
+		CGPUTextureViewId getTextureView(ExecutorContext* context, const CGPUTextureViewDescriptor& desc);
+
+		CGPUCommandBufferId requestCmd(ECGPUQueueType queue);
+
+		void destroy();
+	};
+
+	// begins a transition early and finishes it where it is needed, e.g. with events; both halves get the same barriers and slot pairs them within a frame
+	struct SplitBarrierBackend
+	{
+		void (*begin)(void* user, CGPUCommandBufferId cmd, uint32_t slot, const CGPUResourceBarrierDescriptor* desc) = nullptr;
+		void (*end)(void* user, CGPUCommandBufferId cmd, uint32_t slot, const CGPUResourceBarrierDescriptor* desc) = nullptr;
+		void* user = nullptr;
+	};
+
+	// updated by recording and compile threads, kept on the heap like poolMutex so the context stays movable
+	struct PipelineCompileStats
+	{
+		PipelineCompileJobs jobs;
+		std::atomic<uint32_t> skipped_draws{ 0 };
+	};
+
 	struct ExecutorContext
 	{
 		std::pmr::memory_resource* memory_resource = nullptr;
@@ -133,31 +208,53 @@ namespace HGEGraphics
 		ComputePipelinePool computePipelinePool;
 		TextureViewPool textureViewPool;
 		BufferPool bufferPool;
-		CGPUCommandPoolId cmdPool = { CGPU_NULLPTR };
-		std::pmr::vector<CGPUCommandBufferId> cmds;
-		std::pmr::vector<CGPUCommandBufferId> allocated_cmds;
-		std::pmr::vector<ShaderTextureBinder> global_texture_table;
-		std::pmr::vector<ShaderSamplerBinder> global_sampler_table;
-		std::pmr::vector<ShaderBufferBinder> global_buffer_table;
-		DescriptorSetPool descriptorSetPool;
-		std::pmr::vector<DescriptorSet*> allocated_dsets;
+		WorkerPool* workerPool = nullptr;
+		std::pmr::vector<ExecutorWorker> workers;
+		// guards the render pass, framebuffer and texture view pools, pipelinePool and computePipelinePool have pipelineMutex
+		std::mutex* poolMutex = nullptr;
+		std::mutex* pipelineMutex = nullptr;
+		std::pmr::vector<CGPUSemaphoreId> semaphores;
+		std::pmr::vector<CGPUCommandBufferId> submitted_cmds;
+		std::pmr::vector<QueueSubmission> submissions;
+		std::pmr::vector<CGPUTextureBarrier> texture_barriers;
+		std::pmr::vector<CGPUBufferBarrier> buffer_barriers;
+		// without a backend split barriers are placed whole before their consumer
+		SplitBarrierBackend splitBarrierBackend;
 		CGPUDeviceId device = { CGPU_NULLPTR };
 		uint64_t timestamp = { 0 };
 		Profiler* profiler = nullptr;
 		double gpuTicksPerSecond = 0;
 		CGPUTextureViewId default_texture = CGPU_NULLPTR;
+		std::array<ResourcePoolStats, 8> pool_stats = {};
+		// drawn instead of shaders whose pipeline is still compiling, without it those draws are skipped
+		Shader* fallback_shader = nullptr;
+		PipelineCompileStats* compileStats = nullptr;
+		// without a heap, or when it is disabled, shaders declaring the bindless array get the default texture
+		BindlessHeap* bindlessHeap = nullptr;
 
-		ExecutorContext(CGPUDeviceId device, CGPUQueueId gfx_queue, bool profile, std::pmr::memory_resource* memory_resource);
+		ExecutorContext(CGPUDeviceId device, CGPUQueueId gfx_queue, CGPUQueueId compute_queue, WorkerPool* worker_pool, bool profile, std::pmr::memory_resource* memory_resource);
 
 		void newFrame();
-
-		CGPUCommandBufferId requestCmd();
+		void setPoolBudget(PoolBudget* budget);
+		void setPipelineCache(PipelineCache* cache);
+		void setBindlessHeap(BindlessHeap* heap);
+		void setAsyncPipelineCompile(bool enable, Shader* fallback);
+		void queryPipelineCompiles(uint32_t& pending, uint32_t& skipped_draws);
+		void queryPoolStats(uint32_t& length, const char8_t**& names, const ResourcePoolStats*& stats);
 
 		void destroy();
 		void pre_destroy();
 	};
 
 	struct CompiledRenderGraph;
+	struct PipelineLookup
+	{
+		Shader* shader;
+		uint64_t vertex_layout_id;
+		ECGPUPrimitiveTopology prim_topology;
+		GraphicsPipeline* pipeline;
+	};
+
 	struct RenderPassEncoder
 	{
 		CGPURenderPassEncoderId encoder;
@@ -165,14 +262,15 @@ namespace HGEGraphics
 		CGPUStateBufferId state_buffer;
 		CGPURasterStateEncoderId raster_state_encoder;
 		CGPURenderPassId render_pass;
+		const CGPURenderPassDescriptor* render_pass_desc;
 		uint32_t subpass;
 		uint32_t render_target_count;
 		ExecutorContext* context;
+		ExecutorWorker* worker;
 		CompiledRenderGraph* compiled_graph;
 		CGPURenderPipelineId last_render_pipeline;
 		CGPUComputePipelineId last_compute_pipeline;
-		CGPUDescriptorData last_bind_resources[4][64];
-		uint64_t last_buffer_offset_sizes[4][128];
+		DescriptorSet* last_descriptor_sets[4];
 		CGPUTextureViewId textureviews[64] = {};
 		CGPUSamplerId samplers[64] = {};
 		CGPUBufferId buffers[64] = {};
@@ -181,6 +279,8 @@ namespace HGEGraphics
 		CGPUBufferId last_index_buffer;
 		uint32_t last_vertex_buffer_stride;
 		uint32_t last_index_buffer_stride;
+		// direct mapped by shader, layout and topology, the rest of a pipeline key is fixed for the encoder
+		PipelineLookup pipeline_lookup[8] = {};
 	};
 
 	struct UploadEncoder
@@ -12,6 +12,9 @@
 namespace HGEGraphics
 {
 	struct Shader;
+	struct ComputeShader;
+	class BufferArena;
+	class HistoryPool;
 	struct Backbuffer;
 	struct Buffer;
 	struct Texture;
@@ -43,6 +46,8 @@ namespace HGEGraphics
 		ECGPULoadAction load_action = CGPU_LOAD_ACTION_DONTCARE;
 		ECGPUStoreAction store_action = CGPU_STORE_ACTION_DISCARD;
 		bool valid = false;
+		bool auto_load = false;
+		bool auto_store = false;
 	};
 
 	struct alignas(8) DepthAttachmentInfo
@@ -55,6 +60,8 @@ namespace HGEGraphics
 		ECGPULoadAction stencil_load_action = CGPU_LOAD_ACTION_DONTCARE;
 		ECGPUStoreAction stencil_store_action = CGPU_STORE_ACTION_DISCARD;
 		bool valid = false;
+		bool auto_load = false;
+		bool auto_store = false;
 	};
 
 	class polymorphic_allocator_delete
@@ -86,6 +93,9 @@ namespace HGEGraphics
 		ECGPUFormat format;
 		uint8_t mipCount;;
 		uint8_t arraySize;
+		uint8_t sampleCount;
+		CGPUResourceTypes textureType;
+		bool bucketed;
 		uint32_t size;
 		index_type_t parent;
 		uint8_t mipLevel;
@@ -119,11 +129,9 @@ namespace HGEGraphics
 
 	struct RenderPassNode
 	{
-		RenderPassNode(const char8_t* name, pass_type type, std::pmr::memory_resource* const momory_resource);
+		RenderPassNode(const char8_t* name, pass_type type);
 
 		const char8_t* name{ nullptr };
-		std::pmr::vector<uint32_t> writes;
-		std::pmr::vector<uint32_t> reads;
 		void* passdata;
 		pass_type type;
 
@@ -147,6 +155,8 @@ namespace HGEGraphics
 		struct upload_texture_context_t
 		{
 			buffer_handle_t staging_buffer;
+			uint64_t staging_offset;
+			uint64_t staging_size;
 			texture_handle_t dest_texture;
 			uploadpass_executable executable;
 			uint64_t size;
@@ -154,11 +164,15 @@ namespace HGEGraphics
 			void* data;
 			uint8_t mipmap;
 			uint8_t slice;
+			uint8_t mipCount;
+			uint8_t sliceCount;
 		};
 
 		struct upload_buffer_context_t
 		{
 			buffer_handle_t staging_buffer;
+			uint64_t staging_offset;
+			uint64_t staging_size;
 			buffer_handle_t dest_buffer;
 			uploadpass_executable executable;
 			uint64_t size;
@@ -189,6 +203,8 @@ namespace HGEGraphics
 
 	void renderpass_add_color_attachment(renderpass_builder_t* self, texture_handle_t texture, ECGPULoadAction load_action, uint32_t clearColor, ECGPUStoreAction store_action);
 	void renderpass_add_depth_attachment(renderpass_builder_t* self, texture_handle_t texture, ECGPULoadAction depth_load_action, float clearDepth, ECGPUStoreAction depth_store_action, ECGPULoadAction stencil_load_action, uint8_t clearStencil, ECGPUStoreAction stencil_store_action);
+	void renderpass_add_color_attachment_auto(renderpass_builder_t* self, texture_handle_t texture, bool clear, uint32_t clearColor);
+	void renderpass_add_depth_attachment_auto(renderpass_builder_t* self, texture_handle_t texture, bool clear, float clearDepth, uint8_t clearStencil);
 	void renderpass_sample(renderpass_builder_t* self, texture_handle_t texture);
 	void renderpass_use_buffer(renderpass_builder_t* self, buffer_handle_t buffer);
 	void renderpass_use_buffer_as(renderpass_builder_t* self, buffer_handle_t buffer, ECGPUResourceState state);
@@ -203,10 +219,19 @@ namespace HGEGraphics
 	void rg_texture_set_extent(rendergraph_t* self, texture_handle_t texture, uint32_t width, uint32_t height, uint32_t depth = 1);
 	void rg_texture_set_format(rendergraph_t* self, texture_handle_t texture, ECGPUFormat format);
 	void rg_texture_set_depth_format(rendergraph_t* self, texture_handle_t texture, DepthBits depthBits, bool needStencil);
+	void rg_texture_set_mip_count(rendergraph_t* self, texture_handle_t texture, uint8_t mip_count);
+	void rg_texture_set_array_size(rendergraph_t* self, texture_handle_t texture, uint8_t array_size);
+	void rg_texture_set_sample_count(rendergraph_t* self, texture_handle_t texture, ECGPUSampleCount sample_count);
+	// descriptors on top of the sampled and attachment ones, e.g. CGPU_RESOURCE_TYPE_RW_TEXTURE
+	void rg_texture_set_usage(rendergraph_t* self, texture_handle_t texture, CGPUResourceTypes usage);
+	// lets the pool hand out a texture rounded up to a size bucket, passes then render into its top left width x height
+	void rg_texture_set_bucketed(rendergraph_t* self, texture_handle_t texture);
 	uint32_t rg_texture_get_width(rendergraph_t* self, texture_handle_t texture);
 	uint32_t rg_texture_get_height(rendergraph_t* self, texture_handle_t texture);
 	uint32_t rg_texture_get_depth(rendergraph_t* self, texture_handle_t texture);
 	ECGPUFormat rg_texture_get_format(rendergraph_t* self, texture_handle_t texture);
+	uint32_t rg_texture_get_storage_width(rendergraph_t* self, texture_handle_t texture);
+	uint32_t rg_texture_get_storage_height(rendergraph_t* self, texture_handle_t texture);
 
 	void rg_buffer_set_size(rendergraph_t* self, buffer_handle_t buffer, uint32_t size);
 	void rg_buffer_set_type(rendergraph_t* self, buffer_handle_t buffer, ECGPUResourceType type);
@@ -221,14 +246,29 @@ namespace HGEGraphics
 		std::pmr::vector<ResourceNode> resources;
 		std::pmr::vector<RenderPassNode> passes;
 		std::pmr::vector<RenderGraphEdge> edges;
+		// indices into edges, a pass is edge.to of its reads and edge.from of its writes
+		std::pmr::vector<uint32_t> read_edges;
+		std::pmr::vector<uint32_t> write_edges;
 		allocator_type allocator;
 		Shader* blitShader;
 		CGPUSamplerId blitSampler;
+		ComputeShader* mipmapShader{ nullptr };
+		BufferArena* constantArena{ nullptr };
+		BufferArena* stagingArena{ nullptr };
+		HistoryPool* historyPool{ nullptr };
 		std::pmr::vector<Texture*> imported_textures;
 		std::pmr::vector<Buffer*> imported_buffers;
+		bool reorder_passes{ false };
+		bool async_compute{ false };
 	};
 
 	void rendergraph_reset(rendergraph_t* self);
+	void rendergraph_set_reorder_passes(rendergraph_t* self, bool enable);
+	void rendergraph_set_async_compute(rendergraph_t* self, bool enable);
+	void rendergraph_set_mipmap_shader(rendergraph_t* self, ComputeShader* shader);
+	void rendergraph_set_constant_arena(rendergraph_t* self, BufferArena* arena);
+	void rendergraph_set_staging_arena(rendergraph_t* self, BufferArena* arena);
+	void rendergraph_set_history_pool(rendergraph_t* self, HistoryPool* pool);
 	inline bool rendergraph_texture_handle_valid(texture_handle_t handle)
 	{
 		return handle.index != 0;
@@ -242,6 +282,8 @@ namespace HGEGraphics
 	renderpass_builder_t rendergraph_add_holdpass(rendergraph_t* self, const char8_t* name);
 	void rendergraph_add_uploadtexturepass(rendergraph_t* self, const char8_t* name, texture_handle_t texture, uint8_t mipmap, uint8_t slice, uploadpass_executable executable, size_t passdata_size, void** passdata);
 	void rendergraph_add_uploadtexturepass_ex(rendergraph_t* self, const char8_t* name, texture_handle_t texture, uint8_t mipmap, uint8_t slice, uint64_t size, uint64_t offset, void* data, uploadpass_executable executable, size_t passdata_size, void** passdata);
+	// uploads mips [0, mip_count) of every slice in one pass, data is tightly packed mip by mip and slice by slice within a mip
+	void rendergraph_add_uploadtexturepass_full(rendergraph_t* self, const char8_t* name, texture_handle_t texture, uint8_t mip_count, uint64_t size, void* data);
 	void rendergraph_add_uploadbufferpass(rendergraph_t* self, const char8_t* name, buffer_handle_t buffer, uploadpass_executable executable, size_t passdata_size, void** passdata);
 	void rendergraph_add_uploadbufferpass_ex(rendergraph_t* self, const char8_t* name, buffer_handle_t buffer, uint64_t size, uint64_t offset, void* data, uploadpass_executable executable, size_t passdata_size, void** passdata);
 	void rendergraph_add_generate_mipmap(rendergraph_t* self, texture_handle_t texture, uint8_t from_mipmap);
@@ -249,13 +291,16 @@ namespace HGEGraphics
 	texture_handle_t rendergraph_declare_texture(rendergraph_t* self);
 	texture_handle_t rendergraph_import_texture(rendergraph_t* self, Texture* imported);
 	texture_handle_t rendergraph_import_backbuffer(rendergraph_t* self, Backbuffer* imported);
+	// a texture kept across frames under name, previous gets last frame's version or an invalid handle when it has none
+	texture_handle_t rendergraph_declare_history_texture(rendergraph_t* self, const char8_t* name, uint16_t width, uint16_t height, ECGPUFormat format, texture_handle_t* previous);
 	buffer_handle_t rendergraph_declare_buffer(rendergraph_t* self);
 	buffer_handle_t rendergraph_import_buffer(rendergraph_t* self, Buffer* imported);
 	buffer_handle_t rendergraph_import_dynamic_buffer(rendergraph_t* self, Buffer* imported);
-	buffer_handle_t rendergraph_declare_uniform_buffer_quick(rendergraph_t* self, uint32_t size, void* data);
+	constant_range_t rendergraph_allocate_constants(rendergraph_t* self, uint32_t size, const void* data);
 	texture_handle_t rendergraph_declare_texture_subresource(rendergraph_t* self, texture_handle_t parent, uint8_t mipmap, uint8_t slice);
 	uint32_t rendergraph_add_edge(rendergraph_t* self, index_type_t from, index_type_t to, ECGPUResourceState usage);
 
 	CGPUBufferId rendergraph_resolve_buffer(RenderPassEncoder* encoder, buffer_handle_t buffer_handle);
 	CGPUTextureViewId rendergraph_resolve_texture_view(RenderPassEncoder* encoder, texture_handle_t texture_handle);
+	CGPUTextureViewId rendergraph_resolve_texture_uav(RenderPassEncoder* encoder, texture_handle_t texture_handle);
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "rendergraph.h"
+#include <memory_resource>
 
 namespace HGEGraphics
 {
@@ -9,7 +10,7 @@ namespace HGEGraphics
 
 	struct CompiledResourceNode
 	{
-		CompiledResourceNode(const char8_t* name, ManageType type, uint16_t width, uint16_t height, uint16_t depth, ECGPUFormat format, Texture* texture, uint8_t mipCount, uint8_t arraySize, index_type_t parent, uint8_t mipLevel, uint8_t arraySlice);
+		CompiledResourceNode(const char8_t* name, ManageType type, uint16_t width, uint16_t height, uint16_t depth, ECGPUFormat format, Texture* texture, uint8_t mipCount, uint8_t arraySize, uint8_t sampleCount, CGPUResourceTypes textureType, bool bucketed, index_type_t parent, uint8_t mipLevel, uint8_t arraySlice);
 		CompiledResourceNode(const char8_t* name, ManageType type, uint32_t size, Buffer* imported_buffer, CGPUResourceTypes bufferType, ECGPUMemoryUsage memoryUsage);
 		CompiledResourceNode();
 
@@ -29,9 +30,105 @@ namespace HGEGraphics
 		const ECGPUMemoryUsage memoryUsage;
 		uint8_t mipCount;;
 		uint8_t arraySize;
+		uint8_t sampleCount;
+		CGPUResourceTypes textureType;
+		bool bucketed;
 		index_type_t parent;
 		uint8_t mipLevel;
 		uint8_t arraySlice;
+		index_type_t aliasBlock;
+		uint64_t allocationSize;
+	};
+
+	struct CompiledAliasBlock
+	{
+		ResourceType resourceType;
+		index_type_t resource;
+		index_type_t lastPass;
+		uint64_t size;
+		TextureWrap* managered_texture;
+		BufferWrap* managed_buffer;
+		index_type_t exitState;
+	};
+
+	enum class QueueTransfer : uint8_t
+	{
+		None,
+		Release,
+		Acquire,
+	};
+
+	struct CompiledBarrier
+	{
+		index_type_t resource;
+		ECGPUResourceState src_state;
+		ECGPUResourceState dst_state;
+		uint8_t mipLevel;
+		uint8_t arraySlice;
+		bool subresource;
+		bool entry;
+		QueueTransfer transfer;
+		ECGPUQueueType queue;
+		// head of the pass group after which the transition may begin, when unrelated passes run before the consumer
+		index_type_t splitAfter{ MAX_INDEX };
+	};
+
+	struct CompiledQueueBatch
+	{
+		ECGPUQueueType queue;
+		uint32_t passOffset;
+		uint32_t passCount;
+		uint32_t barrierOffset;
+		uint32_t barrierCount;
+		index_type_t wait;
+		bool signal;
+	};
+
+	struct CompiledExitState
+	{
+		index_type_t resource;
+		index_type_t aliasBlock;
+		uint32_t stateOffset;
+		uint32_t stateCount;
+		bool consistent;
+	};
+
+	inline bool is_forced_barrier(ResourceType type, ECGPUResourceState state)
+	{
+		if (type == ResourceType::Texture)
+			return state == CGPU_RESOURCE_STATE_RENDER_TARGET || state == CGPU_RESOURCE_STATE_DEPTH_WRITE || state == CGPU_RESOURCE_STATE_COPY_DEST || state == CGPU_RESOURCE_STATE_UNORDERED_ACCESS;
+		return state == CGPU_RESOURCE_STATE_COPY_DEST || state == CGPU_RESOURCE_STATE_UNORDERED_ACCESS;
+	}
+
+	// transient buffers only, textures are not aliased and always get a block of their own
+	struct TransientMemoryStats
+	{
+		uint64_t requested_bytes;
+		uint64_t allocated_bytes;
+		uint64_t peak_bytes;
+		uint32_t resource_count;
+		uint32_t block_count;
+	};
+
+	// barrier counts are estimated per whole resource for both orders, the planned barriers are in CompiledRenderGraph::barriers
+	struct ScheduleStats
+	{
+		bool reordered;
+		uint32_t declared_barrier_count;
+		uint32_t scheduled_barrier_count;
+		uint32_t split_barrier_count;
+	};
+
+	struct AttachmentActionStats
+	{
+		uint32_t auto_attachments;
+		uint32_t dontcare_loads;
+		uint32_t discarded_stores;
+	};
+
+	struct RenderPassMergeStats
+	{
+		uint32_t merged_passes;
 	};
 
 	struct CompiledEdge
@@ -47,23 +144,33 @@ namespace HGEGraphics
 
 		const char8_t* name{ nullptr };
 		pass_type type;
+		index_type_t source{ 0 };
+		ECGPUQueueType queue{ CGPU_QUEUE_TYPE_GRAPHICS };
+		index_type_t batch{ 0 };
 		std::pmr::vector<CompiledEdge> writes;
 		std::pmr::vector<CompiledEdge> reads;
 		std::pmr::vector<index_type_t> devirtualize;
 		std::pmr::vector<index_type_t> destroy;
+		uint32_t barrierOffset{ 0 };
+		uint32_t barrierCount{ 0 };
 		void* passdata;
 		int colorAttachmentCount{ 0 };
 		std::array<ColorAttachmentInfo, 8> colorAttachments;
 		DepthAttachmentInfo depthAttachment;
+		uint32_t mergedPassCount{ 1 };
+		bool merged{ false };
 		renderpass_executable executable;
 		uint16_t staging_buffer;
 		uint16_t dest_texture;
 		uint16_t dest_buffer;
+		uint64_t staging_offset, staging_size;
 		uploadpass_executable uploadTextureExecutable;
 		uint64_t size, offset;
 		void* data;
 		uint8_t mipmap;
 		uint8_t slice;
+		uint8_t mipCount;
+		uint8_t sliceCount;
 	};
 
 	struct CompiledRenderGraph
@@ -71,10 +178,33 @@ namespace HGEGraphics
 		CompiledRenderGraph(std::pmr::memory_resource* const memory_resource);
 		std::pmr::vector<CompiledResourceNode> resources;
 		std::pmr::vector<CompiledRenderPassNode> passes;
+		std::pmr::vector<CompiledAliasBlock> aliasBlocks;
+		std::pmr::vector<CompiledBarrier> barriers;
+		std::pmr::vector<CompiledExitState> exitStates;
+		std::pmr::vector<ECGPUResourceState> states;
+		std::pmr::vector<CompiledQueueBatch> batches;
+		TransientMemoryStats transientMemory;
+		ScheduleStats schedule;
+		RenderPassMergeStats merge;
+		AttachmentActionStats attachmentActions;
+	};
+
+	struct CompileCache
+	{
+		CompileCache(std::pmr::memory_resource* const memory_resource);
+
+		std::pmr::unsynchronized_pool_resource memory_resource;
+		std::pmr::vector<uint32_t> signature;
+		std::pmr::vector<uint32_t> pending_signature;
+		uint32_t hash{ 0 };
+		std::optional<CompiledRenderGraph> compiled;
+		uint64_t hits{ 0 };
+		uint64_t misses{ 0 };
 	};
 
 	struct Compiler
 	{
 		static CompiledRenderGraph Compile(const rendergraph_t& renderGraph, std::pmr::memory_resource* const memory_resource);
+		static CompiledRenderGraph& Compile(const rendergraph_t& renderGraph, CompileCache& cache);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "rendergraph_compiler.h"
+#include <ostream>
+
+namespace HGEGraphics
+{
+	void rendergraph_export_json(const rendergraph_t& renderGraph, const CompiledRenderGraph& compiled, std::ostream& out);
+	void rendergraph_export_graphviz(const rendergraph_t& renderGraph, const CompiledRenderGraph& compiled, std::ostream& out, const char* name = nullptr);
+}
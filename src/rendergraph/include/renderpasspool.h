@@ -39,6 +39,7 @@ namespace HGEGraphics
 		RenerPassPool(CGPUDeviceId device, std::pmr::memory_resource* const memory_resource);
 
 		RenderPass* getRenderPass(const CGPURenderPassDescriptor& descriptor);
+		RenderPass* prewarm(const CGPURenderPassDescriptor& descriptor);
 
 	protected:
 		// ͨ ResourcePool ̳
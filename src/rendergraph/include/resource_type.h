@@ -16,4 +16,11 @@ namespace HGEGraphics
 	{
 		index_type_t index;
 	};
+
+	struct constant_range_t
+	{
+		buffer_handle_t buffer;
+		uint32_t offset;
+		uint32_t size;
+	};
 }
\ No newline at end of file
@@ -1,40 +1,78 @@
 #pragma once
 
-#include <unordered_map>
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <memory_resource>
+#include <vector>
 
 namespace HGEGraphics
 {
+	struct ResourcePoolStats
+	{
+		uint32_t hits;
+		uint32_t misses;
+		uint32_t creations;
+		uint32_t evictions;
+		uint64_t retained_bytes;
+	};
+
+	// shared by the texture and buffer pools of a device, while it is exceeded they also evict what was not used in their last frame
+	struct PoolBudget
+	{
+		uint64_t budget_bytes{ UINT64_MAX };
+		std::atomic<uint64_t> used_bytes{ 0 };
+
+		bool exceeded() const { return used_bytes.load(std::memory_order_relaxed) > budget_bytes; }
+	};
+
 	template<typename ResourceDescriptor, typename ResourceType, bool neverRelease, bool destroyOutOfDate, class ResourceDescriptorHasher = std::hash<ResourceDescriptor>, class ResourceDescriptorEq = std::equal_to<ResourceDescriptor>>
 	class ResourcePool
 	{
 		using ThisType = ResourcePool<ResourceDescriptor, ResourceType, neverRelease, destroyOutOfDate, ResourceDescriptorHasher, ResourceDescriptorEq>;
-		using MapType = std::pmr::unordered_multimap<ResourceDescriptor, std::pair<ResourceType*, uint64_t>, ResourceDescriptorHasher, ResourceDescriptorEq>;
+
+		static constexpr uint32_t NIL = UINT32_MAX;
+
+		// entries also form a list ordered by the frame they were last used in, oldest first
+		struct Entry
+		{
+			ResourceDescriptor descriptor;
+			ResourceType* resource;
+			uint64_t timestamp;
+			uint32_t hash;
+			uint32_t prev;
+			uint32_t next;
+			// prewarmed and not used yet, kept however long the first use takes
+			bool pinned;
+		};
+
+		// linear probing over entry indices, a slot with entry NIL is empty
+		struct Slot
+		{
+			uint32_t hash;
+			uint32_t entry;
+		};
 
 	public:
 		ResourcePool() = default;
 		ResourcePool(uint64_t frame_before_out_of_data, ThisType* upstream, std::pmr::memory_resource* const memory_resource)
-			: m_upstream(upstream), m_resources(memory_resource), frame_before_out_of_data(frame_before_out_of_data)
+			: m_upstream(upstream), frame_before_out_of_data(frame_before_out_of_data), m_entries(memory_resource), m_slots(memory_resource)
 		{
 		}
 
 		void destroy()
 		{
-			if (m_upstream)
-			{
-				for (auto& [key, resource] : m_resources)
-				{
-					m_upstream->releaseResource(resource.first);
-				}
-			}
-			else
+			for (auto i = m_oldest; i != NIL; i = m_entries[i].next)
 			{
-				for (auto& [key, resource] : m_resources)
-				{
-					destroyResource_impl(resource.first);
-				}
+				if (m_upstream)
+					m_upstream->releaseResource(m_entries[i].resource);
+				else
+					destroyResource(m_entries[i].resource);
 			}
-			m_resources.clear();
+			m_entries.clear();
+			m_slots.clear();
+			m_oldest = m_newest = m_free = NIL;
+			m_count = 0;
 		}
 
 		virtual ~ResourcePool()
@@ -44,63 +82,254 @@ namespace HGEGraphics
 		void newFrame()
 		{
 			++timestamp;
+			m_lastStats = m_stats;
+			m_lastStats.retained_bytes = m_retainedBytes;
+			m_stats = {};
 
 			if constexpr (destroyOutOfDate)
 			{
-				std::erase_if(m_resources, [this](auto& kv) -> bool 
+				while (m_oldest != NIL && timestamp > m_entries[m_oldest].timestamp + frame_before_out_of_data)
 				{
-					bool out_of_date = timestamp > kv.second.second + frame_before_out_of_data;
-					if (out_of_date)
-					{
-						destroyResource_impl(kv.second.first);
-					}
-					return out_of_date;
-				});
+					if (m_entries[m_oldest].pinned)
+						touch(m_oldest);
+					else
+						evict(m_oldest);
+				}
+
+				// only entries that hold memory can bring the budget down, the rest keep their normal lifetime
+				for (auto i = m_oldest; i != NIL && m_budget && m_budget->exceeded() && timestamp > m_entries[i].timestamp + 1;)
+				{
+					auto next = m_entries[i].next;
+					if (resourceBytes_impl(m_entries[i].resource) > 0)
+						evict(i);
+					i = next;
+				}
 			}
 		}
 
 		ResourceType* getResource(const ResourceDescriptor& descriptor)
 		{
-			auto iter = m_resources.find(descriptor);
-			if (iter != m_resources.end())
+			uint32_t hash = (uint32_t)ResourceDescriptorHasher()(descriptor);
+			auto index = find(descriptor, hash);
+			if (index != NIL)
 			{
-				auto& resourceNode = iter->second;
-				auto resource = resourceNode.first;
+				++m_stats.hits;
+				auto resource = m_entries[index].resource;
 				if constexpr (!neverRelease)
-					m_resources.erase(iter);
+					erase(index);
 				else
 				{
-					resourceNode.second = timestamp;
+					m_entries[index].pinned = false;
+					touch(index);
 				}
 				return resource;
 			}
 
+			++m_stats.misses;
 			if (m_upstream)
 				return m_upstream->getResource(descriptor);
 			else
 			{
 				auto res = getResource_impl(descriptor);
+				auto bytes = resourceBytes_impl(res);
+				++m_stats.creations;
+				m_retainedBytes += bytes;
+				if (m_budget)
+					m_budget->used_bytes += bytes;
 				if constexpr (neverRelease)
-					m_resources.insert({ descriptor, {res, timestamp} });
+					insert(keptDescriptor_impl(descriptor, res), hash, res);
 				return res;
 			}
 		}
+		// drops a cached resource before it ages out, it is destroyed like an evicted one
+		void evictResource(const ResourceDescriptor& descriptor)
+		{
+			static_assert(neverRelease, "released resources are only cached until handed out again");
+			auto index = find(descriptor, (uint32_t)ResourceDescriptorHasher()(descriptor));
+			if (index != NIL)
+				evict(index);
+		}
+
+		// creates a resource ahead of its first getResource, which may come later than frame_before_out_of_data frames
+		ResourceType* prewarmResource(const ResourceDescriptor& descriptor)
+		{
+			static_assert(neverRelease, "only pools keeping what they hand out can hold a resource for later");
+			uint32_t hash = (uint32_t)ResourceDescriptorHasher()(descriptor);
+			auto index = find(descriptor, hash);
+			if (index != NIL)
+				return m_entries[index].resource;
+			if (m_upstream)
+				return m_upstream->prewarmResource(descriptor);
+
+			auto resource = getResource(descriptor);
+			m_entries[find(descriptor, hash)].pinned = true;
+			return resource;
+		}
+
 		void releaseResource(ResourceType* resource)
 		{
 			if constexpr (!neverRelease)
-				m_resources.insert({ resource->descriptor(), {resource, timestamp} });
+			{
+				auto descriptor = resource->descriptor();
+				insert(descriptor, (uint32_t)ResourceDescriptorHasher()(descriptor), resource);
+			}
 		}
 
 		ThisType* upstream() const { return m_upstream; }
+		void setBudget(PoolBudget* budget) { m_budget = budget; }
+		// counters of the last finished frame, retained bytes cover everything the pool created and still owns
+		const ResourcePoolStats& stats() const { return m_lastStats; }
 
 	protected:
 		virtual ResourceType* getResource_impl(const ResourceDescriptor& descriptor) = 0;
 		virtual void destroyResource_impl(ResourceType* resource) = 0;
+		virtual uint64_t resourceBytes_impl(const ResourceType*) const { return 0; }
+		// the descriptor a cached resource is found by, for descriptors referring to memory of the caller
+		virtual ResourceDescriptor keptDescriptor_impl(const ResourceDescriptor& descriptor, const ResourceType*) const { return descriptor; }
+
+	private:
+		void evict(uint32_t index)
+		{
+			auto resource = m_entries[index].resource;
+			erase(index);
+			destroyResource(resource);
+			++m_stats.evictions;
+		}
+
+		void destroyResource(ResourceType* resource)
+		{
+			auto bytes = resourceBytes_impl(resource);
+			m_retainedBytes -= bytes;
+			if (m_budget)
+				m_budget->used_bytes -= bytes;
+			destroyResource_impl(resource);
+		}
+
+		uint32_t find(const ResourceDescriptor& descriptor, uint32_t hash) const
+		{
+			if (m_slots.empty())
+				return NIL;
+			uint32_t mask = (uint32_t)m_slots.size() - 1;
+			for (uint32_t i = hash & mask; m_slots[i].entry != NIL; i = (i + 1) & mask)
+			{
+				if (m_slots[i].hash == hash && ResourceDescriptorEq()(m_entries[m_slots[i].entry].descriptor, descriptor))
+					return m_slots[i].entry;
+			}
+			return NIL;
+		}
+
+		void insert(const ResourceDescriptor& descriptor, uint32_t hash, ResourceType* resource)
+		{
+			// kept at most half full so probe sequences stay short
+			if ((m_count + 1) * 2 > m_slots.size())
+				rehash(std::max<size_t>(m_slots.size() * 2, 16));
+
+			uint32_t index;
+			if (m_free != NIL)
+			{
+				index = m_free;
+				m_free = m_entries[index].next;
+				m_entries[index] = { descriptor, resource, timestamp, hash, NIL, NIL, false };
+			}
+			else
+			{
+				index = (uint32_t)m_entries.size();
+				m_entries.push_back({ descriptor, resource, timestamp, hash, NIL, NIL, false });
+			}
+			link(index);
+			place(hash, index);
+			++m_count;
+		}
+
+		void erase(uint32_t index)
+		{
+			uint32_t mask = (uint32_t)m_slots.size() - 1;
+			uint32_t i = m_entries[index].hash & mask;
+			while (m_slots[i].entry != index)
+				i = (i + 1) & mask;
+
+			// shift later members of the probe sequence back instead of leaving a tombstone
+			for (uint32_t j = (i + 1) & mask; m_slots[j].entry != NIL; j = (j + 1) & mask)
+			{
+				uint32_t home = m_slots[j].hash & mask;
+				if (((j - home) & mask) >= ((j - i) & mask))
+				{
+					m_slots[i] = m_slots[j];
+					i = j;
+				}
+			}
+			m_slots[i].entry = NIL;
+
+			unlink(index);
+			m_entries[index].resource = nullptr;
+			m_entries[index].next = m_free;
+			m_free = index;
+			--m_count;
+		}
+
+		void place(uint32_t hash, uint32_t index)
+		{
+			uint32_t mask = (uint32_t)m_slots.size() - 1;
+			uint32_t i = hash & mask;
+			while (m_slots[i].entry != NIL)
+				i = (i + 1) & mask;
+			m_slots[i] = { hash, index };
+		}
+
+		void rehash(size_t size)
+		{
+			m_slots.assign(size, { 0, NIL });
+			for (auto i = m_oldest; i != NIL; i = m_entries[i].next)
+				place(m_entries[i].hash, i);
+		}
+
+		void touch(uint32_t index)
+		{
+			m_entries[index].timestamp = timestamp;
+			unlink(index);
+			link(index);
+		}
+
+		void link(uint32_t index)
+		{
+			auto& entry = m_entries[index];
+			entry.prev = m_newest;
+			entry.next = NIL;
+			if (m_newest != NIL)
+				m_entries[m_newest].next = index;
+			else
+				m_oldest = index;
+			m_newest = index;
+		}
+
+		void unlink(uint32_t index)
+		{
+			auto& entry = m_entries[index];
+			if (entry.prev != NIL)
+				m_entries[entry.prev].next = entry.next;
+			else
+				m_oldest = entry.next;
+			if (entry.next != NIL)
+				m_entries[entry.next].prev = entry.prev;
+			else
+				m_newest = entry.prev;
+		}
 
 	protected:
-		MapType m_resources;
 		ThisType* m_upstream = nullptr;
 		uint64_t timestamp = { 0 };
 		uint64_t frame_before_out_of_data = { 10 };
+
+	private:
+		std::pmr::vector<Entry> m_entries;
+		std::pmr::vector<Slot> m_slots;
+		uint32_t m_oldest = NIL;
+		uint32_t m_newest = NIL;
+		uint32_t m_free = NIL;
+		uint32_t m_count = 0;
+		PoolBudget* m_budget = nullptr;
+		uint64_t m_retainedBytes = 0;
+		ResourcePoolStats m_stats = {};
+		ResourcePoolStats m_lastStats = {};
 	};
 }
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "cgpu/api.h"
+#include <vector>
+
+namespace HGEGraphics
+{
+	// run-length encoded states of a texture's subresources, indexed by mip + slice * mipCount
+	// a texture in a single state, the common case, keeps its one run inline
+	class SubresourceStates
+	{
+	public:
+		struct Run
+		{
+			uint32_t begin;
+			uint32_t end;
+			ECGPUResourceState state;
+		};
+
+		void reset(uint32_t count, ECGPUResourceState state);
+		void clear();
+		void set(uint32_t begin, uint32_t end, ECGPUResourceState state);
+		ECGPUResourceState get(uint32_t index) const;
+
+		uint32_t size() const { return count; }
+		bool uniform() const { return runCount <= 1; }
+		uint32_t runs() const { return runCount; }
+		const Run& run(uint32_t index) const { return data()[index]; }
+
+	private:
+		static constexpr uint32_t inlineCapacity = 4;
+
+		const Run* data() const { return spilled.empty() ? inlineRuns : spilled.data(); }
+		void store(const Run* runs, uint32_t size);
+
+		uint32_t count = 0;
+		uint32_t runCount = 0;
+		Run inlineRuns[inlineCapacity] = {};
+		std::vector<Run> spilled;
+	};
+}
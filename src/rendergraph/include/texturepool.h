@@ -12,7 +12,11 @@ namespace HGEGraphics
 		uint16_t height = 0;
 		uint16_t depth = 0;
 		uint16_t mipLevels = 0;
+		uint16_t arraySize = 0;
+		uint16_t sampleCount = 0;
 		ECGPUFormat format = CGPU_FORMAT_UNDEFINED;
+		// descriptors on top of the sampled and attachment ones
+		CGPUResourceTypes usage = CGPU_RESOURCE_TYPE_NONE;
 
 		bool operator==(const TextureDescriptor& other) const;
 	};
@@ -24,6 +28,9 @@ namespace HGEGraphics
 		}
 	};
 
+	// rounds an extent up to its size bucket, at most an eighth larger, so nearby sizes share pooled textures
+	uint16_t texture_bucket_extent(uint16_t extent);
+
 	struct Texture;
 	struct TextureWrap
 	{
@@ -41,7 +48,7 @@ namespace HGEGraphics
 	public:
 		TexturePool(TexturePool* upstream, std::pmr::memory_resource* const memory_resource);
 
-		TextureWrap* getTexture(uint16_t width, uint16_t height, uint16_t depth, ECGPUFormat format);
+		TextureWrap* getTexture(const TextureDescriptor& descriptor);
 	};
 
 	class CgpuTexturePool
@@ -53,6 +60,7 @@ namespace HGEGraphics
 	protected:
 		TextureWrap* getResource_impl(const TextureDescriptor& descriptor) override;
 		void destroyResource_impl(TextureWrap* resource) override;
+		uint64_t resourceBytes_impl(const TextureWrap* resource) const override;
 
 	private:
 		CGPUDeviceId device;
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <vector>
+#include <memory_resource>
+
+namespace HGEGraphics
+{
+	class WorkerPool
+	{
+	public:
+		WorkerPool(uint32_t threadCount, std::pmr::memory_resource* memory_resource);
+		~WorkerPool();
+
+		// worker 0 is the thread calling run, spawned threads are numbered from 1
+		uint32_t workerCount() const { return (uint32_t)threads.size() + 1; }
+		void run(uint32_t count, const std::function<void(uint32_t index, uint32_t worker)>& func);
+		// work nobody waits for, only spawned threads take it and only while no run is pending
+		void post(std::function<void(uint32_t worker)> func);
+
+	private:
+		struct Task
+		{
+			std::function<void(uint32_t worker)> func;
+			uint32_t* remaining;
+		};
+
+		void loop(uint32_t worker);
+		void execute(std::unique_lock<std::mutex>& lock, uint32_t worker);
+
+		std::pmr::vector<std::thread> threads;
+		std::pmr::deque<Task> tasks;
+		std::pmr::deque<Task> background;
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::condition_variable done;
+		bool stopping = false;
+	};
+}
@@ -0,0 +1,65 @@
+#include "bindlessheap.h"
+
+#include <algorithm>
+#include "renderer.h"
+
+namespace HGEGraphics
+{
+	BindlessHeap::BindlessHeap(std::pmr::memory_resource* const memory_resource)
+		: slots(memory_resource), free_slots(memory_resource)
+	{
+	}
+
+	bool BindlessHeap::init(CGPUDeviceId device, uint32_t capacity)
+	{
+		auto adapter_detail = cgpu_query_adapter_detail(device->adapter);
+		if (!adapter_detail->support_descriptor_indexing || capacity == 0)
+			return false;
+		if (adapter_detail->max_descriptor_count > 0)
+			capacity = std::min(capacity, adapter_detail->max_descriptor_count);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		slots.assign(capacity, nullptr);
+		free_slots.resize(capacity);
+		// handed out from the back, so the lowest slots are used first
+		for (uint32_t i = 0; i < capacity; ++i)
+			free_slots[i] = capacity - 1 - i;
+		++contentVersion;
+		return true;
+	}
+
+	uint32_t BindlessHeap::allocate(Texture* texture)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (texture->bindless_index == invalid_index && !free_slots.empty())
+		{
+			texture->bindless_index = free_slots.back();
+			free_slots.pop_back();
+			slots[texture->bindless_index] = texture;
+			++contentVersion;
+		}
+		return texture->bindless_index;
+	}
+
+	void BindlessHeap::release(Texture* texture)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (texture->bindless_index == invalid_index)
+			return;
+		slots[texture->bindless_index] = nullptr;
+		free_slots.push_back(texture->bindless_index);
+		texture->bindless_index = invalid_index;
+		++contentVersion;
+	}
+
+	void BindlessHeap::fill(CGPUTextureViewId fallback, CGPUTextureViewId* views, uint32_t count) const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		count = std::min(count, (uint32_t)slots.size());
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			auto texture = slots[i];
+			views[i] = texture && texture->prepared && texture->view ? texture->view : fallback;
+		}
+	}
+}
@@ -0,0 +1,72 @@
+#include "bufferarena.h"
+
+#include <cassert>
+#include <algorithm>
+#include "renderer.h"
+#include "rendergraph.h"
+
+namespace HGEGraphics
+{
+	BufferArena::BufferArena(CGPUDeviceId device, const char8_t* name, CGPUResourceTypes descriptors, ECGPUMemoryUsage usage, ECGPUResourceState state, uint64_t alignment, uint64_t blockSize, std::pmr::memory_resource* memory_resource)
+		: device(device), name(name), descriptors(descriptors), usage(usage), state(state), alignment(std::max<uint64_t>(alignment, 16)), blockSize(blockSize), cursor(0), blocks(memory_resource)
+	{
+	}
+
+	BufferArena::Block BufferArena::createBlock(uint64_t size)
+	{
+		CGPUBufferDescriptor desc = {};
+		desc.name = name;
+		desc.flags = CGPU_BCF_PERSISTENT_MAP_BIT;
+		desc.descriptors = descriptors;
+		desc.memory_usage = usage;
+		desc.start_state = state;
+		desc.size = size;
+		auto buffer = create_buffer(device, desc);
+		buffer->cur_state = state;
+		assert(buffer->handle->info->cpu_mapped_address);
+		return { buffer, (uint8_t*)buffer->handle->info->cpu_mapped_address, size, {} };
+	}
+
+	BufferArena::Allocation BufferArena::allocate(rendergraph_t* rg, uint64_t size)
+	{
+		uint64_t offset = (cursor + alignment - 1) / alignment * alignment;
+		if (blocks.empty() || offset + size > blocks.back().size)
+		{
+			uint64_t newSize = blocks.empty() ? blockSize : blocks.back().size * 2;
+			blocks.push_back(createBlock(std::max<uint64_t>(newSize, size)));
+			offset = 0;
+		}
+
+		auto& block = blocks.back();
+		cursor = offset + size;
+		if (!rendergraph_buffer_handle_valid(block.handle))
+			block.handle = rendergraph_import_buffer(rg, block.buffer);
+		return { block.handle, offset, block.mapped + offset };
+	}
+
+	void BufferArena::newFrame()
+	{
+		cursor = 0;
+		if (blocks.size() > 1)
+		{
+			uint64_t total = 0;
+			for (auto& block : blocks)
+			{
+				total += block.size;
+				free_buffer(block.buffer);
+			}
+			blocks.clear();
+			blockSize = total;
+		}
+		for (auto& block : blocks)
+			block.handle = {};
+	}
+
+	void BufferArena::destroy()
+	{
+		for (auto& block : blocks)
+			free_buffer(block.buffer);
+		blocks.clear();
+		cursor = 0;
+	}
+}
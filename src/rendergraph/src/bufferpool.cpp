@@ -1,4 +1,5 @@
 #include "bufferpool.h"
+#include "renderer.h"
 
 namespace HGEGraphics
 {
@@ -15,9 +16,14 @@ namespace HGEGraphics
 		buffer->cur_state = CGPU_RESOURCE_STATE_UNDEFINED;
 		return buffer;
 	}
+	uint64_t BufferPool::resourceBytes_impl(const BufferWrap* resource) const
+	{
+		return resource->handle->info->size;
+	}
 	void BufferPool::destroyResource_impl(BufferWrap* resource)
 	{
 		cgpu_free_buffer(resource->handle);
+		invalidate_resource_bindings(resource->handle);
 		allocator.delete_object(resource);
 	}
 }
\ No newline at end of file
@@ -1,11 +1,12 @@
 #include "computepipelinepool.h"
 
 #include "renderer.h"
+#include "pipelinecache.h"
 
 namespace HGEGraphics
 {
 	ComputePipelinePool::ComputePipelinePool(CGPUDeviceId device, ComputePipelinePool* upstream, std::pmr::memory_resource* const memory_resource)
-		: device(device), ResourcePool(12, upstream, memory_resource), allocator(memory_resource)
+		: ResourcePool(12, upstream, memory_resource), device(device), allocator(memory_resource)
 	{
 	}
 
@@ -18,6 +19,15 @@ namespace HGEGraphics
 		return getResource(key);
 	}
 
+	ComputePipeline* ComputePipelinePool::prewarm(ComputeShader* shader)
+	{
+		auto key = CPSOKey
+		{
+			.shader = shader,
+		};
+		return prewarmResource(key);
+	}
+
 	ComputePipeline* ComputePipelinePool::getResource_impl(const CPSOKey& key)
 	{
 		CGPUComputePipelineDescriptor cp_desc = {
@@ -25,6 +35,8 @@ namespace HGEGraphics
 			.compute_shader = &key.shader->cs,
 		};
 		auto handle = cgpu_create_compute_pipeline(device, &cp_desc);
+		if (pipeline_cache)
+			pipeline_cache->record(ComputePipelineRecord{ key.shader->hash });
 
 		auto pipeline = allocator.new_object<ComputePipeline>();
 		pipeline->handle = handle;
@@ -1,26 +1,187 @@
 #include "descriptorsetpool.h"
 
+#include <algorithm>
+#include <cassert>
+
 namespace HGEGraphics
 {
+	static std::mutex freed_registry_mutex;
+	static std::vector<DescriptorSetPool::FreedResources*> freed_registry;
+
+	void invalidate_resource_bindings(const void* resource)
+	{
+		std::lock_guard<std::mutex> lock(freed_registry_mutex);
+		for (auto freed : freed_registry)
+		{
+			std::lock_guard<std::mutex> freed_lock(freed->mutex);
+			freed->resources.push_back(resource);
+			freed->pending.store(true, std::memory_order_release);
+		}
+	}
+
+	uint64_t hash_descriptor_bindings(const DescriptorBinding* bindings, uint32_t count)
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			auto& binding = bindings[i];
+			hash = fnv1a64(&binding.resource, sizeof(binding.resource), hash);
+			hash = fnv1a64(&binding.offset, sizeof(binding.offset), hash);
+			hash = fnv1a64(&binding.size, sizeof(binding.size), hash);
+			hash = fnv1a64(&binding.binding, sizeof(binding.binding), hash);
+			hash = fnv1a64(&binding.type, sizeof(binding.type), hash);
+		}
+		return hash;
+	}
+
 	DescriptorSetPool::DescriptorSetPool(CGPUDeviceId device, std::pmr::memory_resource* const memory_resource)
-		: ResourcePool(10, nullptr, memory_resource), device(device), allocator(memory_resource)
+		: ResourcePool(3, nullptr, memory_resource), device(device), allocator(memory_resource), free_sets(memory_resource), sets_by_resource(memory_resource)
 	{
+		freed = new FreedResources();
+		std::lock_guard<std::mutex> lock(freed_registry_mutex);
+		freed_registry.push_back(freed);
 	}
-	DescriptorSet* DescriptorSetPool::getDescriptorSet(const CGPUDescriptorSetDescriptor& descriptor)
+	DescriptorSet* DescriptorSetPool::getDescriptorSet(const DescriptorSetKey& key, bool& written)
 	{
-		return getResource(descriptor);
+		// sets dropped while recording may already be bound in this frame, they are not rewritten before the next one
+		retiring = true;
+		dropFreedBindings();
+		retiring = false;
+		created = false;
+		auto descriptorSet = getResource(key);
+		written = !created;
+		return descriptorSet;
+	}
+	void DescriptorSetPool::newFrame()
+	{
+		dropFreedBindings();
+		ResourcePool::newFrame();
+
+		for (auto& [layout, sets] : free_sets)
+		{
+			std::erase_if(sets, [this](const FreeSet& free)
+				{
+					if (timestamp <= free.freed + frame_before_out_of_data)
+						return false;
+					freeSet(free.set->handle);
+					allocator.delete_object(free.set);
+					return true;
+				});
+		}
+	}
+	void DescriptorSetPool::destroy()
+	{
+		if (freed)
+		{
+			{
+				std::lock_guard<std::mutex> lock(freed_registry_mutex);
+				std::erase(freed_registry, freed);
+			}
+			delete freed;
+			freed = nullptr;
+		}
+
+		ResourcePool::destroy();
+		for (auto& [layout, sets] : free_sets)
+		{
+			for (auto& free : sets)
+			{
+				freeSet(free.set->handle);
+				allocator.delete_object(free.set);
+			}
+		}
+		free_sets.clear();
 	}
-	DescriptorSet* DescriptorSetPool::getResource_impl(const CGPUDescriptorSetDescriptor& descriptor)
+	uint64_t DescriptorSetPool::layoutOf(const DescriptorSetKey& key)
 	{
-		auto handle = cgpu_create_descriptor_set(device, &descriptor);
-		auto descriptorSet = allocator.new_object<DescriptorSet>();
-		descriptorSet->_descriptor = descriptor;
-		descriptorSet->handle = handle;
+		assert(key.set_index < 8);
+		return (uint64_t)(uintptr_t)key.root_signature * 8 + key.set_index;
+	}
+	void DescriptorSetPool::dropFreedBindings()
+	{
+		if (!freed || !freed->pending.load(std::memory_order_acquire))
+			return;
+
+		std::vector<const void*> resources;
+		{
+			std::lock_guard<std::mutex> lock(freed->mutex);
+			resources.swap(freed->resources);
+			freed->pending.store(false, std::memory_order_relaxed);
+		}
+
+		std::pmr::vector<DescriptorSet*> stale(allocator);
+		for (auto resource : resources)
+		{
+			auto [begin, end] = sets_by_resource.equal_range(resource);
+			for (auto it = begin; it != end; ++it)
+				stale.push_back(it->second);
+		}
+		// a set may hold the same resource in several bindings
+		std::sort(stale.begin(), stale.end());
+		stale.erase(std::unique(stale.begin(), stale.end()), stale.end());
+		for (auto set : stale)
+			evictResource(set->_descriptor);
+	}
+	DescriptorSet* DescriptorSetPool::getResource_impl(const DescriptorSetKey& key)
+	{
+		created = true;
+		DescriptorSet* descriptorSet;
+		auto& sets = free_sets[layoutOf(key)];
+		if (!sets.empty() && sets.back().freed <= timestamp)
+		{
+			descriptorSet = sets.back().set;
+			sets.pop_back();
+		}
+		else
+		{
+			descriptorSet = allocator.new_object<DescriptorSet>();
+			descriptorSet->handle = createSet(key);
+		}
+
+		descriptorSet->bindings.assign(key.bindings, key.bindings + key.binding_count);
+		descriptorSet->_descriptor = key;
+		descriptorSet->_descriptor.bindings = descriptorSet->bindings.data();
+		for (auto& binding : descriptorSet->bindings)
+			sets_by_resource.emplace(binding.resource, descriptorSet);
 		return descriptorSet;
 	}
 	void DescriptorSetPool::destroyResource_impl(DescriptorSet* resource)
 	{
-		cgpu_free_descriptor_set(resource->handle);
-		allocator.delete_object(resource);
+		for (auto& binding : resource->bindings)
+		{
+			auto [begin, end] = sets_by_resource.equal_range(binding.resource);
+			for (auto it = begin; it != end; ++it)
+			{
+				if (it->second == resource)
+				{
+					sets_by_resource.erase(it);
+					break;
+				}
+			}
+		}
+
+		// evicted sets are only rewritten, never while a frame using them can still be in flight
+		auto& sets = free_sets[layoutOf(resource->_descriptor)];
+		if (retiring)
+			sets.insert(sets.begin(), { resource, timestamp + 1 });
+		else
+			sets.push_back({ resource, timestamp });
+	}
+	DescriptorSetKey DescriptorSetPool::keptDescriptor_impl(const DescriptorSetKey&, const DescriptorSet* resource) const
+	{
+		return resource->_descriptor;
+	}
+	CGPUDescriptorSetId DescriptorSetPool::createSet(const DescriptorSetKey& key)
+	{
+		CGPUDescriptorSetDescriptor descriptor =
+		{
+			.root_signature = key.root_signature,
+			.set_index = key.set_index,
+		};
+		return cgpu_create_descriptor_set(device, &descriptor);
+	}
+	void DescriptorSetPool::freeSet(CGPUDescriptorSetId set)
+	{
+		cgpu_free_descriptor_set(set);
 	}
-}
\ No newline at end of file
+}
@@ -1,11 +1,14 @@
 #include "graphicspipelinepool.h"
 
 #include "renderer.h"
+#include "pipelinecache.h"
+#include "workerpool.h"
+#include <cassert>
 
 namespace HGEGraphics
 {
 	GraphicsPipelinePool::GraphicsPipelinePool(CGPUDeviceId device, GraphicsPipelinePool* upstream, std::pmr::memory_resource* const memory_resource)
-		: device(device), ResourcePool(12, upstream, memory_resource), allocator(memory_resource)
+		: ResourcePool(12, upstream, memory_resource), device(device), allocator(memory_resource)
 	{
 		if (device)
 		{
@@ -18,61 +21,118 @@ namespace HGEGraphics
 	}
 	GraphicsPipeline* GraphicsPipelinePool::getGraphicsPipeline(RenderPassEncoder* encoder, Shader* shader, Mesh* mesh)
     {
-		return getGraphicsPipeline(encoder, shader, mesh->prim_topology, mesh->vertex_layout);
+		return getGraphicsPipeline(encoder, shader, mesh->prim_topology, mesh->vertex_layout, mesh->vertex_layout_id);
 	}
 
-	GraphicsPipeline* GraphicsPipelinePool::getGraphicsPipeline(RenderPassEncoder* encoder, Shader* shader, ECGPUPrimitiveTopology prim_topology, const CGPUVertexLayout& vertex_layout)
+	GraphicsPipeline* GraphicsPipelinePool::getGraphicsPipeline(RenderPassEncoder* encoder, Shader* shader, ECGPUPrimitiveTopology prim_topology, const CGPUVertexLayout& vertex_layout, uint64_t vertex_layout_id)
 	{
 		auto key = PSOKey
 		{
 			.shader = shader,
-			.vertex_layout = vertex_layout,
-			.prim_topology = prim_topology,
-			.blend_desc = shader->blend_desc,
-			.depth_desc = shader->depth_desc,
-			.rasterizer_state = shader->rasterizer_state,
+			.vertex_layout_id = vertex_layout_id,
 			.render_pass = encoder->render_pass,
 			.subpass = encoder->subpass,
 			.render_target_count = encoder->render_target_count,
+			.prim_topology = dynamicStateT1Enabled() ? (ECGPUPrimitiveTopology)0 : prim_topology,
 		};
-		if (dynamicStateT1Enabled())
-		{
-			key.prim_topology = (ECGPUPrimitiveTopology)0;
-			key.rasterizer_state.cull_mode = (ECGPUCullMode)0;
-			key.rasterizer_state.front_face = (ECGPUFrontFace)0;
-			key.depth_desc.depth_test = false;
-			key.depth_desc.depth_write = false;
-			key.depth_desc.depth_func = (ECGPUCompareMode)0;
-		}
-		return getResource(key);
+		return getGraphicsPipeline(key, &vertex_layout, encoder->render_pass_desc);
 	}
 
-	GraphicsPipeline* GraphicsPipelinePool::getResource_impl(const PSOKey& key)
+	GraphicsPipeline* GraphicsPipelinePool::prewarm(const PSOKey& key, const CGPUVertexLayout& vertex_layout, const CGPURenderPassDescriptor& render_pass)
+	{
+		creating_vertex_layout = &vertex_layout;
+		creating_render_pass = &render_pass;
+		auto pipeline = prewarmResource(key);
+		creating_vertex_layout = nullptr;
+		creating_render_pass = nullptr;
+		return pipeline;
+	}
+
+	GraphicsPipeline* GraphicsPipelinePool::getGraphicsPipeline(const PSOKey& key, const CGPUVertexLayout* vertex_layout, const CGPURenderPassDescriptor* render_pass)
+	{
+		creating_vertex_layout = vertex_layout;
+		creating_render_pass = render_pass;
+		auto pipeline = getResource(key);
+		creating_vertex_layout = nullptr;
+		creating_render_pass = nullptr;
+		return pipeline;
+	}
+
+	CGPURenderPipelineId GraphicsPipelinePool::createPipeline(const PSOKey& key, const CGPUVertexLayout& vertex_layout)
 	{
+		// with dynamic states the ones set here are overridden per draw
 		CGPURenderPipelineDescriptor rp_desc = {
 			.dynamic_state = _dynamic_state_features,
 			.root_signature = key.shader->root_sig,
 			.vertex_shader = &key.shader->vs,
 			.fragment_shader = &key.shader->ps,
-			.vertex_layout = &key.vertex_layout,
-			.blend_state = &key.blend_desc,
-			.depth_state = &key.depth_desc,
-			.rasterizer_state = &key.rasterizer_state,
+			.vertex_layout = &vertex_layout,
+			.blend_state = &key.shader->blend_desc,
+			.depth_state = &key.shader->depth_desc,
+			.rasterizer_state = &key.shader->rasterizer_state,
 			.render_pass = key.render_pass,
 			.subpass = key.subpass,
 			.render_target_count = key.render_target_count,
 			.prim_topology = key.prim_topology,
 		};
-		auto handle = cgpu_create_render_pipeline(device, &rp_desc);
+		return cgpu_create_render_pipeline(device, &rp_desc);
+	}
+
+	void GraphicsPipelinePool::freePipeline(CGPURenderPipelineId pipeline)
+	{
+		cgpu_free_render_pipeline(pipeline);
+	}
+
+	GraphicsPipeline* GraphicsPipelinePool::getResource_impl(const PSOKey& key)
+	{
+		assert(creating_vertex_layout);
+		if (pipeline_cache && creating_render_pass)
+		{
+			GraphicsPipelineRecord record;
+			memset(&record, 0, sizeof(record));
+			record.shader_hash = key.shader->hash;
+			record.vertex_layout = *creating_vertex_layout;
+			record.prim_topology = key.prim_topology;
+			record.blend_desc = key.shader->blend_desc;
+			record.depth_desc = key.shader->depth_desc;
+			record.rasterizer_state = key.shader->rasterizer_state;
+			record.render_pass = *creating_render_pass;
+			record.subpass = key.subpass;
+			record.render_target_count = key.render_target_count;
+			pipeline_cache->record(record);
+		}
 
 		auto pipeline = allocator.new_object<GraphicsPipeline>();
-		pipeline->handle = handle;
+		pipeline->_descriptor = key;
+		pipeline->vertex_layout = *creating_vertex_layout;
+		if (async_worker_pool)
+		{
+			pipeline->handle = CGPU_NULLPTR;
+			pipeline->ready.store(false, std::memory_order_relaxed);
+			compile_jobs->pending.fetch_add(1, std::memory_order_relaxed);
+			async_worker_pool->post([this, pipeline, jobs = compile_jobs](uint32_t)
+				{
+					auto handle = createPipeline(pipeline->_descriptor, pipeline->vertex_layout);
+					std::lock_guard<std::mutex> lock(jobs->mutex);
+					pipeline->handle = handle;
+					jobs->pending.fetch_sub(1, std::memory_order_relaxed);
+					pipeline->ready.store(true, std::memory_order_release);
+					jobs->finished.notify_all();
+				});
+		}
+		else
+			pipeline->handle = createPipeline(key, pipeline->vertex_layout);
 		return pipeline;
 	}
 
     void GraphicsPipelinePool::destroyResource_impl(GraphicsPipeline* resource)
     {
-		cgpu_free_render_pipeline(resource->handle);
+		if (!resource->ready.load(std::memory_order_acquire))
+		{
+			std::unique_lock<std::mutex> lock(compile_jobs->mutex);
+			compile_jobs->finished.wait(lock, [resource]() { return resource->ready.load(std::memory_order_acquire); });
+		}
+		freePipeline(resource->handle);
 		allocator.delete_object(resource);
     }
 }
\ No newline at end of file
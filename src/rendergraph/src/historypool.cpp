@@ -0,0 +1,109 @@
+#include "historypool.h"
+
+#include <cassert>
+#include <algorithm>
+#include "renderer.h"
+
+namespace HGEGraphics
+{
+	HistoryPool::HistoryPool(CGPUDeviceId device, uint32_t frame_before_release, std::pmr::memory_resource* const memory_resource)
+		: device(device), frame_before_release(frame_before_release), frame(1), entries(memory_resource), retired(memory_resource)
+	{
+	}
+
+	HistoryPool::Versions HistoryPool::acquire(const char8_t* name, uint16_t width, uint16_t height, ECGPUFormat format)
+	{
+		auto iter = std::find_if(entries.begin(), entries.end(), [name](const Entry& entry) { return entry.name == name; });
+		if (iter == entries.end())
+		{
+			entries.push_back({ std::pmr::u8string(name, entries.get_allocator().resource()), width, height, format, { nullptr, nullptr }, 0, false, 0 });
+			iter = entries.end() - 1;
+			createTextures(*iter);
+		}
+
+		auto& entry = *iter;
+		if (entry.lastUsed != frame)
+		{
+			bool resized = entry.width != width || entry.height != height || entry.format != format;
+			if (resized)
+			{
+				retireTextures(entry);
+				entry.width = width;
+				entry.height = height;
+				entry.format = format;
+				createTextures(entry);
+			}
+			entry.continuous = !resized && entry.lastUsed + 1 == frame;
+			entry.current ^= 1;
+			entry.lastUsed = frame;
+		}
+		assert(entry.width == width && entry.height == height && entry.format == format);
+		return { entry.textures[entry.current], entry.continuous ? entry.textures[entry.current ^ 1] : nullptr };
+	}
+
+	void HistoryPool::newFrame()
+	{
+		++frame;
+		for (auto& entry : entries)
+		{
+			if (frame - entry.lastUsed > frame_before_release)
+				retireTextures(entry);
+		}
+		std::erase_if(entries, [](const Entry& entry) { return entry.textures[0] == nullptr; });
+
+		// textures can still be read by frames in flight, so they are only freed once those are done
+		std::erase_if(retired, [this](const Retired& retired)
+		{
+			if (frame - retired.frame <= frame_before_release)
+				return false;
+			free_texture(retired.texture);
+			return true;
+		});
+	}
+
+	void HistoryPool::destroy()
+	{
+		for (auto& entry : entries)
+			retireTextures(entry);
+		entries.clear();
+		for (auto& texture : retired)
+			free_texture(texture.texture);
+		retired.clear();
+	}
+
+	void HistoryPool::createTextures(Entry& entry)
+	{
+		bool isDepth =
+			entry.format == CGPU_FORMAT_D32_SFLOAT_S8_UINT ||
+			entry.format == CGPU_FORMAT_D24_UNORM_S8_UINT ||
+			entry.format == CGPU_FORMAT_D16_UNORM_S8_UINT ||
+			entry.format == CGPU_FORMAT_D32_SFLOAT ||
+			entry.format == CGPU_FORMAT_X8_D24_UNORM ||
+			entry.format == CGPU_FORMAT_D16_UNORM;
+		CGPUTextureDescriptor desc =
+		{
+			.name = entry.name.c_str(),
+			.flags = CGPU_TCF_FORCE_2D,
+			.width = entry.width,
+			.height = entry.height,
+			.depth = 1,
+			.array_size = 1,
+			.format = entry.format,
+			.mip_levels = 1,
+			.start_state = CGPU_RESOURCE_STATE_UNDEFINED,
+			.descriptors = (CGPUResourceTypes)(CGPU_RESOURCE_TYPE_TEXTURE | (isDepth ? CGPU_RESOURCE_TYPE_DEPTH_STENCIL : CGPU_RESOURCE_TYPE_RENDER_TARGET)),
+		};
+		for (auto& texture : entry.textures)
+			texture = create_texture(device, desc);
+	}
+
+	void HistoryPool::retireTextures(Entry& entry)
+	{
+		for (auto& texture : entry.textures)
+		{
+			if (texture)
+				retired.push_back({ texture, entry.lastUsed });
+			texture = nullptr;
+		}
+	}
+}
@@ -0,0 +1,382 @@
+#include "pipelinecache.h"
+
+#include <fstream>
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include <string.h>
+#include "renderer.h"
+
+namespace HGEGraphics
+{
+	struct PipelineCacheHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t graphics_count;
+		uint32_t compute_count;
+	};
+
+	static constexpr uint32_t pipeline_cache_magic = 0x4350564f;
+	static constexpr uint32_t pipeline_cache_version = 3;
+
+	using NameTable = std::pmr::unordered_set<std::pmr::u8string>;
+
+	static const char8_t* intern_name(NameTable& names, const char8_t* name)
+	{
+		return name ? names.emplace(name).first->c_str() : nullptr;
+	}
+
+	class ManifestWriter
+	{
+	public:
+		ManifestWriter(std::ofstream& file)
+			: file(file)
+		{
+		}
+
+		template<typename T>
+		void value(const T& value)
+		{
+			// enums are written as 32 bits whatever their underlying type
+			if constexpr (std::is_enum_v<T>)
+				this->value((uint32_t)value);
+			else
+				file.write((const char*)&value, sizeof(T));
+		}
+
+		void name(const char8_t* const& name)
+		{
+			// zero marks a missing name, otherwise the length plus one
+			uint32_t length = name ? (uint32_t)strlen((const char*)name) + 1 : 0;
+			value(length);
+			if (length > 1)
+				file.write((const char*)name, length - 1);
+		}
+
+		bool count(const uint32_t& count, uint32_t)
+		{
+			value(count);
+			return true;
+		}
+
+	private:
+		std::ofstream& file;
+	};
+
+	class ManifestReader
+	{
+	public:
+		ManifestReader(std::ifstream& file, NameTable& names)
+			: file(file), names(names), buffer(names.get_allocator().resource())
+		{
+		}
+
+		template<typename T>
+		void value(T& value)
+		{
+			if constexpr (std::is_enum_v<T>)
+			{
+				uint32_t raw = 0;
+				this->value(raw);
+				value = (T)raw;
+			}
+			else
+				file.read((char*)&value, sizeof(T));
+		}
+
+		void name(const char8_t*& name)
+		{
+			uint32_t length = 0;
+			value(length);
+			if (!file || length == 0)
+			{
+				name = nullptr;
+				return;
+			}
+			buffer.resize(length - 1);
+			file.read((char*)buffer.data(), length - 1);
+			name = names.emplace(buffer).first->c_str();
+		}
+
+		bool count(uint32_t& count, uint32_t capacity)
+		{
+			value(count);
+			if (count > capacity)
+				file.setstate(std::ios::failbit);
+			return (bool)file;
+		}
+
+	private:
+		std::ifstream& file;
+		NameTable& names;
+		std::pmr::u8string buffer;
+	};
+
+	// the one place listing what a record keeps, used for both directions
+	template<typename Stream, typename Record>
+	static void transfer(Stream& stream, Record& record)
+	{
+		stream.value(record.shader_hash);
+
+		auto& layout = record.vertex_layout;
+		if (!stream.count(layout.attribute_count, (uint32_t)std::size(layout.attributes)))
+			return;
+		for (uint32_t i = 0; i < layout.attribute_count; ++i)
+		{
+			auto& attribute = layout.attributes[i];
+			stream.name(attribute.semantic_name);
+			stream.value(attribute.array_size);
+			stream.value(attribute.format);
+			stream.value(attribute.binding);
+			stream.value(attribute.offset);
+			stream.value(attribute.elem_stride);
+			stream.value(attribute.rate);
+		}
+		stream.value(record.prim_topology);
+
+		auto& blend = record.blend_desc;
+		for (size_t i = 0; i < std::size(blend.src_factors); ++i)
+		{
+			stream.value(blend.src_factors[i]);
+			stream.value(blend.dst_factors[i]);
+			stream.value(blend.src_alpha_factors[i]);
+			stream.value(blend.dst_alpha_factors[i]);
+			stream.value(blend.blend_modes[i]);
+			stream.value(blend.blend_alpha_modes[i]);
+			stream.value(blend.masks[i]);
+		}
+		stream.value(blend.alpha_to_coverage);
+		stream.value(blend.independent_blend);
+
+		auto& depth = record.depth_desc;
+		stream.value(depth.depth_test);
+		stream.value(depth.depth_write);
+		stream.value(depth.depth_func);
+		stream.value(depth.stencil_test);
+
+		auto& rasterizer = record.rasterizer_state;
+		stream.value(rasterizer.cull_mode);
+		stream.value(rasterizer.depth_bias);
+		stream.value(rasterizer.slope_scaled_depth_bias);
+		stream.value(rasterizer.fill_mode);
+		stream.value(rasterizer.front_face);
+		stream.value(rasterizer.enable_multi_sample);
+		stream.value(rasterizer.enable_scissor);
+		stream.value(rasterizer.enable_depth_clamp);
+
+		auto& render_pass = record.render_pass;
+		stream.value(render_pass.sample_count);
+		for (auto& color : render_pass.color_attachments)
+		{
+			stream.value(color.format);
+			stream.value(color.load_action);
+			stream.value(color.store_action);
+		}
+		stream.value(render_pass.depth_stencil.format);
+		stream.value(render_pass.depth_stencil.depth_load_action);
+		stream.value(render_pass.depth_stencil.depth_store_action);
+		stream.value(render_pass.depth_stencil.stencil_load_action);
+		stream.value(render_pass.depth_stencil.stencil_store_action);
+
+		stream.value(record.subpass);
+		stream.value(record.render_target_count);
+	}
+
+	static bool same_blend(const CGPUBlendStateDescriptor& a, const CGPUBlendStateDescriptor& b)
+	{
+		for (size_t i = 0; i < std::size(a.src_factors); ++i)
+		{
+			if (a.src_factors[i] != b.src_factors[i] || a.dst_factors[i] != b.dst_factors[i]
+				|| a.src_alpha_factors[i] != b.src_alpha_factors[i] || a.dst_alpha_factors[i] != b.dst_alpha_factors[i]
+				|| a.blend_modes[i] != b.blend_modes[i] || a.blend_alpha_modes[i] != b.blend_alpha_modes[i] || a.masks[i] != b.masks[i])
+				return false;
+		}
+		return a.alpha_to_coverage == b.alpha_to_coverage && a.independent_blend == b.independent_blend;
+	}
+
+	static bool same_depth(const CGPUDepthStateDesc& a, const CGPUDepthStateDesc& b)
+	{
+		return a.depth_test == b.depth_test && a.depth_write == b.depth_write && a.depth_func == b.depth_func && a.stencil_test == b.stencil_test;
+	}
+
+	static bool same_rasterizer(const CGPURasterizerStateDescriptor& a, const CGPURasterizerStateDescriptor& b)
+	{
+		return a.cull_mode == b.cull_mode && a.depth_bias == b.depth_bias && a.slope_scaled_depth_bias == b.slope_scaled_depth_bias
+			&& a.fill_mode == b.fill_mode && a.front_face == b.front_face && a.enable_multi_sample == b.enable_multi_sample
+			&& a.enable_scissor == b.enable_scissor && a.enable_depth_clamp == b.enable_depth_clamp;
+	}
+
+	static bool same_render_pass(const CGPURenderPassDescriptor& a, const CGPURenderPassDescriptor& b)
+	{
+		if (a.sample_count != b.sample_count)
+			return false;
+		for (size_t i = 0; i < std::size(a.color_attachments); ++i)
+		{
+			auto& x = a.color_attachments[i];
+			auto& y = b.color_attachments[i];
+			if (x.format != y.format || x.load_action != y.load_action || x.store_action != y.store_action)
+				return false;
+		}
+		auto& x = a.depth_stencil;
+		auto& y = b.depth_stencil;
+		return x.format == y.format && x.depth_load_action == y.depth_load_action && x.depth_store_action == y.depth_store_action
+			&& x.stencil_load_action == y.stencil_load_action && x.stencil_store_action == y.stencil_store_action;
+	}
+
+	static bool same_states(const GraphicsPipelineRecord& record, const Shader* shader)
+	{
+		return same_blend(record.blend_desc, shader->blend_desc) && same_depth(record.depth_desc, shader->depth_desc) && same_rasterizer(record.rasterizer_state, shader->rasterizer_state);
+	}
+
+	static bool same_record(const GraphicsPipelineRecord& a, const GraphicsPipelineRecord& b)
+	{
+		return a.shader_hash == b.shader_hash && a.prim_topology == b.prim_topology && a.subpass == b.subpass && a.render_target_count == b.render_target_count
+			&& same_vertex_layout(a.vertex_layout, b.vertex_layout) && same_render_pass(a.render_pass, b.render_pass)
+			&& same_blend(a.blend_desc, b.blend_desc) && same_depth(a.depth_desc, b.depth_desc) && same_rasterizer(a.rasterizer_state, b.rasterizer_state);
+	}
+
+	PipelineCache::PipelineCache(std::pmr::memory_resource* const memory_resource)
+		: names(memory_resource), graphics(memory_resource), compute(memory_resource)
+	{
+	}
+
+	bool PipelineCache::load(const char* path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+			return false;
+
+		// a manifest written by an older build is dropped
+		PipelineCacheHeader header = {};
+		if (!file.read((char*)&header, sizeof(header))
+			|| header.magic != pipeline_cache_magic
+			|| header.version != pipeline_cache_version)
+			return false;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		ManifestReader reader(file, names);
+		graphics.resize(header.graphics_count);
+		for (auto& record : graphics)
+		{
+			record = {};
+			transfer(reader, record);
+		}
+		compute.resize(header.compute_count);
+		for (auto& record : compute)
+			reader.value(record.shader_hash);
+		if (!file)
+		{
+			graphics.clear();
+			compute.clear();
+			return false;
+		}
+		return true;
+	}
+
+	bool PipelineCache::save(const char* path) const
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file)
+			return false;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		PipelineCacheHeader header =
+		{
+			.magic = pipeline_cache_magic,
+			.version = pipeline_cache_version,
+			.graphics_count = (uint32_t)graphics.size(),
+			.compute_count = (uint32_t)compute.size(),
+		};
+		file.write((const char*)&header, sizeof(header));
+		ManifestWriter writer(file);
+		for (auto& record : graphics)
+			transfer(writer, record);
+		for (auto& record : compute)
+			writer.value(record.shader_hash);
+		return (bool)file;
+	}
+
+	void PipelineCache::record(const GraphicsPipelineRecord& record)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto iter = std::find_if(graphics.begin(), graphics.end(), [&record](const GraphicsPipelineRecord& other) { return same_record(record, other); });
+		if (iter == graphics.end())
+		{
+			auto& stored = graphics.emplace_back(record);
+			for (uint32_t i = 0; i < stored.vertex_layout.attribute_count; ++i)
+				stored.vertex_layout.attributes[i].semantic_name = intern_name(names, stored.vertex_layout.attributes[i].semantic_name);
+			++uncachedCount;
+		}
+	}
+
+	void PipelineCache::record(const ComputePipelineRecord& record)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto iter = std::find_if(compute.begin(), compute.end(), [&record](const ComputePipelineRecord& other) { return record.shader_hash == other.shader_hash; });
+		if (iter == compute.end())
+		{
+			compute.push_back(record);
+			++uncachedCount;
+		}
+	}
+
+	void PipelineCache::prewarm(ExecutorContext& context, Shader* shader)
+	{
+		std::scoped_lock poolLock(*context.poolMutex, *context.pipelineMutex);
+		prewarm(context.pipelinePool, context.renderPassPool, shader);
+	}
+
+	void PipelineCache::prewarm(ExecutorContext& context, ComputeShader* shader)
+	{
+		std::lock_guard<std::mutex> poolLock(*context.pipelineMutex);
+		prewarm(context.computePipelinePool, shader);
+	}
+
+	void PipelineCache::prewarm(GraphicsPipelinePool& pipelines, RenerPassPool& render_passes, Shader* shader)
+	{
+		// copied out since creating a pipeline records it again
+		std::pmr::vector<GraphicsPipelineRecord> records(graphics.get_allocator().resource());
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			std::copy_if(graphics.begin(), graphics.end(), std::back_inserter(records), [shader](const GraphicsPipelineRecord& record)
+				{
+					return record.shader_hash == shader->hash && same_states(record, shader);
+				});
+		}
+
+		for (auto& record : records)
+		{
+			auto render_pass = render_passes.prewarm(record.render_pass);
+			auto key = PSOKey
+			{
+				.shader = shader,
+				.vertex_layout_id = intern_vertex_layout(record.vertex_layout),
+				.render_pass = render_pass->renderPass,
+				.subpass = record.subpass,
+				.render_target_count = record.render_target_count,
+				.prim_topology = record.prim_topology,
+			};
+			pipelines.prewarm(key, record.vertex_layout, record.render_pass);
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		prewarmedCount += (uint32_t)records.size();
+	}
+
+	void PipelineCache::prewarm(ComputePipelinePool& pipelines, ComputeShader* shader)
+	{
+		bool seen;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			seen = std::any_of(compute.begin(), compute.end(), [shader](const ComputePipelineRecord& record) { return record.shader_hash == shader->hash; });
+		}
+		if (!seen)
+			return;
+
+		pipelines.prewarm(shader);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		++prewarmedCount;
+	}
+}
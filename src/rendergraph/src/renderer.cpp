@@ -1,8 +1,17 @@
 #include "renderer.h"
 
 #include <vector>
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <cassert>
+#include <string.h>
+#include <unordered_map>
+#include <unordered_set>
 #include "hash.h"
 #include "rendergraph.h"
+#include "bindlessheap.h"
 
 namespace HGEGraphics
 {
@@ -42,6 +51,7 @@ namespace HGEGraphics
 		shader->blend_desc = blend_desc;
 		shader->depth_desc = depth_desc;
 		shader->rasterizer_state = rasterizer_state;
+		shader->hash = fnv1a64(frag_data, frag_length, fnv1a64(vert_data, vert_length));
 		return shader;
 	}
 
@@ -76,6 +86,7 @@ namespace HGEGraphics
 		auto shader = new ComputeShader();
 		shader->root_sig = root_sig;
 		shader->cs = ppl_shaders[0];
+		shader->hash = fnv1a64(comp_data, comp_length);
 		return shader;
 	}
 
@@ -107,14 +118,87 @@ namespace HGEGraphics
 	void free_buffer(Buffer* buffer)
 	{
 		if (buffer->handle)
+		{
 			cgpu_free_buffer(buffer->handle);
+			invalidate_resource_bindings(buffer->handle);
+		}
 		delete buffer;
 	}
 
+	static bool same_semantic_name(const char8_t* a, const char8_t* b)
+	{
+		if (!a || !b)
+			return a == b;
+		return !strcmp((const char*)a, (const char*)b);
+	}
+
+	bool same_vertex_layout(const CGPUVertexLayout& a, const CGPUVertexLayout& b)
+	{
+		if (a.attribute_count != b.attribute_count)
+			return false;
+		for (uint32_t i = 0; i < a.attribute_count; ++i)
+		{
+			auto& x = a.attributes[i];
+			auto& y = b.attributes[i];
+			if (!same_semantic_name(x.semantic_name, y.semantic_name) || x.array_size != y.array_size || x.format != y.format
+				|| x.binding != y.binding || x.offset != y.offset || x.elem_stride != y.elem_stride || x.rate != y.rate)
+				return false;
+		}
+		return true;
+	}
+
+	static uint64_t hash_vertex_layout(const CGPUVertexLayout& vertex_layout)
+	{
+		uint64_t hash = fnv1a64(&vertex_layout.attribute_count, sizeof(vertex_layout.attribute_count));
+		for (uint32_t i = 0; i < vertex_layout.attribute_count; ++i)
+		{
+			auto& attribute = vertex_layout.attributes[i];
+			if (attribute.semantic_name)
+				hash = fnv1a64(attribute.semantic_name, strlen((const char*)attribute.semantic_name), hash);
+			uint32_t fields[] = { attribute.array_size, (uint32_t)attribute.format, attribute.binding, attribute.offset, attribute.elem_stride, (uint32_t)attribute.rate };
+			hash = fnv1a64(fields, sizeof(fields), hash);
+		}
+		return hash;
+	}
+
+	struct VertexLayoutTable
+	{
+		std::mutex mutex;
+		std::unordered_multimap<uint64_t, uint32_t> ids;
+		std::deque<CGPUVertexLayout> layouts;
+		// owns the semantic names the stored layouts point to, callers may free theirs
+		std::unordered_set<std::u8string> names;
+	};
+
+	uint64_t intern_vertex_layout(const CGPUVertexLayout& vertex_layout)
+	{
+		static VertexLayoutTable table;
+		uint64_t hash = hash_vertex_layout(vertex_layout);
+
+		std::lock_guard<std::mutex> lock(table.mutex);
+		auto range = table.ids.equal_range(hash);
+		for (auto iter = range.first; iter != range.second; ++iter)
+		{
+			if (same_vertex_layout(table.layouts[iter->second], vertex_layout))
+				return iter->second;
+		}
+
+		auto& stored = table.layouts.emplace_back(vertex_layout);
+		for (uint32_t i = 0; i < stored.attribute_count; ++i)
+		{
+			if (stored.attributes[i].semantic_name)
+				stored.attributes[i].semantic_name = table.names.emplace(stored.attributes[i].semantic_name).first->c_str();
+		}
+		uint32_t id = (uint32_t)table.layouts.size() - 1;
+		table.ids.emplace(hash, id);
+		return id;
+	}
+
 	Mesh* create_empty_mesh()
 	{
 		auto mesh = new Mesh();
 		mesh->vertex_layout = {};
+		mesh->vertex_layout_id = intern_vertex_layout(mesh->vertex_layout);
 		mesh->prim_topology = CGPU_PRIM_TOPO_POINT_LIST;
 		mesh->vertices_count = 0;
 		mesh->index_count = 0;
@@ -128,6 +212,7 @@ namespace HGEGraphics
 	void init_mesh(Mesh* mesh, CGPUDeviceId device, uint32_t vertex_count, uint32_t index_count, ECGPUPrimitiveTopology prim_topology, const CGPUVertexLayout& vertex_layout, uint32_t index_stride, bool update_vertex_data_from_compute_shader, bool update_index_data_from_compute_shader)
 	{
 		mesh->vertex_layout = vertex_layout;
+		mesh->vertex_layout_id = intern_vertex_layout(vertex_layout);
 		mesh->prim_topology = prim_topology;
 		mesh->vertices_count = vertex_count;
 		mesh->index_count = index_count;
@@ -169,6 +254,7 @@ namespace HGEGraphics
 	{
 		auto mesh = create_empty_mesh();
 		mesh->vertex_layout = vertex_layout;
+		mesh->vertex_layout_id = intern_vertex_layout(vertex_layout);
 		mesh->prim_topology = prim_topology;
 		mesh->vertices_count = 0;
 		mesh->vertex_stride = 0;
@@ -188,7 +274,7 @@ namespace HGEGraphics
 		auto dynamic_vertex_buffer = rendergraph_import_dynamic_buffer(rg, mesh->vertex_buffer);
 		rg_buffer_set_size(rg, dynamic_vertex_buffer, count * mesh->vertex_stride);
 		rg_buffer_set_type(rg, dynamic_vertex_buffer, CGPU_RESOURCE_TYPE_VERTEX_BUFFER);
-		rg_buffer_set_usage(rg, dynamic_vertex_buffer, CGPU_MEM_USAGE_GPU_ONLY);
+		rg_buffer_set_usage(rg, dynamic_vertex_buffer, CGPU_MEM_USAGE_CPU_TO_GPU);
 		mesh->vertex_buffer->dynamic_handle = dynamic_vertex_buffer;
 		mesh->vertices_count = count;
 		return mesh->vertex_buffer->dynamic_handle;
@@ -199,7 +285,7 @@ namespace HGEGraphics
 		auto dynamic_index_buffer = rendergraph_import_dynamic_buffer(rg, mesh->index_buffer);
 		rg_buffer_set_size(rg, dynamic_index_buffer, count * mesh->index_stride);
 		rg_buffer_set_type(rg, dynamic_index_buffer, CGPU_RESOURCE_TYPE_INDEX_BUFFER);
-		rg_buffer_set_usage(rg, dynamic_index_buffer, CGPU_MEM_USAGE_GPU_ONLY);
+		rg_buffer_set_usage(rg, dynamic_index_buffer, CGPU_MEM_USAGE_CPU_TO_GPU);
 		mesh->index_buffer->dynamic_handle = dynamic_index_buffer;
 		mesh->index_count = count;
 		return mesh->index_buffer->dynamic_handle;
@@ -228,9 +314,10 @@ namespace HGEGraphics
 		texture->handle = CGPU_NULLPTR;
 		texture->view = CGPU_NULLPTR;
 		texture->cur_states.clear();
-		texture->states_consistent = false;
 		texture->prepared = false;
+		texture->unordered_access = false;
 		texture->dynamic_handle = {};
+		texture->bindless_index = UINT32_MAX;
 		return texture;
 	}
 
@@ -241,9 +328,8 @@ namespace HGEGraphics
 			new_desc.flags |= CGPU_TCF_FORCE_2D;
 
 		texture->handle = cgpu_create_texture(device, &new_desc);
-		texture->cur_states.resize(new_desc.array_size * new_desc.mip_levels);
-		std::fill(texture->cur_states.begin(), texture->cur_states.end(), CGPU_RESOURCE_STATE_UNDEFINED);
-		texture->states_consistent = true;
+		texture->cur_states.reset(new_desc.array_size * new_desc.mip_levels, CGPU_RESOURCE_STATE_UNDEFINED);
+		texture->unordered_access = CGPU_RESOURCE_TYPE_RW_TEXTURE == (new_desc.descriptors & CGPU_RESOURCE_TYPE_RW_TEXTURE);
 
 		uint32_t arrayCount = texture->handle->info->array_size_minus_one + 1;
 		ECGPUTextureDimension dims = CGPU_TEX_DIMENSION_2D;
@@ -275,7 +361,10 @@ namespace HGEGraphics
 	void free_texture(Texture* texture)
 	{
 		if (texture->view)
+		{
 			cgpu_free_texture_view(texture->view);
+			invalidate_resource_bindings(texture->view);
+		}
 		if (texture->handle)
 			cgpu_free_texture(texture->handle);
 		delete texture;
@@ -285,9 +374,8 @@ namespace HGEGraphics
 	{
 		backbuffer->texture.handle = swapchain->back_buffers[index];
 		backbuffer->texture.view = CGPU_NULLPTR;
-		backbuffer->texture.cur_states.resize(1);
-		backbuffer->texture.cur_states[0] = CGPU_RESOURCE_STATE_UNDEFINED;
-		backbuffer->texture.states_consistent = true;
+		backbuffer->texture.cur_states.reset(1, CGPU_RESOURCE_STATE_UNDEFINED);
+		backbuffer->texture.unordered_access = false;
 		backbuffer->texture.dynamic_handle = {};
 	}
 
@@ -296,7 +384,6 @@ namespace HGEGraphics
 		backbuffer->texture.handle = CGPU_NULLPTR;
 		backbuffer->texture.view = CGPU_NULLPTR;
 		backbuffer->texture.cur_states.clear();
-		backbuffer->texture.states_consistent = false;
 	}
 
 	void push_constants(RenderPassEncoder* encoder, Shader* shader, const char8_t* name, const void* data)
@@ -304,10 +391,47 @@ namespace HGEGraphics
 		cgpu_render_encoder_push_constants(encoder->encoder, shader->root_sig, name, data);
 	}
 
-	void update_render_pipeline(RenderPassEncoder* encoder, Shader* shader, ECGPUPrimitiveTopology mesh_topology, const CGPUVertexLayout& vertex_layout)
+	void push_constants(RenderPassEncoder* encoder, ComputeShader* shader, const char8_t* name, const void* data)
+	{
+		cgpu_compute_encoder_push_constants(encoder->compute_encoder, shader->root_sig, name, data);
+	}
+
+	static GraphicsPipeline* find_render_pipeline(RenderPassEncoder* encoder, Shader* shader, ECGPUPrimitiveTopology mesh_topology, const CGPUVertexLayout& vertex_layout, uint64_t vertex_layout_id)
+	{
+		uint64_t slot = ((uintptr_t)shader >> 4) ^ vertex_layout_id ^ mesh_topology;
+		auto& lookup = encoder->pipeline_lookup[slot & (std::size(encoder->pipeline_lookup) - 1)];
+		if (lookup.shader == shader && lookup.vertex_layout_id == vertex_layout_id && lookup.prim_topology == mesh_topology)
+			return lookup.pipeline;
+
+		std::unique_lock<std::mutex> poolLock(*encoder->context->pipelineMutex);
+		auto pipeline = encoder->context->pipelinePool.getGraphicsPipeline(encoder, shader, mesh_topology, vertex_layout, vertex_layout_id);
+		poolLock.unlock();
+		// pipelines still compiling go through the pool again on the next draw
+		if (pipeline && pipeline->ready.load(std::memory_order_acquire))
+			lookup = { shader, vertex_layout_id, mesh_topology, pipeline };
+		return pipeline;
+	}
+
+	// returns the shader whose pipeline got bound, null when the draw has to be skipped
+	Shader* update_render_pipeline(RenderPassEncoder* encoder, Shader* shader, ECGPUPrimitiveTopology mesh_topology, const CGPUVertexLayout& vertex_layout, uint64_t vertex_layout_id)
 	{
-		auto pipeline = encoder->context->pipelinePool.getGraphicsPipeline(encoder, shader, mesh_topology, vertex_layout);
-		if (pipeline && pipeline->handle != encoder->last_render_pipeline)
+		auto context = encoder->context;
+		auto pipeline = find_render_pipeline(encoder, shader, mesh_topology, vertex_layout, vertex_layout_id);
+		if (pipeline && !pipeline->ready.load(std::memory_order_acquire))
+		{
+			auto fallback = context->fallback_shader;
+			pipeline = fallback && fallback != shader ? find_render_pipeline(encoder, fallback, mesh_topology, vertex_layout, vertex_layout_id) : nullptr;
+			if (pipeline && pipeline->ready.load(std::memory_order_acquire))
+				shader = fallback;
+			else
+				pipeline = nullptr;
+		}
+		if (!pipeline)
+		{
+			context->compileStats->skipped_draws.fetch_add(1, std::memory_order_relaxed);
+			return nullptr;
+		}
+		if (pipeline->handle != encoder->last_render_pipeline)
 		{
 			cgpu_render_encoder_bind_pipeline(encoder->encoder, pipeline->handle);
 			if (encoder->context->pipelinePool.dynamicStateT1Enabled())
@@ -320,24 +444,92 @@ namespace HGEGraphics
 				cgpu_raster_state_encoder_set_depth_compare_op(encoder->raster_state_encoder, shader->depth_desc.depth_func);
 			}
 			encoder->last_render_pipeline = pipeline->handle;
-			memset(encoder->last_bind_resources, 0, sizeof(encoder->last_bind_resources));
+			memset(encoder->last_descriptor_sets, 0, sizeof(encoder->last_descriptor_sets));
+		}
+		return shader;
+	}
+
+	static DescriptorBinding descriptor_binding(const CGPUDescriptorData& data)
+	{
+		return
+		{
+			.resource = data.ptrs[0],
+			.offset = data.buffers_params.offsets ? *data.buffers_params.offsets : 0,
+			.size = data.buffers_params.sizes ? *data.buffers_params.sizes : 0,
+			.binding = data.binding,
+			.type = (uint32_t)data.binding_type,
+		};
+	}
+
+	static bool is_bindless_table(const CGPUParameterTable& table)
+	{
+		if (table.resources_count != 1)
+			return false;
+		auto& res = table.resources[0];
+		return res.type == CGPU_RESOURCE_TYPE_TEXTURE && res.name && !strcmp((const char*)res.name, (const char*)BindlessHeap::resource_name);
+	}
+
+	static void bind_descriptor_set(RenderPassEncoder* encoder, uint32_t index, DescriptorSet* dset, bool is_graphics)
+	{
+		if (dset == encoder->last_descriptor_sets[index])
+			return;
+		if (is_graphics)
+			cgpu_render_encoder_bind_descriptor_set(encoder->encoder, dset->handle);
+		else
+			cgpu_compute_encoder_bind_descriptor_set(encoder->compute_encoder, dset->handle);
+		encoder->last_descriptor_sets[index] = dset;
+	}
+
+	// the whole array is one set per layout and heap version, so draws only rebind it after a pipeline change
+	static void update_bindless_set(RenderPassEncoder* encoder, CGPURootSignatureId root_sig, uint32_t index, bool is_graphics)
+	{
+		auto context = encoder->context;
+		auto heap = context->bindlessHeap;
+		auto& table = root_sig->tables[index];
+		DescriptorSetKey key =
+		{
+			.root_signature = root_sig,
+			.set_index = table.set_index,
+			.binding_count = 0,
+			.content_hash = heap->version(),
+			.bindings = nullptr,
+		};
+		auto last = encoder->last_descriptor_sets[index];
+		if (last && DescriptorSetKeyEq()(last->descriptor(), key))
+			return;
+
+		auto& res = table.resources[0];
+		uint32_t count = res.size > 0 ? std::min(res.size, heap->capacity()) : heap->capacity();
+		bool written;
+		auto dset = encoder->worker->descriptorSetPool.getDescriptorSet(key, written);
+		if (!written)
+		{
+			std::pmr::vector<CGPUTextureViewId> views(count, context->default_texture, context->memory_resource);
+			heap->fill(context->default_texture, views.data(), count);
+			CGPUDescriptorData data =
+			{
+				.binding = res.binding,
+				.binding_type = res.type,
+				.textures = views.data(),
+				.count = count,
+			};
+			cgpu_update_descriptor_set(dset->handle, &data, 1);
 		}
+
+		bind_descriptor_set(encoder, index, dset, is_graphics);
 	}
 
 	void update_descriptor_set(RenderPassEncoder* encoder, CGPURootSignatureId root_sig, bool is_graphics)
 	{
+		auto heap = encoder->context->bindlessHeap;
 		for (uint32_t i = 0; i < std::min(4u, root_sig->table_count); ++i)
 		{
 			auto& table = root_sig->tables[i];
-			CGPUDescriptorSetDescriptor dset_desc =
+			if (heap && heap->enabled() && is_bindless_table(table))
 			{
-				.root_signature = root_sig,
-				.set_index = table.set_index,
-			};
-			
-			auto dset = encoder->context->descriptorSetPool.getDescriptorSet(dset_desc);
-			encoder->context->allocated_dsets.push_back(dset);
-
+				update_bindless_set(encoder, root_sig, i, is_graphics);
+				continue;
+			}
 			const uint32_t data_size = 64;
 			CGPUDescriptorData datas[data_size] = { 0 };
 			uint32_t data_count = 0;
@@ -354,21 +546,23 @@ namespace HGEGraphics
 					.binding_type = res.type,
 					.count = 1,
 				};
-				if (res.type == CGPU_RESOURCE_TYPE_TEXTURE)
+				if (res.type == CGPU_RESOURCE_TYPE_TEXTURE || res.type == CGPU_RESOURCE_TYPE_RW_TEXTURE)
 				{
 					CGPUTextureViewId textureview = CGPU_NULLPTR;
-					for (auto iter = encoder->context->global_texture_table.rbegin(); iter != encoder->context->global_texture_table.rend(); ++iter)
+					for (auto iter = encoder->worker->global_texture_table.rbegin(); iter != encoder->worker->global_texture_table.rend(); ++iter)
 					{
 						auto& binder = *iter;
 						if (binder.set == i && binder.bind == res.binding)
 						{
 							if (rendergraph_texture_handle_valid(binder.texture_handle))
-								textureview = rendergraph_resolve_texture_view(encoder, binder.texture_handle);
+								textureview = res.type == CGPU_RESOURCE_TYPE_RW_TEXTURE ? rendergraph_resolve_texture_uav(encoder, binder.texture_handle) : rendergraph_resolve_texture_view(encoder, binder.texture_handle);
 							else if (binder.texture && binder.texture->prepared)
 								textureview = binder.texture->view;
 							break;
 						}
 					}
+					// a slot left unset by this pass falls back to the default texture, not to what an earlier pass set
+					assert(textureview || !encoder->worker->droppedGlobal(i, res.binding));
 					if (!textureview)
 						textureview = encoder->context->default_texture;
 					encoder->textureviews[texture_view_count] = textureview;
@@ -378,7 +572,7 @@ namespace HGEGraphics
 				else if (res.type == CGPU_RESOURCE_TYPE_SAMPLER)
 				{
 					CGPUSamplerId sampler = CGPU_NULLPTR;
-					for (auto iter = encoder->context->global_sampler_table.rbegin(); iter != encoder->context->global_sampler_table.rend(); ++iter)
+					for (auto iter = encoder->worker->global_sampler_table.rbegin(); iter != encoder->worker->global_sampler_table.rend(); ++iter)
 					{
 						auto& binder = *iter;
 						if (binder.set == i && binder.bind == res.binding)
@@ -387,6 +581,7 @@ namespace HGEGraphics
 							break;
 						}
 					}
+					assert(sampler || !encoder->worker->droppedGlobal(i, res.binding));
 					if (!sampler)
 						;	// TODO
 					encoder->samplers[sampler_count] = sampler;
@@ -395,7 +590,7 @@ namespace HGEGraphics
 				}
 				else if (res.type == CGPU_RESOURCE_TYPE_UNIFORM_BUFFER || res.type == CGPU_RESOURCE_TYPE_RW_BUFFER)
 				{
-					for (auto iter = encoder->context->global_buffer_table.rbegin(); iter != encoder->context->global_buffer_table.rend(); ++iter)
+					for (auto iter = encoder->worker->global_buffer_table.rbegin(); iter != encoder->worker->global_buffer_table.rend(); ++iter)
 					{
 						auto& binder = *iter;
 						if (binder.set == i && binder.bind == res.binding)
@@ -413,26 +608,32 @@ namespace HGEGraphics
 							break;
 						}
 					}
+					assert(data.buffers || !encoder->worker->droppedGlobal(i, res.binding));
 				}
 				if (data.ptrs != nullptr)
 					datas[data_count++] = data;
 			}
 
-			if (data_count > 0)
+			if (data_count == 0)
+				continue;
+
+			DescriptorBinding bindings[data_size];
+			for (uint32_t j = 0; j < data_count; ++j)
+				bindings[j] = descriptor_binding(datas[j]);
+			DescriptorSetKey key =
 			{
-				bool dset_dirty = memcmp(datas, encoder->last_bind_resources[i], sizeof(CGPUDescriptorData) * data_count) != 0;
-				bool offset_size_dirty = memcmp(encoder->buffer_offset_sizes, encoder->last_buffer_offset_sizes[i], sizeof(float) * 2 * offset_size_count);
-				if (dset_dirty || offset_size_dirty)
-				{
-					cgpu_update_descriptor_set(dset->handle, datas, data_count);
-					if (is_graphics)
-						cgpu_render_encoder_bind_descriptor_set(encoder->encoder, dset->handle);
-					else
-						cgpu_compute_encoder_bind_descriptor_set(encoder->compute_encoder, dset->handle);
-					memcpy(encoder->last_bind_resources[i], datas, sizeof(CGPUDescriptorData) * data_count);
-					memcpy(encoder->last_buffer_offset_sizes[i], encoder->buffer_offset_sizes, sizeof(float) * 2 * offset_size_count);
-				}
-			}
+				.root_signature = root_sig,
+				.set_index = table.set_index,
+				.binding_count = data_count,
+				.content_hash = hash_descriptor_bindings(bindings, data_count),
+				.bindings = bindings,
+			};
+			bool written;
+			auto dset = encoder->worker->descriptorSetPool.getDescriptorSet(key, written);
+			if (!written)
+				cgpu_update_descriptor_set(dset->handle, datas, data_count);
+
+			bind_descriptor_set(encoder, i, dset, is_graphics);
 		}
 	}
 
@@ -484,7 +685,9 @@ namespace HGEGraphics
 	{
 		if (!mesh->prepared)
 			return;
-		update_render_pipeline(encoder, shader, mesh->prim_topology, mesh->vertex_layout);
+		shader = update_render_pipeline(encoder, shader, mesh->prim_topology, mesh->vertex_layout, mesh->vertex_layout_id);
+		if (!shader)
+			return;
 		update_descriptor_set(encoder, shader->root_sig, true);
 		update_mesh(encoder, mesh);
 		if (encoder->last_index_buffer)
@@ -497,7 +700,9 @@ namespace HGEGraphics
 	{
 		if (!mesh->prepared)
 			return;
-		update_render_pipeline(encoder, shader, mesh->prim_topology, mesh->vertex_layout);
+		shader = update_render_pipeline(encoder, shader, mesh->prim_topology, mesh->vertex_layout, mesh->vertex_layout_id);
+		if (!shader)
+			return;
 		update_descriptor_set(encoder, shader->root_sig, true);
 		update_mesh(encoder, mesh);
 		if (encoder->last_index_buffer)
@@ -507,21 +712,26 @@ namespace HGEGraphics
 	}
 
 	static CGPUVertexLayout procedure_vertex_layout = { .attribute_count = 0 };
+	static uint64_t procedure_vertex_layout_id = intern_vertex_layout(procedure_vertex_layout);
 	void draw_procedure(RenderPassEncoder* encoder, Shader* shader, ECGPUPrimitiveTopology mesh_topology, uint32_t vertex_count)
 	{
-		update_render_pipeline(encoder, shader, mesh_topology, procedure_vertex_layout);
+		shader = update_render_pipeline(encoder, shader, mesh_topology, procedure_vertex_layout, procedure_vertex_layout_id);
+		if (!shader)
+			return;
 		update_descriptor_set(encoder, shader->root_sig, true);
 		cgpu_render_encoder_draw(encoder->encoder, vertex_count, 0);
 	}
 
 	void update_compute_pipeline(RenderPassEncoder* encoder, ComputeShader* shader)
 	{
+		std::unique_lock<std::mutex> poolLock(*encoder->context->pipelineMutex);
 		auto pipeline = encoder->context->computePipelinePool.getComputePipeline(shader);
+		poolLock.unlock();
 		if (pipeline && pipeline->handle != encoder->last_compute_pipeline)
 		{
 			cgpu_compute_encoder_bind_pipeline(encoder->compute_encoder, pipeline->handle);
 			encoder->last_compute_pipeline = pipeline->handle;
-			memset(encoder->last_bind_resources, 0, sizeof(encoder->last_bind_resources));
+			memset(encoder->last_descriptor_sets, 0, sizeof(encoder->last_descriptor_sets));
 		}
 	}
 
@@ -534,27 +744,27 @@ namespace HGEGraphics
 
 	void set_global_texture(RenderPassEncoder* encoder, Texture* texture, int set, int slot)
 	{
-		encoder->context->global_texture_table.push_back({ texture, {}, set, slot });
+		encoder->worker->global_texture_table.push_back({ texture, {}, set, slot });
 	}
 
 	void set_global_texture_handle(RenderPassEncoder* encoder, texture_handle_t texture, int set, int slot)
 	{
-		encoder->context->global_texture_table.push_back({ nullptr, texture, set, slot });
+		encoder->worker->global_texture_table.push_back({ nullptr, texture, set, slot });
 	}
 
 	void set_global_sampler(RenderPassEncoder* encoder, CGPUSamplerId sampler, int set, int slot)
 	{
-		encoder->context->global_sampler_table.push_back({ sampler, set, slot });
+		encoder->worker->global_sampler_table.push_back({ sampler, set, slot });
 	}
 
 	void set_global_buffer(RenderPassEncoder* encoder, buffer_handle_t buffer, int set, int slot)
 	{
-		encoder->context->global_buffer_table.push_back({ buffer, set, slot, 0, 0 });
+		encoder->worker->global_buffer_table.push_back({ buffer, set, slot, 0, 0 });
 	}
 
 	void set_global_buffer_with_offset_size(RenderPassEncoder* encoder, buffer_handle_t buffer, int set, int slot, uint64_t offset, uint64_t size)
 	{
-		encoder->context->global_buffer_table.push_back({ buffer, set, slot, offset, size });
+		encoder->worker->global_buffer_table.push_back({ buffer, set, slot, offset, size });
 	}
 
 	void upload(UploadEncoder* encoder, uint64_t offset, uint64_t length, void* data)
@@ -563,61 +773,216 @@ namespace HGEGraphics
 		memcpy(address, data, length);
 	}
 
-	ExecutorContext::ExecutorContext(CGPUDeviceId device, CGPUQueueId gfx_queue, bool profile, std::pmr::memory_resource* memory_resource)
-		: device(device), memory_resource(memory_resource), renderPassPool(device, memory_resource), framebufferPool(device, memory_resource), texturePool(device, gfx_queue, nullptr, memory_resource), pipelinePool(device, nullptr, memory_resource), computePipelinePool(device, nullptr, memory_resource), textureViewPool(nullptr, memory_resource), bufferPool(device, nullptr, memory_resource), descriptorSetPool(device, memory_resource), allocated_dsets(memory_resource)
-		, cmds(memory_resource), allocated_cmds(memory_resource), global_texture_table(memory_resource), global_sampler_table(memory_resource), global_buffer_table(memory_resource)
+	ExecutorWorker::ExecutorWorker(CGPUDeviceId device, CGPUQueueId gfx_queue, CGPUQueueId compute_queue, std::pmr::memory_resource* memory_resource)
+		: cmds(memory_resource), allocated_cmds(memory_resource), compute_cmds(memory_resource), allocated_compute_cmds(memory_resource), global_texture_table(memory_resource), global_sampler_table(memory_resource), global_buffer_table(memory_resource), dropped_globals(memory_resource), descriptorSetPool(device, memory_resource)
 	{
 		cmdPool = cgpu_create_command_pool(gfx_queue, CGPU_NULLPTR);
-		if (profile)
-			profiler = new Profiler(device, gfx_queue, memory_resource);
+		if (compute_queue)
+			computeCmdPool = cgpu_create_command_pool(compute_queue, CGPU_NULLPTR);
 	}
 
-	void ExecutorContext::newFrame()
+	void ExecutorWorker::newFrame()
 	{
-		++timestamp;
-
 		cgpu_reset_command_pool(cmdPool);
 
 		for (auto cmd : allocated_cmds)
 			cmds.push_back(cmd);
 		allocated_cmds.clear();
 
+		if (computeCmdPool)
+			cgpu_reset_command_pool(computeCmdPool);
+		for (auto cmd : allocated_compute_cmds)
+			compute_cmds.push_back(cmd);
+		allocated_compute_cmds.clear();
+
+		resetGlobals();
+		dropped_globals.clear();
+		// the shared pool may destroy views in its own newFrame, and it only keeps views that went through it recently
+		memset(view_lookup, 0, sizeof(view_lookup));
+		descriptorSetPool.newFrame();
+	}
+
+	static uint32_t global_key(uint32_t set, uint32_t slot)
+	{
+		return (set << 16) | slot;
+	}
+
+	void ExecutorWorker::resetGlobals()
+	{
+#ifndef NDEBUG
+		auto drop = [this](uint32_t set, uint32_t slot)
+		{
+			if (!droppedGlobal(set, slot))
+				dropped_globals.push_back(global_key(set, slot));
+		};
+		for (auto& binder : global_texture_table)
+			drop(binder.set, binder.bind);
+		for (auto& binder : global_sampler_table)
+			drop(binder.set, binder.bind);
+		for (auto& binder : global_buffer_table)
+			drop(binder.set, binder.bind);
+#endif
 		global_texture_table.clear();
 		global_sampler_table.clear();
 		global_buffer_table.clear();
+	}
 
-		framebufferPool.newFrame();
-		descriptorSetPool.newFrame();
-		textureViewPool.newFrame();
-		bufferPool.newFrame();
-		pipelinePool.newFrame();
-		computePipelinePool.newFrame();
-		renderPassPool.newFrame();
-		texturePool.newFrame();
+	bool ExecutorWorker::droppedGlobal(uint32_t set, uint32_t slot) const
+	{
+		return std::find(dropped_globals.begin(), dropped_globals.end(), global_key(set, slot)) != dropped_globals.end();
+	}
+
+	CGPUTextureViewId ExecutorWorker::getTextureView(ExecutorContext* context, const CGPUTextureViewDescriptor& desc)
+	{
+		auto& lookup = view_lookup[TextureViewDescriptorHasher()(desc) & (std::size(view_lookup) - 1)];
+		if (lookup.view && TextureViewDescriptorEq()(lookup.desc, desc))
+			return lookup.view;
 
-		for (auto& dset : allocated_dsets)
-			descriptorSetPool.releaseResource(dset);
-		allocated_dsets.clear();
+		std::lock_guard<std::mutex> lock(*context->poolMutex);
+		auto textureView = context->textureViewPool.getResource(desc);
+		lookup = { desc, textureView->handle };
+		return textureView->handle;
 	}
 
-	CGPUCommandBufferId ExecutorContext::requestCmd()
+	CGPUCommandBufferId ExecutorWorker::requestCmd(ECGPUQueueType queue)
 	{
+		bool compute = queue == CGPU_QUEUE_TYPE_COMPUTE;
+		assert(!compute || computeCmdPool);
+		auto& freeCmds = compute ? compute_cmds : cmds;
 		CGPUCommandBufferId cmd;
-		if (!cmds.empty())
+		if (!freeCmds.empty())
 		{
-			cmd = cmds.back();
-			cmds.pop_back();
+			cmd = freeCmds.back();
+			freeCmds.pop_back();
 		}
 		else
 		{
 			CGPUCommandBufferDescriptor cmd_desc = { .is_secondary = false };
-			cmd = cgpu_create_command_buffer(cmdPool, &cmd_desc);
+			cmd = cgpu_create_command_buffer(compute ? computeCmdPool : cmdPool, &cmd_desc);
 		}
 
-		allocated_cmds.push_back(cmd);
+		(compute ? allocated_compute_cmds : allocated_cmds).push_back(cmd);
 		return cmd;
 	}
 
+	void ExecutorWorker::destroy()
+	{
+		for (auto cmd : cmds)
+		{
+			cgpu_free_command_buffer(cmd);
+		}
+		cmds.clear();
+		for (auto cmd : allocated_cmds)
+		{
+			cgpu_free_command_buffer(cmd);
+		}
+		allocated_cmds.clear();
+		if (cmdPool)
+			cgpu_free_command_pool(cmdPool);
+		cmdPool = CGPU_NULLPTR;
+		for (auto cmd : compute_cmds)
+		{
+			cgpu_free_command_buffer(cmd);
+		}
+		compute_cmds.clear();
+		for (auto cmd : allocated_compute_cmds)
+		{
+			cgpu_free_command_buffer(cmd);
+		}
+		allocated_compute_cmds.clear();
+		if (computeCmdPool)
+			cgpu_free_command_pool(computeCmdPool);
+		computeCmdPool = CGPU_NULLPTR;
+		resetGlobals();
+	}
+
+	ExecutorContext::ExecutorContext(CGPUDeviceId device, CGPUQueueId gfx_queue, CGPUQueueId compute_queue, WorkerPool* worker_pool, bool profile, std::pmr::memory_resource* memory_resource)
+		: memory_resource(memory_resource), texturePool(device, gfx_queue, nullptr, memory_resource), renderPassPool(device, memory_resource), framebufferPool(device, memory_resource), pipelinePool(device, nullptr, memory_resource), computePipelinePool(device, nullptr, memory_resource), textureViewPool(nullptr, memory_resource), bufferPool(device, nullptr, memory_resource)
+		, workerPool(worker_pool), workers(memory_resource), semaphores(memory_resource), submitted_cmds(memory_resource), submissions(memory_resource), texture_barriers(memory_resource), buffer_barriers(memory_resource), device(device)
+	{
+		// command pools must only be used from one thread, so every worker of the pool records with its own
+		uint32_t workerCount = workerPool ? workerPool->workerCount() : 1;
+		workers.reserve(workerCount);
+		for (uint32_t i = 0; i < workerCount; ++i)
+			workers.emplace_back(device, gfx_queue, compute_queue, memory_resource);
+		poolMutex = new std::mutex();
+		pipelineMutex = new std::mutex();
+		compileStats = new PipelineCompileStats();
+		if (profile)
+			profiler = new Profiler(device, gfx_queue, memory_resource);
+	}
+
+	void ExecutorContext::newFrame()
+	{
+		++timestamp;
+
+		for (auto& worker : workers)
+			worker.newFrame();
+		submitted_cmds.clear();
+		submissions.clear();
+
+		framebufferPool.newFrame();
+		textureViewPool.newFrame();
+		bufferPool.newFrame();
+		pipelinePool.newFrame();
+		computePipelinePool.newFrame();
+		renderPassPool.newFrame();
+		texturePool.newFrame();
+
+		compileStats->skipped_draws.store(0, std::memory_order_relaxed);
+	}
+
+	void ExecutorContext::setPoolBudget(PoolBudget* budget)
+	{
+		// the other pools report no memory of their own, evicting them would not bring the budget down
+		texturePool.setBudget(budget);
+		bufferPool.setBudget(budget);
+	}
+
+	void ExecutorContext::setPipelineCache(PipelineCache* cache)
+	{
+		pipelinePool.setPipelineCache(cache);
+		computePipelinePool.setPipelineCache(cache);
+	}
+
+	void ExecutorContext::setBindlessHeap(BindlessHeap* heap)
+	{
+		bindlessHeap = heap;
+	}
+
+	void ExecutorContext::setAsyncPipelineCompile(bool enable, Shader* fallback)
+	{
+		// compiles only go to spawned threads, a pool without any would never run them
+		bool async = enable && workerPool && workerPool->workerCount() > 1;
+		pipelinePool.setAsyncCompile(async ? workerPool : nullptr, &compileStats->jobs);
+		fallback_shader = async ? fallback : nullptr;
+	}
+
+	void ExecutorContext::queryPipelineCompiles(uint32_t& pending, uint32_t& skipped_draws)
+	{
+		pending = compileStats->jobs.pending.load(std::memory_order_relaxed);
+		skipped_draws = compileStats->skipped_draws.load(std::memory_order_relaxed);
+	}
+
+	void ExecutorContext::queryPoolStats(uint32_t& length, const char8_t**& names, const ResourcePoolStats*& stats)
+	{
+		static const char8_t* pool_names[] = { u8"texture", u8"buffer", u8"texture view", u8"framebuffer", u8"render pass", u8"graphics pipeline", u8"compute pipeline", u8"descriptor set" };
+		ResourcePoolStats descriptorSets = {};
+		for (auto& worker : workers)
+		{
+			auto worker_stats = worker.descriptorSetPool.stats();
+			descriptorSets.hits += worker_stats.hits;
+			descriptorSets.misses += worker_stats.misses;
+			descriptorSets.creations += worker_stats.creations;
+			descriptorSets.evictions += worker_stats.evictions;
+			descriptorSets.retained_bytes += worker_stats.retained_bytes;
+		}
+		pool_stats = { texturePool.stats(), bufferPool.stats(), textureViewPool.stats(), framebufferPool.stats(), renderPassPool.stats(), pipelinePool.stats(), computePipelinePool.stats(), descriptorSets };
+		length = (uint32_t)pool_stats.size();
+		names = pool_names;
+		stats = pool_stats.data();
+	}
+
 	void ExecutorContext::destroy()
 	{
 		delete profiler;
@@ -629,31 +994,29 @@ namespace HGEGraphics
 		renderPassPool.destroy();
 		texturePool.destroy();
 		bufferPool.destroy();
-		for (auto cmd : cmds)
+		for (auto& worker : workers)
 		{
-			cgpu_free_command_buffer(cmd);
+			worker.destroy();
 		}
-		cmds.clear();
-		for (auto cmd : allocated_cmds)
+		workers.clear();
+		for (auto semaphore : semaphores)
 		{
-			cgpu_free_command_buffer(cmd);
+			cgpu_free_semaphore(semaphore);
 		}
-		allocated_cmds.clear();
-		if (cmdPool)
-			cgpu_free_command_pool(cmdPool);
-		cmdPool = CGPU_NULLPTR;
-		global_texture_table.clear();
-		global_sampler_table.clear();
-		global_buffer_table.clear();
+		semaphores.clear();
+		submitted_cmds.clear();
+		submissions.clear();
+		delete poolMutex;
+		poolMutex = nullptr;
+		delete pipelineMutex;
+		pipelineMutex = nullptr;
+		delete compileStats;
+		compileStats = nullptr;
 		device = CGPU_NULLPTR;
 	}
 	void ExecutorContext::pre_destroy()
 	{
-		for (auto& dset : allocated_dsets)
-		{
-			descriptorSetPool.releaseResource(dset);
-		}
-		allocated_dsets.clear();
-		descriptorSetPool.destroy();
+		for (auto& worker : workers)
+			worker.descriptorSetPool.destroy();
 	}
 }
\ No newline at end of file
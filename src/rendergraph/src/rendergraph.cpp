@@ -1,8 +1,11 @@
 #include "rendergraph.h"
 
 #include <cassert>
+#include <string.h>
 #include "renderer.h"
 #include "drawer.h"
+#include "bufferarena.h"
+#include "historypool.h"
 
 namespace HGEGraphics
 {
@@ -41,18 +44,46 @@ namespace HGEGraphics
 	}
 
 	rendergraph_t::rendergraph_t(size_t estimate_resource_count, size_t estimate_pass_count, size_t estimate_edge_count, Shader* blitShader, CGPUSamplerId blitSampler, std::pmr::memory_resource* const resource)
-		: allocator(resource), resources(resource), passes(resource), edges(resource), blitShader(blitShader), blitSampler(blitSampler), imported_textures(resource), imported_buffers(resource)
+		: allocator(resource), resources(resource), passes(resource), edges(resource), read_edges(resource), write_edges(resource), blitShader(blitShader), blitSampler(blitSampler), imported_textures(resource), imported_buffers(resource)
 	{
 		resources.reserve(estimate_resource_count);
 		resources.push_back({});
 		passes.reserve(estimate_pass_count);
 		edges.reserve(estimate_edge_count);
+		read_edges.reserve(estimate_edge_count);
+		write_edges.reserve(estimate_edge_count);
 	}
 	void rendergraph_reset(rendergraph_t* self)
 	{
 		self->resources.clear();
 		self->passes.clear();
 		self->edges.clear();
+		self->read_edges.clear();
+		self->write_edges.clear();
+	}
+	void rendergraph_set_reorder_passes(rendergraph_t* self, bool enable)
+	{
+		self->reorder_passes = enable;
+	}
+	void rendergraph_set_async_compute(rendergraph_t* self, bool enable)
+	{
+		self->async_compute = enable;
+	}
+	void rendergraph_set_mipmap_shader(rendergraph_t* self, ComputeShader* shader)
+	{
+		self->mipmapShader = shader;
+	}
+	void rendergraph_set_constant_arena(rendergraph_t* self, BufferArena* arena)
+	{
+		self->constantArena = arena;
+	}
+	void rendergraph_set_staging_arena(rendergraph_t* self, BufferArena* arena)
+	{
+		self->stagingArena = arena;
+	}
+	void rendergraph_set_history_pool(rendergraph_t* self, HistoryPool* pool)
+	{
+		self->historyPool = pool;
 	}
 	void allocate_passdata(rendergraph_t* self, RenderPassNode* passNode, size_t passdata_size, void** passdata)
 	{
@@ -67,68 +98,81 @@ namespace HGEGraphics
 	renderpass_builder_t rendergraph_add_renderpass(rendergraph_t* self, const char8_t* name)
 	{
 		assert(self->passes.size() <= MAX_INDEX);
-		self->passes.emplace_back(name, PASS_TYPE_RENDER, self->allocator.resource());
+		self->passes.emplace_back(name, PASS_TYPE_RENDER);
 		return renderpass_builder_t(self, &(self->passes.back()), self->passes.size() - 1);
 	}
 	renderpass_builder_t rendergraph_add_computepass(rendergraph_t* self, const char8_t* name)
 	{
 		assert(self->passes.size() <= MAX_INDEX);
-		self->passes.emplace_back(name, PASS_TYPE_COMPUTE, self->allocator.resource());
+		self->passes.emplace_back(name, PASS_TYPE_COMPUTE);
 		return renderpass_builder_t(self, &(self->passes.back()), self->passes.size() - 1);
 	}
 	renderpass_builder_t rendergraph_add_holdpass(rendergraph_t* self, const char8_t* name)
 	{
 		assert(self->passes.size() <= MAX_INDEX);
-		self->passes.emplace_back(name, PASS_TYPE_HOLDON, self->allocator.resource());
+		self->passes.emplace_back(name, PASS_TYPE_HOLDON);
 		return renderpass_builder_t(self, &(self->passes.back()), self->passes.size() - 1);
 	}
 	void rendergraph_add_uploadtexturepass(rendergraph_t* self, const char8_t* name, texture_handle_t texture, uint8_t mipmap, uint8_t slice, uploadpass_executable executable, size_t passdata_size, void** passdata)
 	{
 		rendergraph_add_uploadtexturepass_ex(self, name, texture, mipmap, slice, 0, 0, nullptr, executable, passdata_size, passdata);
 	}
+	static uint64_t upload_region_size(const ResourceNode& textureNode, uint8_t mipmap)
+	{
+		auto mipedSize = [](uint64_t size, uint64_t mip) { return std::max<uint64_t>(size >> mip, 1ull); };
+		// a mip smaller than a block still takes a whole block
+		const uint64_t blockWidth = FormatUtil_WidthOfBlock(textureNode.format);
+		const uint64_t blockHeight = FormatUtil_HeightOfBlock(textureNode.format);
+		const uint64_t xBlocksCount = (mipedSize(textureNode.width, mipmap) + blockWidth - 1) / blockWidth;
+		const uint64_t yBlocksCount = (mipedSize(textureNode.height, mipmap) + blockHeight - 1) / blockHeight;
+		const uint64_t zBlocksCount = mipedSize(textureNode.depth, mipmap);
+		return xBlocksCount * yBlocksCount * zBlocksCount * FormatUtil_BitSizeOfBlock(textureNode.format) / 8;
+	}
+	static buffer_handle_t add_staging_read(rendergraph_t* self, int passIndex, uint64_t size, uint64_t* staging_offset)
+	{
+		buffer_handle_t staging_buffer;
+		if (self->stagingArena)
+		{
+			auto allocation = self->stagingArena->allocate(self, size);
+			staging_buffer = allocation.buffer;
+			*staging_offset = allocation.offset;
+		}
+		else
+		{
+			staging_buffer = rendergraph_declare_buffer(self);
+			rg_buffer_set_size(self, staging_buffer, size);
+			rg_buffer_set_type(self, staging_buffer, CGPU_RESOURCE_TYPE_NONE);
+			rg_buffer_set_usage(self, staging_buffer, CGPU_MEM_USAGE_CPU_ONLY);
+			rg_buffer_set_hold_on_last(self, staging_buffer);
+			*staging_offset = 0;
+		}
+		auto read_edge = rendergraph_add_edge(self, get_buffer_handle_index(staging_buffer), passIndex, CGPU_RESOURCE_STATE_COPY_SOURCE);
+		self->read_edges.push_back(read_edge);
+		return staging_buffer;
+	}
 	void rendergraph_add_uploadtexturepass_ex(rendergraph_t* self, const char8_t* name, texture_handle_t texture, uint8_t mipmap, uint8_t slice, uint64_t size, uint64_t offset, void* data, uploadpass_executable executable, size_t passdata_size, void** passdata)
 	{
 		assert(self->passes.size() <= MAX_INDEX);
-		auto& pass = self->passes.emplace_back(name, PASS_TYPE_UPLOAD_TEXTURE, self->allocator.resource());
+		self->passes.emplace_back(name, PASS_TYPE_UPLOAD_TEXTURE);
 		int passIndex = self->passes.size() - 1;
 
 		assert(rendergraph_texture_handle_valid(texture));
 		auto& textureNode = self->resources[get_texture_handle_index(texture)];
 		assert(textureNode.resourceType == ResourceType::Texture);
 
-		texture_handle_t usedTexture;
-		ResourceNode* usedTextureNode;
-
-		if (textureNode.mipCount == 1 && textureNode.arraySize == 1)
-		{
-			usedTexture = texture;
-			usedTextureNode = &textureNode;
-		}
-		else
-		{
+		texture_handle_t usedTexture = texture;
+		if (textureNode.mipCount != 1 || textureNode.arraySize != 1)
 			usedTexture = rendergraph_declare_texture_subresource(self, texture, mipmap, slice);
-			usedTextureNode = &self->resources[get_texture_handle_index(usedTexture)];
-		}
+		const uint64_t bufferSize = upload_region_size(self->resources[get_texture_handle_index(usedTexture)], mipmap);
+		assert(bufferSize >= size + offset);
 
-		pass.upload_texture_context.dest_texture = usedTexture;
 		auto write_edge = rendergraph_add_edge(self, passIndex, get_texture_handle_index(usedTexture), CGPU_RESOURCE_STATE_COPY_DEST);
-		pass.writes.push_back(write_edge);
-
-		auto staging_buffer = rendergraph_declare_buffer(self);
-		auto mipedSize = [](uint64_t size, uint64_t mip) { return std::max<uint64_t>(size >> mip, 1ull); };
-		const uint64_t xBlocksCount = mipedSize(usedTextureNode->width, mipmap) / FormatUtil_WidthOfBlock(usedTextureNode->format);
-		const uint64_t yBlocksCount = mipedSize(usedTextureNode->height, mipmap) / FormatUtil_HeightOfBlock(usedTextureNode->format);
-		const uint64_t zBlocksCount = mipedSize(usedTextureNode->depth, mipmap);
-		const uint64_t bufferSize = xBlocksCount * yBlocksCount * zBlocksCount * FormatUtil_BitSizeOfBlock(usedTextureNode->format) / 8;
-		assert(bufferSize >= size + offset);
-		rg_buffer_set_size(self, staging_buffer, bufferSize);
-		rg_buffer_set_type(self, staging_buffer, CGPU_RESOURCE_TYPE_NONE);
-		rg_buffer_set_usage(self, staging_buffer, CGPU_MEM_USAGE_CPU_ONLY);
-		rg_buffer_set_hold_on_last(self, staging_buffer);
-		pass.upload_texture_context.staging_buffer = staging_buffer;
-		auto read_edge = rendergraph_add_edge(self, get_buffer_handle_index(staging_buffer), passIndex, CGPU_RESOURCE_STATE_COPY_SOURCE);
-		pass.reads.push_back(read_edge);
+		self->write_edges.push_back(write_edge);
 
+		auto& pass = self->passes[passIndex];
+		pass.upload_texture_context.dest_texture = usedTexture;
+		pass.upload_texture_context.staging_buffer = add_staging_read(self, passIndex, bufferSize, &pass.upload_texture_context.staging_offset);
+		pass.upload_texture_context.staging_size = bufferSize;
 		pass.upload_texture_context.executable = executable;
 		allocate_passdata(self, &pass, passdata_size, passdata);
 		pass.upload_texture_context.size = size;
@@ -136,6 +180,56 @@ namespace HGEGraphics
 		pass.upload_texture_context.data = data;
 		pass.upload_texture_context.mipmap = mipmap;
 		pass.upload_texture_context.slice = slice;
+		pass.upload_texture_context.mipCount = 1;
+		pass.upload_texture_context.sliceCount = 1;
+	}
+	void rendergraph_add_uploadtexturepass_full(rendergraph_t* self, const char8_t* name, texture_handle_t texture, uint8_t mip_count, uint64_t size, void* data)
+	{
+		assert(self->passes.size() <= MAX_INDEX);
+		self->passes.emplace_back(name, PASS_TYPE_UPLOAD_TEXTURE);
+		int passIndex = self->passes.size() - 1;
+
+		assert(rendergraph_texture_handle_valid(texture));
+		const ResourceNode textureNode = self->resources[get_texture_handle_index(texture)];
+		assert(textureNode.resourceType == ResourceType::Texture && textureNode.manageType != ManageType::SubResource);
+		assert(mip_count > 0 && mip_count <= textureNode.mipCount);
+
+		uint64_t bufferSize = 0;
+		for (uint8_t mip = 0; mip < mip_count; ++mip)
+			bufferSize += upload_region_size(textureNode, mip) * textureNode.arraySize;
+		assert(bufferSize >= size);
+
+		if (mip_count == textureNode.mipCount)
+		{
+			auto write_edge = rendergraph_add_edge(self, passIndex, get_texture_handle_index(texture), CGPU_RESOURCE_STATE_COPY_DEST);
+			self->write_edges.push_back(write_edge);
+		}
+		else
+		{
+			for (uint8_t mip = 0; mip < mip_count; ++mip)
+			{
+				for (uint8_t slice = 0; slice < textureNode.arraySize; ++slice)
+				{
+					auto subresource = rendergraph_declare_texture_subresource(self, texture, mip, slice);
+					auto write_edge = rendergraph_add_edge(self, passIndex, get_texture_handle_index(subresource), CGPU_RESOURCE_STATE_COPY_DEST);
+					self->write_edges.push_back(write_edge);
+				}
+			}
+		}
+
+		auto& pass = self->passes[passIndex];
+		pass.upload_texture_context.dest_texture = texture;
+		pass.upload_texture_context.staging_buffer = add_staging_read(self, passIndex, bufferSize, &pass.upload_texture_context.staging_offset);
+		pass.upload_texture_context.staging_size = bufferSize;
+		pass.upload_texture_context.executable = nullptr;
+		allocate_passdata(self, &pass, 0, nullptr);
+		pass.upload_texture_context.size = size;
+		pass.upload_texture_context.offset = 0;
+		pass.upload_texture_context.data = data;
+		pass.upload_texture_context.mipmap = 0;
+		pass.upload_texture_context.slice = 0;
+		pass.upload_texture_context.mipCount = mip_count;
+		pass.upload_texture_context.sliceCount = textureNode.arraySize;
 	}
 	void rendergraph_add_uploadbufferpass(rendergraph_t* self, const char8_t* name, buffer_handle_t buffer, uploadpass_executable executable, size_t passdata_size, void** passdata)
 	{
@@ -144,78 +238,167 @@ namespace HGEGraphics
 	void rendergraph_add_uploadbufferpass_ex(rendergraph_t* self, const char8_t* name, buffer_handle_t buffer, uint64_t size, uint64_t offset, void* data, uploadpass_executable executable, size_t passdata_size, void** passdata)
 	{
 		assert(self->passes.size() <= MAX_INDEX);
-		auto& pass = self->passes.emplace_back(name, PASS_TYPE_UPLOAD_BUFFER, self->allocator.resource());
+		self->passes.emplace_back(name, PASS_TYPE_UPLOAD_BUFFER);
 		int passIndex = self->passes.size() - 1;
 
 		assert(rendergraph_buffer_handle_valid(buffer));
 		auto& resourceNode = self->resources[get_buffer_handle_index(buffer)];
 		assert(resourceNode.resourceType == ResourceType::Buffer);
+		const uint64_t bufferSize = resourceNode.size;
+		assert(bufferSize >= size + offset);
+		// transient host visible buffers come from the frame's own pool, so they are written in place while recording
+		// holding them to the end keeps the pool from handing the same memory to another upload of this frame
+		const bool direct = resourceNode.manageType == ManageType::Managed && (resourceNode.memoryUsage == CGPU_MEM_USAGE_CPU_TO_GPU || resourceNode.memoryUsage == CGPU_MEM_USAGE_CPU_ONLY);
+		if (direct)
+			resourceNode.holdOnLast = true;
+		auto write_edge = rendergraph_add_edge(self, passIndex, get_buffer_handle_index(buffer), direct ? CGPU_RESOURCE_STATE_UNDEFINED : CGPU_RESOURCE_STATE_COPY_DEST);
+		self->write_edges.push_back(write_edge);
+
+		auto& pass = self->passes[passIndex];
 		pass.upload_buffer_context.dest_buffer = buffer;
-		auto write_edge = rendergraph_add_edge(self, passIndex, get_buffer_handle_index(buffer), CGPU_RESOURCE_STATE_COPY_DEST);
-		pass.writes.push_back(write_edge);
-
-		auto staging_buffer = rendergraph_declare_buffer(self);
-		assert(resourceNode.size >= size + offset);
-		rg_buffer_set_size(self, staging_buffer, resourceNode.size);
-		rg_buffer_set_type(self, staging_buffer, CGPU_RESOURCE_TYPE_NONE);
-		rg_buffer_set_usage(self, staging_buffer, CGPU_MEM_USAGE_CPU_ONLY);
-		rg_buffer_set_hold_on_last(self, staging_buffer);
-		pass.upload_buffer_context.staging_buffer = staging_buffer;
-		auto read_edge = rendergraph_add_edge(self, get_buffer_handle_index(staging_buffer), passIndex, CGPU_RESOURCE_STATE_COPY_SOURCE);
-		pass.reads.push_back(read_edge);
-
+		if (direct)
+		{
+			pass.upload_buffer_context.staging_buffer = {};
+			pass.upload_buffer_context.staging_offset = 0;
+		}
+		else
+			pass.upload_buffer_context.staging_buffer = add_staging_read(self, passIndex, bufferSize, &pass.upload_buffer_context.staging_offset);
+		pass.upload_buffer_context.staging_size = bufferSize;
 		pass.upload_buffer_context.executable = executable;
 		allocate_passdata(self, &pass, passdata_size, passdata);
 		pass.upload_buffer_context.size = size;
 		pass.upload_buffer_context.offset = offset;
 		pass.upload_buffer_context.data = data;
 	}
-	void rendergraph_add_generate_mipmap(rendergraph_t* self, texture_handle_t texture, uint8_t from_mipmap)
+	static void add_generate_mipmap_blit(rendergraph_t* self, texture_handle_t texture, uint8_t from_mipmap, uint8_t mipCount, uint8_t arraySize)
 	{
-		assert(rendergraph_texture_handle_valid(texture));
-		auto& textureNode = self->resources[get_texture_handle_index(texture)];
-		assert(textureNode.resourceType == ResourceType::Texture && textureNode.manageType != ManageType::SubResource);
-		assert(textureNode.arraySize == 1);
-		if (textureNode.mipCount == 1)
-			return;
-
-		auto mip0 = rendergraph_declare_texture_subresource(self, texture, 0, 0);
-		auto last = mip0;
-		for (size_t i = from_mipmap; i < textureNode.mipCount; ++i)
+		struct BlitMipmapPassData
 		{
-			auto mipi = rendergraph_declare_texture_subresource(self, texture, i, 0);
+			Shader* blitShader;
+			CGPUSamplerId blitSampler;
+			texture_handle_t source;
+		};
 
-			auto passBuilder = rendergraph_add_renderpass(self, u8"generate mip");
-			renderpass_add_color_attachment(&passBuilder, mipi, CGPU_LOAD_ACTION_DONTCARE, 0, CGPU_STORE_ACTION_STORE);
-			renderpass_sample(&passBuilder, last);
+		for (uint8_t slice = 0; slice < arraySize; ++slice)
+		{
+			auto last = rendergraph_declare_texture_subresource(self, texture, from_mipmap - 1, slice);
+			for (uint8_t i = from_mipmap; i < mipCount; ++i)
+			{
+				auto mipi = rendergraph_declare_texture_subresource(self, texture, i, slice);
+
+				auto passBuilder = rendergraph_add_renderpass(self, u8"generate mip");
+				renderpass_add_color_attachment(&passBuilder, mipi, CGPU_LOAD_ACTION_DONTCARE, 0, CGPU_STORE_ACTION_STORE);
+				renderpass_sample(&passBuilder, last);
+
+				BlitMipmapPassData* passdata = nullptr;
+				renderpass_set_executable(&passBuilder, [](RenderPassEncoder* encoder, void* passdata)
+					{
+						BlitMipmapPassData* resolved_passdata = (BlitMipmapPassData*)passdata;
+						set_global_texture_handle(encoder, resolved_passdata->source, 0, 0);
+						set_global_sampler(encoder, resolved_passdata->blitSampler, 0, 1);
+						draw_procedure(encoder, resolved_passdata->blitShader, CGPU_PRIM_TOPO_TRI_LIST, 3);
+					}, sizeof(BlitMipmapPassData), (void**)&passdata);
+				passdata->blitShader = self->blitShader;
+				passdata->blitSampler = self->blitSampler;
+				passdata->source = last;
+				last = mipi;
+			}
+		}
+	}
+	static void add_generate_mipmap_compute(rendergraph_t* self, texture_handle_t texture, uint8_t from_mipmap, uint8_t mipCount, uint8_t arraySize, uint32_t width, uint32_t height)
+	{
+		// the shader reduces an 8x8 tile of its first output down to a single texel of its fourth
+		constexpr uint8_t mipsPerDispatch = 4;
+		struct ComputeMipmapPassData
+		{
+			ComputeShader* mipmapShader;
+			CGPUSamplerId sampler;
+			texture_handle_t source;
+			texture_handle_t outputs[mipsPerDispatch];
+			uint32_t outWidth;
+			uint32_t outHeight;
+			uint32_t mipCount;
+		};
 
-			struct BlitMipmapPassData
+		for (uint8_t slice = 0; slice < arraySize; ++slice)
+		{
+			auto last = rendergraph_declare_texture_subresource(self, texture, from_mipmap - 1, slice);
+			for (uint8_t srcMip = from_mipmap - 1; srcMip + 1 < mipCount; srcMip += mipsPerDispatch)
 			{
-				Shader* blitShader;
-				CGPUSamplerId blitSampler;
-				texture_handle_t source;
-			};
-			BlitMipmapPassData* passdata = nullptr;
-			renderpass_set_executable(&passBuilder, [](RenderPassEncoder* encoder, void* passdata)
+				uint8_t count = std::min<uint8_t>(mipsPerDispatch, mipCount - srcMip - 1);
+				auto passBuilder = rendergraph_add_computepass(self, u8"generate mip");
+				ComputeMipmapPassData* passdata = nullptr;
+				computepass_set_executable(&passBuilder, [](RenderPassEncoder* encoder, void* passdata)
+					{
+						ComputeMipmapPassData* resolved_passdata = (ComputeMipmapPassData*)passdata;
+						struct
+						{
+							float texelSize[2];
+							uint32_t outSize[2];
+							uint32_t mipCount;
+						} constants = {
+							{ 1.0f / resolved_passdata->outWidth, 1.0f / resolved_passdata->outHeight },
+							{ resolved_passdata->outWidth, resolved_passdata->outHeight },
+							resolved_passdata->mipCount,
+						};
+						set_global_texture_handle(encoder, resolved_passdata->source, 0, 0);
+						set_global_sampler(encoder, resolved_passdata->sampler, 0, 1);
+						for (uint8_t i = 0; i < mipsPerDispatch; ++i)
+							set_global_texture_handle(encoder, resolved_passdata->outputs[i], 0, 2 + i);
+						push_constants(encoder, resolved_passdata->mipmapShader, u8"pushConstants", &constants);
+						dispatch(encoder, resolved_passdata->mipmapShader, (resolved_passdata->outWidth + 7) / 8, (resolved_passdata->outHeight + 7) / 8, 1);
+					}, sizeof(ComputeMipmapPassData), (void**)&passdata);
+				passdata->mipmapShader = self->mipmapShader;
+				passdata->sampler = self->blitSampler;
+				passdata->source = last;
+				computepass_sample(&passBuilder, passdata->source);
+				for (uint8_t i = 0; i < mipsPerDispatch; ++i)
 				{
-					BlitMipmapPassData* resolved_passdata = (BlitMipmapPassData*)passdata;
-					set_global_texture_handle(encoder, resolved_passdata->source, 0, 0);
-					set_global_sampler(encoder, resolved_passdata->blitSampler, 0, 1);
-					draw_procedure(encoder, resolved_passdata->blitShader, CGPU_PRIM_TOPO_TRI_LIST, 3);
-				}, sizeof(BlitMipmapPassData), (void**)&passdata);
-			passdata->blitShader = self->blitShader;
-			passdata->blitSampler = self->blitSampler;
-			passdata->source = last;
-			last = mipi;
+					// unused outputs alias the last real one, the shader never writes them
+					if (i < count)
+					{
+						passdata->outputs[i] = rendergraph_declare_texture_subresource(self, texture, srcMip + 1 + i, slice);
+						computepass_readwrite_texture(&passBuilder, passdata->outputs[i]);
+					}
+					else
+						passdata->outputs[i] = passdata->outputs[count - 1];
+				}
+				passdata->outWidth = std::max(1u, width >> (srcMip + 1));
+				passdata->outHeight = std::max(1u, height >> (srcMip + 1));
+				passdata->mipCount = count;
+				last = passdata->outputs[count - 1];
+			}
 		}
 	}
+	void rendergraph_add_generate_mipmap(rendergraph_t* self, texture_handle_t texture, uint8_t from_mipmap)
+	{
+		assert(rendergraph_texture_handle_valid(texture));
+		assert(from_mipmap > 0);
+		auto& textureNode = self->resources[get_texture_handle_index(texture)];
+		assert(textureNode.resourceType == ResourceType::Texture && textureNode.manageType != ManageType::SubResource);
+		// mips are filtered over the whole texture, which a bucketed one only partly belongs to
+		assert(!textureNode.bucketed);
+		if (textureNode.mipCount <= from_mipmap)
+			return;
+
+		// declaring subresources grows resources, so copy what is needed out of the node first
+		const uint8_t mipCount = textureNode.mipCount;
+		const uint8_t arraySize = textureNode.arraySize;
+		const uint32_t width = textureNode.width;
+		const uint32_t height = textureNode.height;
+		const bool storage = textureNode.manageType == ManageType::Imported ? textureNode.texture->unordered_access : (textureNode.textureType & CGPU_RESOURCE_TYPE_RW_TEXTURE) != 0;
+		if (self->mipmapShader && storage)
+			add_generate_mipmap_compute(self, texture, from_mipmap, mipCount, arraySize, width, height);
+		else
+			add_generate_mipmap_blit(self, texture, from_mipmap, mipCount, arraySize);
+	}
 	void rendergraph_present(rendergraph_t* self, texture_handle_t texture)
 	{
 		assert(self->passes.size() <= MAX_INDEX);
-		auto& passNode = self->passes.emplace_back(u8"Present", PASS_TYPE_PRESENT, self->allocator.resource());
+		self->passes.emplace_back(u8"Present", PASS_TYPE_PRESENT);
 		int passIndex = self->passes.size() - 1;
 		auto edge = rendergraph_add_edge(self, get_texture_handle_index(texture), passIndex, CGPU_RESOURCE_STATE_PRESENT);
-		passNode.reads.push_back(edge);
+		self->read_edges.push_back(edge);
 	}
 	texture_handle_t rendergraph_declare_texture(rendergraph_t* self)
 	{
@@ -247,6 +430,7 @@ namespace HGEGraphics
 		resourceNode.format = imported->handle->info->format;
 		resourceNode.mipCount = imported->handle->info->mip_levels;
 		resourceNode.arraySize = imported->handle->info->array_size_minus_one + 1;
+		resourceNode.sampleCount = imported->handle->info->sample_count;
 		resourceNode.mipLevel = 0;
 		resourceNode.arraySlice = 0;
 		auto handle = imported->dynamic_handle = make_texture_handle(self->resources.size() - 1);
@@ -259,10 +443,16 @@ namespace HGEGraphics
 		self->resources.push_back(ResourceNode());
 		auto& resourceNode = self->resources.back();
 		auto texture = &imported->texture;
-		texture->cur_states[0] = CGPU_RESOURCE_STATE_UNDEFINED;
-		texture->states_consistent = true;
+		texture->cur_states.reset(1, CGPU_RESOURCE_STATE_UNDEFINED);
 		return rendergraph_import_texture(self, texture);
 	}
+	texture_handle_t rendergraph_declare_history_texture(rendergraph_t* self, const char8_t* name, uint16_t width, uint16_t height, ECGPUFormat format, texture_handle_t* previous)
+	{
+		assert(self->historyPool);
+		auto versions = self->historyPool->acquire(name, width, height, format);
+		*previous = versions.previous ? rendergraph_import_texture(self, versions.previous) : texture_handle_t{};
+		return rendergraph_import_texture(self, versions.current);
+	}
 	buffer_handle_t rendergraph_declare_buffer(rendergraph_t* self)
 	{
 		assert(self->resources.size() <= MAX_INDEX);
@@ -303,40 +493,13 @@ namespace HGEGraphics
 		self->imported_buffers.push_back(imported);
 		return handle;
 	}
-	buffer_handle_t rendergraph_declare_uniform_buffer_quick(rendergraph_t* self, uint32_t size, void* data)
+	constant_range_t rendergraph_allocate_constants(rendergraph_t* self, uint32_t size, const void* data)
 	{
-		assert(self->resources.size() <= MAX_INDEX);
-		auto nextPowerOfTwo = [](uint32_t n) -> uint32_t
-			{
-				if (n == 0)
-				{
-					return 1;
-				}
-
-				// Decrement n to handle the exact power of 2 case.
-				n--;
-
-				// Set all bits after the highest set bit
-				n |= n >> 1;
-				n |= n >> 2;
-				n |= n >> 4;
-				n |= n >> 8;
-				n |= n >> 16;
-
-				// Increment n to get next power of 2
-				return n + 1;
-			};
-
-		self->resources.push_back(ResourceNode());
-		auto& resource = self->resources.back();
-		resource.resourceType = ResourceType::Buffer;
-		resource.memoryUsage = CGPU_MEM_USAGE_UNKNOWN;
-		resource.size = nextPowerOfTwo(size);
-		resource.bufferType = CGPU_RESOURCE_TYPE_UNIFORM_BUFFER;
-		resource.memoryUsage = ECGPUMemoryUsage::CGPU_MEM_USAGE_GPU_ONLY;
-		buffer_handle_t ubo_handle = make_buffer_handle(self->resources.size() - 1);
-		rendergraph_add_uploadbufferpass_ex(self, u8"quick upload ubo", ubo_handle, resource.size, 0, data, nullptr, 0, nullptr);
-		return ubo_handle;
+		assert(self->constantArena);
+		auto allocation = self->constantArena->allocate(self, size);
+		if (data)
+			memcpy(allocation.address, data, size);
+		return { allocation.buffer, (uint32_t)allocation.offset, size };
 	}
 	texture_handle_t rendergraph_declare_texture_subresource(rendergraph_t* self, texture_handle_t parent_handle, uint8_t mipmap, uint8_t slice)
 	{
@@ -362,6 +525,9 @@ namespace HGEGraphics
 		resourceNode.format = textureNode->format;
 		resourceNode.mipCount = textureNode->mipCount;
 		resourceNode.arraySize = textureNode->arraySize;
+		resourceNode.sampleCount = textureNode->sampleCount;
+		resourceNode.textureType = textureNode->textureType;
+		resourceNode.bucketed = textureNode->bucketed;
 		resourceNode.parent = parent;
 		resourceNode.mipLevel = mipmap;
 		resourceNode.arraySlice = slice;
@@ -373,15 +539,15 @@ namespace HGEGraphics
 		return self->edges.size() - 1;
 	}
 	ResourceNode::ResourceNode()
-		: name(nullptr), resourceType(ResourceType::Texture), manageType(ManageType::Managed), width(0), height(0), depth(0), format(ECGPUFormat::CGPU_FORMAT_UNDEFINED), texture(nullptr), buffer(nullptr), holdOnLast(false), bufferType(CGPU_RESOURCE_TYPE_NONE), memoryUsage(CGPU_MEM_USAGE_UNKNOWN), size(0), mipCount(0), arraySize(0), parent(0), mipLevel(0), arraySlice(0)
+		: name(nullptr), resourceType(ResourceType::Texture), manageType(ManageType::Managed), width(0), height(0), depth(0), format(ECGPUFormat::CGPU_FORMAT_UNDEFINED), texture(nullptr), buffer(nullptr), holdOnLast(false), bufferType(CGPU_RESOURCE_TYPE_NONE), memoryUsage(CGPU_MEM_USAGE_UNKNOWN), size(0), mipCount(0), arraySize(0), sampleCount(1), textureType(CGPU_RESOURCE_TYPE_NONE), bucketed(false), parent(0), mipLevel(0), arraySlice(0)
 	{
 	}
 	renderpass_builder_t::renderpass_builder_t(rendergraph_t* renderGraph, RenderPassNode* passNode, int passIndex)
 		: renderGraph(renderGraph), passNode(passNode), passIndex(passIndex)
 	{
 	}
-	RenderPassNode::RenderPassNode(const char8_t* name, pass_type type, std::pmr::memory_resource* const momory_resource)
-		: name(name), writes(momory_resource), reads(momory_resource), type(type), passdata(nullptr), upload_buffer_context({ 0 })
+	RenderPassNode::RenderPassNode(const char8_t* name, pass_type type)
+		: name(name), type(type), passdata(nullptr), upload_buffer_context({ 0 })
 	{
 		if (type == PASS_TYPE_RENDER)
 		{
@@ -394,7 +560,7 @@ namespace HGEGraphics
 		assert(self->passNode->render_context.colorAttachmentCount <= self->passNode->render_context.colorAttachments.size());
 
 		auto edge = rendergraph_add_edge(self->renderGraph, self->passIndex, get_texture_handle_index(texture), CGPU_RESOURCE_STATE_RENDER_TARGET);
-		self->passNode->writes.push_back(edge);
+		self->renderGraph->write_edges.push_back(edge);
 		self->passNode->render_context.colorAttachments[self->passNode->render_context.colorAttachmentCount++] =
 		{
 			.clearColor = clearColor,
@@ -410,9 +576,9 @@ namespace HGEGraphics
 		assert(!self->passNode->render_context.depthAttachment.valid);
 
 		auto edge1 = rendergraph_add_edge(self->renderGraph, get_texture_handle_index(texture), self->passIndex, CGPU_RESOURCE_STATE_UNDEFINED);
-		self->passNode->reads.push_back(edge1);
+		self->renderGraph->read_edges.push_back(edge1);
 		auto edge2 = rendergraph_add_edge(self->renderGraph, self->passIndex, get_texture_handle_index(texture), CGPU_RESOURCE_STATE_DEPTH_WRITE);
-		self->passNode->writes.push_back(edge2);
+		self->renderGraph->write_edges.push_back(edge2);
 		self->passNode->render_context.depthAttachment =
 		{
 			.clearDepth = clearDepth,
@@ -425,10 +591,24 @@ namespace HGEGraphics
 			.valid = true,
 		};
 	}
+	void renderpass_add_color_attachment_auto(renderpass_builder_t* self, texture_handle_t texture, bool clear, uint32_t clearColor)
+	{
+		renderpass_add_color_attachment(self, texture, clear ? CGPU_LOAD_ACTION_CLEAR : CGPU_LOAD_ACTION_LOAD, clearColor, CGPU_STORE_ACTION_STORE);
+		auto& attachment = self->passNode->render_context.colorAttachments[self->passNode->render_context.colorAttachmentCount - 1];
+		attachment.auto_load = !clear;
+		attachment.auto_store = true;
+	}
+	void renderpass_add_depth_attachment_auto(renderpass_builder_t* self, texture_handle_t texture, bool clear, float clearDepth, uint8_t clearStencil)
+	{
+		auto load_action = clear ? CGPU_LOAD_ACTION_CLEAR : CGPU_LOAD_ACTION_LOAD;
+		renderpass_add_depth_attachment(self, texture, load_action, clearDepth, CGPU_STORE_ACTION_STORE, load_action, clearStencil, CGPU_STORE_ACTION_STORE);
+		self->passNode->render_context.depthAttachment.auto_load = !clear;
+		self->passNode->render_context.depthAttachment.auto_store = true;
+	}
 	void renderpass_sample(renderpass_builder_t* self, texture_handle_t texture)
 	{
 		auto edge = rendergraph_add_edge(self->renderGraph, get_texture_handle_index(texture), self->passIndex, CGPU_RESOURCE_STATE_SHADER_RESOURCE);
-		self->passNode->reads.push_back(edge);
+		self->renderGraph->read_edges.push_back(edge);
 	}
 	void renderpass_use_buffer(renderpass_builder_t* self, buffer_handle_t buffer)
 	{
@@ -446,7 +626,7 @@ namespace HGEGraphics
 		assert(state != CGPU_RESOURCE_STATE_UNDEFINED);
 
 		auto edge = rendergraph_add_edge(self->renderGraph, get_buffer_handle_index(buffer), self->passIndex, state);
-		self->passNode->reads.push_back(edge);
+		self->renderGraph->read_edges.push_back(edge);
 	}
 	void renderpass_use_buffer_as(renderpass_builder_t* self, buffer_handle_t buffer, ECGPUResourceState state)
 	{
@@ -456,7 +636,7 @@ namespace HGEGraphics
 		assert(state != CGPU_RESOURCE_STATE_UNDEFINED);
 
 		auto edge = rendergraph_add_edge(self->renderGraph, get_buffer_handle_index(buffer), self->passIndex, state);
-		self->passNode->reads.push_back(edge);
+		self->renderGraph->read_edges.push_back(edge);
 	}
 	void renderpass_set_executable(renderpass_builder_t* self, renderpass_executable executable, size_t passdata_size, void** passdata)
 	{
@@ -466,7 +646,7 @@ namespace HGEGraphics
 	void computepass_sample(renderpass_builder_t* self, texture_handle_t texture)
 	{
 		auto edge = rendergraph_add_edge(self->renderGraph, get_texture_handle_index(texture), self->passIndex, CGPU_RESOURCE_STATE_SHADER_RESOURCE);
-		self->passNode->reads.push_back(edge);
+		self->renderGraph->read_edges.push_back(edge);
 	}
 	void computepass_use_buffer(renderpass_builder_t* self, buffer_handle_t buffer)
 	{
@@ -486,7 +666,7 @@ namespace HGEGraphics
 		assert(state != CGPU_RESOURCE_STATE_UNDEFINED);
 
 		auto edge = rendergraph_add_edge(self->renderGraph, get_buffer_handle_index(buffer), self->passIndex, state);
-		self->passNode->reads.push_back(edge);
+		self->renderGraph->read_edges.push_back(edge);
 	}
 	void computepass_use_buffer_as(renderpass_builder_t* self, buffer_handle_t buffer, ECGPUResourceState state)
 	{
@@ -496,10 +676,18 @@ namespace HGEGraphics
 		assert(state != CGPU_RESOURCE_STATE_UNDEFINED);
 
 		auto edge = rendergraph_add_edge(self->renderGraph, get_buffer_handle_index(buffer), self->passIndex, state);
-		self->passNode->reads.push_back(edge);
+		self->renderGraph->read_edges.push_back(edge);
 	}
 	void computepass_readwrite_texture(renderpass_builder_t* self, texture_handle_t texture)
 	{
+		assert(rendergraph_texture_handle_valid(texture));
+		auto& resourceNode = self->renderGraph->resources[get_texture_handle_index(texture)];
+		assert(resourceNode.resourceType == ResourceType::Texture);
+
+		auto edge = rendergraph_add_edge(self->renderGraph, get_texture_handle_index(texture), self->passIndex, CGPU_RESOURCE_STATE_UNORDERED_ACCESS);
+		self->renderGraph->read_edges.push_back(edge);
+		auto edge2 = rendergraph_add_edge(self->renderGraph, self->passIndex, get_texture_handle_index(texture), CGPU_RESOURCE_STATE_UNORDERED_ACCESS);
+		self->renderGraph->write_edges.push_back(edge2);
 	}
 	void computepass_readwrite_buffer(renderpass_builder_t* self, buffer_handle_t buffer)
 	{
@@ -508,9 +696,9 @@ namespace HGEGraphics
 		assert(resourceNode.resourceType == ResourceType::Buffer);
 
 		auto edge = rendergraph_add_edge(self->renderGraph, get_buffer_handle_index(buffer), self->passIndex, CGPU_RESOURCE_STATE_UNORDERED_ACCESS);
-		self->passNode->reads.push_back(edge);
+		self->renderGraph->read_edges.push_back(edge);
 		auto edge2 = rendergraph_add_edge(self->renderGraph, self->passIndex, get_buffer_handle_index(buffer), CGPU_RESOURCE_STATE_UNORDERED_ACCESS);
-		self->passNode->writes.push_back(edge2);
+		self->renderGraph->write_edges.push_back(edge2);
 	}
 	void computepass_set_executable(renderpass_builder_t* self, renderpass_executable executable, size_t passdata_size, void** passdata)
 	{
@@ -562,6 +750,43 @@ namespace HGEGraphics
 		else
 			resourceNode.format = CGPU_FORMAT_UNDEFINED;
 	}
+	void rg_texture_set_mip_count(rendergraph_t* self, texture_handle_t texture, uint8_t mip_count)
+	{
+		assert(is_valid_dynamic_texture_handle(self->resources, texture));
+		auto& resourceNode = self->resources[get_texture_handle_index(texture)];
+		assert(resourceNode.resourceType == ResourceType::Texture && resourceNode.manageType == ManageType::Managed);
+		assert(mip_count > 0);
+		resourceNode.mipCount = mip_count;
+	}
+	void rg_texture_set_array_size(rendergraph_t* self, texture_handle_t texture, uint8_t array_size)
+	{
+		assert(is_valid_dynamic_texture_handle(self->resources, texture));
+		auto& resourceNode = self->resources[get_texture_handle_index(texture)];
+		assert(resourceNode.resourceType == ResourceType::Texture && resourceNode.manageType == ManageType::Managed);
+		assert(array_size > 0);
+		resourceNode.arraySize = array_size;
+	}
+	void rg_texture_set_sample_count(rendergraph_t* self, texture_handle_t texture, ECGPUSampleCount sample_count)
+	{
+		assert(is_valid_dynamic_texture_handle(self->resources, texture));
+		auto& resourceNode = self->resources[get_texture_handle_index(texture)];
+		assert(resourceNode.resourceType == ResourceType::Texture && resourceNode.manageType == ManageType::Managed);
+		resourceNode.sampleCount = sample_count;
+	}
+	void rg_texture_set_usage(rendergraph_t* self, texture_handle_t texture, CGPUResourceTypes usage)
+	{
+		assert(is_valid_dynamic_texture_handle(self->resources, texture));
+		auto& resourceNode = self->resources[get_texture_handle_index(texture)];
+		assert(resourceNode.resourceType == ResourceType::Texture && resourceNode.manageType == ManageType::Managed);
+		resourceNode.textureType = usage;
+	}
+	void rg_texture_set_bucketed(rendergraph_t* self, texture_handle_t texture)
+	{
+		assert(is_valid_dynamic_texture_handle(self->resources, texture));
+		auto& resourceNode = self->resources[get_texture_handle_index(texture)];
+		assert(resourceNode.resourceType == ResourceType::Texture && resourceNode.manageType == ManageType::Managed);
+		resourceNode.bucketed = true;
+	}
 	uint32_t rg_texture_get_width(rendergraph_t* self, texture_handle_t texture)
 	{
 		assert(is_valid_dynamic_texture_handle(self->resources, texture));
@@ -590,6 +815,20 @@ namespace HGEGraphics
 		assert(resourceNode.resourceType == ResourceType::Texture);
 		return resourceNode.format;
 	}
+	uint32_t rg_texture_get_storage_width(rendergraph_t* self, texture_handle_t texture)
+	{
+		assert(is_valid_dynamic_texture_handle(self->resources, texture));
+		auto& resourceNode = self->resources[get_texture_handle_index(texture)];
+		assert(resourceNode.resourceType == ResourceType::Texture);
+		return resourceNode.bucketed ? texture_bucket_extent(resourceNode.width) : resourceNode.width;
+	}
+	uint32_t rg_texture_get_storage_height(rendergraph_t* self, texture_handle_t texture)
+	{
+		assert(is_valid_dynamic_texture_handle(self->resources, texture));
+		auto& resourceNode = self->resources[get_texture_handle_index(texture)];
+		assert(resourceNode.resourceType == ResourceType::Texture);
+		return resourceNode.bucketed ? texture_bucket_extent(resourceNode.height) : resourceNode.height;
+	}
 	void rg_buffer_set_size(rendergraph_t* self, buffer_handle_t buffer, uint32_t size)
 	{
 		assert(is_valid_dynamic_buffer_handle(self->resources, buffer));
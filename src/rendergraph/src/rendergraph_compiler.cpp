@@ -3,81 +3,559 @@
 #include "dependencygraph.h"
 #include <cassert>
 #include <algorithm>
+#include <tuple>
+#include <span>
 #include "renderer.h"
+#include "hash.h"
 
 namespace HGEGraphics
 {
-	CompiledRenderGraph Compiler::Compile(const rendergraph_t& renderGraph, std::pmr::memory_resource* const memory_resource)
+	uint64_t estimate_resource_size(const ResourceNode& resource)
 	{
-		auto resourceCount = renderGraph.resources.size();
-		auto passCount = renderGraph.passes.size();
-		auto edgeCount = renderGraph.edges.size();
+		if (resource.resourceType == ResourceType::Buffer)
+			return resource.size;
 
-		HGEGraphics::DependencyGraph graph(resourceCount + passCount, edgeCount, memory_resource);
-		
-		struct Node
+		auto mipedSize = [](uint64_t size, uint64_t mip) { return std::max<uint64_t>(size >> mip, 1ull); };
+		const uint64_t blockWidth = FormatUtil_WidthOfBlock(resource.format);
+		const uint64_t blockHeight = FormatUtil_HeightOfBlock(resource.format);
+		const uint64_t width = resource.bucketed ? texture_bucket_extent(resource.width) : resource.width;
+		const uint64_t height = resource.bucketed ? texture_bucket_extent(resource.height) : resource.height;
+		uint64_t size = 0;
+		for (uint32_t mip = 0; mip < std::max<uint32_t>(resource.mipCount, 1); ++mip)
+		{
+			const uint64_t xBlocksCount = (mipedSize(width, mip) + blockWidth - 1) / blockWidth;
+			const uint64_t yBlocksCount = (mipedSize(height, mip) + blockHeight - 1) / blockHeight;
+			const uint64_t zBlocksCount = mipedSize(resource.depth, mip);
+			size += xBlocksCount * yBlocksCount * zBlocksCount * FormatUtil_BitSizeOfBlock(resource.format) / 8;
+		}
+		return size * std::max<uint32_t>(resource.arraySize, 1) * std::max<uint32_t>(resource.sampleCount, 1);
+	}
+
+	bool can_alias(const ResourceNode& a, const ResourceNode& b)
+	{
+		// without placed resources a texture could only take over an identical texture, which the texture pool already reuses
+		if (a.resourceType != b.resourceType || a.resourceType == ResourceType::Texture)
+			return false;
+		// host visible buffers are written while recording, so they must not share storage
+		return a.memoryUsage == CGPU_MEM_USAGE_GPU_ONLY && b.memoryUsage == CGPU_MEM_USAGE_GPU_ONLY && a.bufferType == b.bufferType;
+	}
+
+	void assign_queues(CompiledRenderGraph& compiled, bool asyncCompute)
+	{
+		auto& passes = compiled.passes;
+		for (index_type_t k = 0; k < passes.size(); ++k)
 		{
-			Node(index_type_t index, bool is_pass, bool is_persistent, std::pmr::memory_resource* const resource)
-				: index(index), is_pass(is_pass), is_persistent(is_persistent), ins(resource), outs(resource)
+			auto& pass = passes[k];
+			if (pass.name != nullptr)
+				pass.queue = asyncCompute && pass.type == PASS_TYPE_COMPUTE ? CGPU_QUEUE_TYPE_COMPUTE : CGPU_QUEUE_TYPE_GRAPHICS;
+			else
+				pass.queue = k > 0 ? passes[k - 1].queue : CGPU_QUEUE_TYPE_GRAPHICS;
+		}
+
+		// the frame always opens and closes on the graphics queue, so every compute batch sits between two graphics batches
+		compiled.batches.push_back({ CGPU_QUEUE_TYPE_GRAPHICS, 0, 0, 0, 0, MAX_INDEX, false });
+		for (index_type_t k = 0; k < passes.size(); ++k)
+		{
+			if (compiled.batches.back().queue != passes[k].queue)
+				compiled.batches.push_back({ passes[k].queue, k, 0, 0, 0, MAX_INDEX, false });
+			compiled.batches.back().passCount++;
+			passes[k].batch = compiled.batches.size() - 1;
+		}
+		if (compiled.batches.back().queue != CGPU_QUEUE_TYPE_GRAPHICS)
+			compiled.batches.push_back({ CGPU_QUEUE_TYPE_GRAPHICS, (uint32_t)passes.size(), 0, 0, 0, MAX_INDEX, false });
+	}
+
+	void infer_attachment_actions(CompiledRenderGraph& compiled, std::pmr::memory_resource* const memory_resource)
+	{
+		auto rootOf = [&](index_type_t index) -> index_type_t
+		{
+			auto const& resource = compiled.resources[index];
+			return resource.manageType == ManageType::SubResource ? resource.parent : index;
+		};
+		auto imported = [&](index_type_t index) { return compiled.resources[rootOf(index)].manageType != ManageType::Managed; };
+		auto whole = [&](index_type_t index)
+		{
+			auto const& resource = compiled.resources[index];
+			return resource.manageType != ManageType::SubResource && std::max<uint32_t>(resource.mipCount, 1) * std::max<uint32_t>(resource.arraySize, 1) == 1;
+		};
+
+		compiled.attachmentActions = {};
+
+		// a transient nobody wrote yet this frame has nothing worth loading
+		std::pmr::vector<bool> written(compiled.resources.size(), false, memory_resource);
+		for (auto& pass : compiled.passes)
+		{
+			if (pass.name == nullptr)
+				continue;
+			if (pass.type == PASS_TYPE_RENDER)
 			{
+				for (auto j = 0; j < pass.colorAttachmentCount; ++j)
+				{
+					auto& attachment = pass.colorAttachments[j];
+					compiled.attachmentActions.auto_attachments += attachment.auto_load || attachment.auto_store;
+					if (!attachment.auto_load)
+						continue;
+					bool defined = imported(attachment.resourceIndex) || written[rootOf(attachment.resourceIndex)];
+					attachment.load_action = defined ? CGPU_LOAD_ACTION_LOAD : CGPU_LOAD_ACTION_DONTCARE;
+					compiled.attachmentActions.dontcare_loads += !defined;
+				}
+				auto& depth = pass.depthAttachment;
+				compiled.attachmentActions.auto_attachments += depth.valid && (depth.auto_load || depth.auto_store);
+				if (depth.valid && depth.auto_load)
+				{
+					bool defined = imported(depth.resourceIndex) || written[rootOf(depth.resourceIndex)];
+					depth.depth_load_action = depth.stencil_load_action = defined ? CGPU_LOAD_ACTION_LOAD : CGPU_LOAD_ACTION_DONTCARE;
+					compiled.attachmentActions.dontcare_loads += !defined;
+				}
 			}
+			for (auto& edge : pass.writes)
+				written[rootOf(edge.index)] = true;
+		}
 
-			bool is_culled() const
+		// walking backwards, a resource is needed if some later pass reads what is currently in it
+		std::pmr::vector<bool> needed(compiled.resources.size(), false, memory_resource);
+		for (auto k = compiled.passes.size(); k-- > 0;)
+		{
+			auto& pass = compiled.passes[k];
+			if (pass.name == nullptr)
+				continue;
+			if (pass.type == PASS_TYPE_RENDER)
+			{
+				for (auto j = 0; j < pass.colorAttachmentCount; ++j)
+				{
+					auto& attachment = pass.colorAttachments[j];
+					if (!attachment.auto_store)
+						continue;
+					bool keep = imported(attachment.resourceIndex) || needed[rootOf(attachment.resourceIndex)];
+					attachment.store_action = keep ? CGPU_STORE_ACTION_STORE : CGPU_STORE_ACTION_DISCARD;
+					compiled.attachmentActions.discarded_stores += !keep;
+				}
+				auto& depth = pass.depthAttachment;
+				if (depth.valid && depth.auto_store)
+				{
+					bool keep = imported(depth.resourceIndex) || needed[rootOf(depth.resourceIndex)];
+					depth.depth_store_action = depth.stencil_store_action = keep ? CGPU_STORE_ACTION_STORE : CGPU_STORE_ACTION_DISCARD;
+					compiled.attachmentActions.discarded_stores += !keep;
+				}
+
+				for (auto j = 0; j < pass.colorAttachmentCount; ++j)
+				{
+					auto const& attachment = pass.colorAttachments[j];
+					if (attachment.load_action == CGPU_LOAD_ACTION_LOAD)
+						needed[rootOf(attachment.resourceIndex)] = true;
+					else if (whole(attachment.resourceIndex))
+						needed[attachment.resourceIndex] = false;
+				}
+				if (depth.valid)
+				{
+					if (depth.depth_load_action == CGPU_LOAD_ACTION_LOAD || depth.stencil_load_action == CGPU_LOAD_ACTION_LOAD)
+						needed[rootOf(depth.resourceIndex)] = true;
+					else if (whole(depth.resourceIndex))
+						needed[depth.resourceIndex] = false;
+				}
+			}
+			for (auto& edge : pass.reads)
 			{
-				return ref_count == 0 && !is_persistent;
+				if (edge.usage != CGPU_RESOURCE_STATE_UNDEFINED)
+					needed[rootOf(edge.index)] = true;
 			}
+		}
+	}
 
-			std::pmr::vector<index_type_t> ins;
-			std::pmr::vector<index_type_t> outs;
-			index_type_t index = 0;
-			uint32_t ref_count = 0;
-			bool is_pass;
-			bool is_persistent{ false };
+	void merge_render_passes(CompiledRenderGraph& compiled, std::pmr::memory_resource* const memory_resource)
+	{
+		auto rootOf = [&](index_type_t index) -> index_type_t
+		{
+			auto const& resource = compiled.resources[index];
+			return resource.manageType == ManageType::SubResource ? resource.parent : index;
+		};
+		auto keyOf = [&](index_type_t index) -> uint32_t
+		{
+			auto const& root = compiled.resources[rootOf(index)];
+			return root.manageType == ManageType::Managed ? compiled.resources.size() + root.aliasBlock : rootOf(index);
 		};
 
-		std::pmr::vector<Node> nodes(memory_resource);
-		nodes.reserve(passCount + resourceCount);
-		for (index_type_t i = 0; i < passCount; ++i)
+		// keys are physical resources, so aliases of the same memory are caught too
+		std::pmr::vector<index_type_t> owners(compiled.resources.size() + compiled.aliasBlocks.size(), MAX_INDEX, memory_resource);
+		std::pmr::vector<index_type_t> roots(owners.size(), MAX_INDEX, memory_resource);
+		std::pmr::vector<ECGPUResourceState> usages(owners.size(), CGPU_RESOURCE_STATE_UNDEFINED, memory_resource);
+		auto claim = [&](const CompiledRenderPassNode& pass, index_type_t head)
 		{
-			auto const& pass = renderGraph.passes[i];
-			Node node(i, true, pass.type == PASS_TYPE_PRESENT || pass.type == PASS_TYPE_HOLDON, memory_resource);
-			node.ins.reserve(pass.reads.size());
-			for (index_type_t j = 0; j < pass.reads.size(); ++j)
-				node.ins.push_back(renderGraph.edges[pass.reads[j]].from + passCount);
-			node.outs.reserve(pass.writes.size());
-			for (index_type_t j = 0; j < pass.writes.size(); ++j)
-				node.outs.push_back(renderGraph.edges[pass.writes[j]].to + passCount);
-			nodes.emplace_back(std::move(node));
+			auto use = [&](const CompiledEdge& edge)
+			{
+				auto key = keyOf(edge.index);
+				owners[key] = head;
+				roots[key] = rootOf(edge.index);
+				if (edge.usage != CGPU_RESOURCE_STATE_UNDEFINED)
+					usages[key] = edge.usage;
+			};
+			for (auto& edge : pass.reads)
+				use(edge);
+			for (auto& edge : pass.writes)
+				use(edge);
+		};
+
+		compiled.merge = {};
+		index_type_t head = MAX_INDEX;
+		for (index_type_t k = 0; k < compiled.passes.size(); ++k)
+		{
+			auto& pass = compiled.passes[k];
+			bool render = pass.name != nullptr && pass.type == PASS_TYPE_RENDER;
+			auto mergeable = [&]() -> bool
+			{
+				auto const& first = compiled.passes[head];
+				if (pass.batch != first.batch || pass.colorAttachmentCount != first.colorAttachmentCount || pass.depthAttachment.valid != first.depthAttachment.valid)
+					return false;
+				for (auto j = 0; j < pass.colorAttachmentCount; ++j)
+				{
+					if (pass.colorAttachments[j].resourceIndex != first.colorAttachments[j].resourceIndex || pass.colorAttachments[j].load_action == CGPU_LOAD_ACTION_CLEAR)
+						return false;
+				}
+				if (pass.depthAttachment.valid && (pass.depthAttachment.resourceIndex != first.depthAttachment.resourceIndex || pass.depthAttachment.depth_load_action == CGPU_LOAD_ACTION_CLEAR || pass.depthAttachment.stencil_load_action == CGPU_LOAD_ACTION_CLEAR))
+					return false;
+
+				// no barrier can be placed inside the render pass, so anything the group already touched must be used the same way
+				for (auto& edge : pass.reads)
+				{
+					if (edge.usage == CGPU_RESOURCE_STATE_UNDEFINED || owners[keyOf(edge.index)] != head)
+						continue;
+					auto key = keyOf(edge.index);
+					if (roots[key] == rootOf(edge.index) && usages[key] == edge.usage && !is_forced_barrier(compiled.resources[edge.index].resourceType, edge.usage))
+						continue;
+					// sampling what the group wrote needs a barrier, cgpu render passes have a single subpass and no input attachments
+					return false;
+				}
+				for (auto& edge : pass.writes)
+				{
+					auto key = keyOf(edge.index);
+					if (owners[key] == head && (roots[key] != rootOf(edge.index) || (edge.usage != CGPU_RESOURCE_STATE_RENDER_TARGET && edge.usage != CGPU_RESOURCE_STATE_DEPTH_WRITE)))
+						return false;
+				}
+				return true;
+			};
+
+			if (render && head != MAX_INDEX && mergeable())
+			{
+				compiled.passes[head].mergedPassCount++;
+				pass.merged = true;
+				claim(pass, head);
+				++compiled.merge.merged_passes;
+				continue;
+			}
+
+			head = render ? k : MAX_INDEX;
+			if (render)
+				claim(pass, head);
 		}
+	}
 
-		for (index_type_t i = 0; i < resourceCount; ++i)
+	void plan_barriers(CompiledRenderGraph& compiled, std::pmr::memory_resource* const memory_resource)
+	{
+		std::pmr::vector<uint32_t> resourceExits(compiled.resources.size(), UINT32_MAX, memory_resource);
+		std::pmr::vector<uint32_t> blockExits(compiled.aliasBlocks.size(), UINT32_MAX, memory_resource);
+		std::pmr::vector<bool> known(memory_resource);
+		std::pmr::vector<ECGPUQueueType> owners(memory_resource);
+		std::pmr::vector<index_type_t> ownerBatches(memory_resource);
+		std::pmr::vector<index_type_t> lastPasses(memory_resource);
+		std::pmr::vector<index_type_t> computeBatches(memory_resource);
+		std::pmr::vector<bool> touched(compiled.resources.size(), false, memory_resource);
+		std::pmr::vector<std::pmr::vector<CompiledBarrier>> batchBarriers(compiled.batches.size(), memory_resource);
+
+		auto exitOf = [&](index_type_t root) -> uint32_t
 		{
-			auto const& resource = renderGraph.resources[i];
-			Node node(i, false, resource.manageType != ManageType::Managed, memory_resource);
-			nodes.emplace_back(std::move(node));
+			auto& resource = compiled.resources[root];
+			bool managed = resource.manageType == ManageType::Managed;
+			auto& exit = managed ? blockExits[resource.aliasBlock] : resourceExits[root];
+			if (exit == UINT32_MAX)
+			{
+				uint32_t count = resource.resourceType == ResourceType::Texture ? std::max<uint32_t>(resource.mipCount, 1) * std::max<uint32_t>(resource.arraySize, 1) : 1;
+				exit = compiled.exitStates.size();
+				compiled.exitStates.push_back({ root, managed ? resource.aliasBlock : MAX_INDEX, (uint32_t)compiled.states.size(), count, true });
+				compiled.states.resize(compiled.states.size() + count, CGPU_RESOURCE_STATE_UNDEFINED);
+				known.resize(compiled.states.size(), false);
+				owners.resize(compiled.states.size(), CGPU_QUEUE_TYPE_GRAPHICS);
+				ownerBatches.resize(compiled.states.size(), MAX_INDEX);
+				lastPasses.resize(compiled.states.size(), MAX_INDEX);
+				computeBatches.push_back(MAX_INDEX);
+				if (managed)
+					compiled.aliasBlocks[resource.aliasBlock].exitState = exit;
+			}
+			return exit;
+		};
+
+		struct Release
+		{
+			uint32_t acquire;
+			index_type_t batch;
+			uint32_t index;
+		};
+		std::pmr::vector<Release> releases(memory_resource);
+
+		compiled.schedule.split_barrier_count = 0;
+		index_type_t groupHead = 0;
+		for (auto& pass : compiled.passes)
+		{
+			pass.barrierOffset = compiled.barriers.size();
+			releases.clear();
+			auto& batch = compiled.batches[pass.batch];
+			if (!pass.merged)
+				groupHead = &pass - compiled.passes.data();
+
+			// a transition can start once its producer's group is done, which only pays off if a whole group that leaves the resource alone runs in between
+			auto splitAfter = [&](index_type_t producer) -> index_type_t
+			{
+				if (producer == MAX_INDEX || compiled.passes[producer].batch != pass.batch || producer + compiled.passes[producer].mergedPassCount >= groupHead)
+					return MAX_INDEX;
+				return producer;
+			};
+			auto request = [&](const CompiledEdge& edge)
+			{
+				if (edge.usage == CGPU_RESOURCE_STATE_UNDEFINED)
+					return;
+
+				auto const& resource = compiled.resources[edge.index];
+				index_type_t root = resource.manageType == ManageType::SubResource ? resource.parent : edge.index;
+				auto exitIndex = exitOf(root);
+				auto const& exit = compiled.exitStates[exitIndex];
+				// transient contents are undefined until their first use, so only keep what was written this frame or imported
+				bool handover = compiled.resources[root].manageType != ManageType::Managed || touched[root];
+				touched[root] = true;
+				auto mipCount = std::max<uint32_t>(compiled.resources[root].mipCount, 1);
+				auto states = compiled.states.begin() + exit.stateOffset;
+				auto knowns = known.begin() + exit.stateOffset;
+				auto queues = owners.begin() + exit.stateOffset;
+				auto queueBatches = ownerBatches.begin() + exit.stateOffset;
+				auto producers = lastPasses.begin() + exit.stateOffset;
+				// merged passes keep drawing into the attachments of the render pass they joined
+				bool attachment = edge.usage == CGPU_RESOURCE_STATE_RENDER_TARGET || edge.usage == CGPU_RESOURCE_STATE_DEPTH_WRITE;
+				bool force = is_forced_barrier(resource.resourceType, edge.usage) && !(pass.merged && attachment);
+
+				if (pass.queue == CGPU_QUEUE_TYPE_COMPUTE)
+					computeBatches[exitIndex] = pass.batch;
+				else if (computeBatches[exitIndex] != MAX_INDEX && (batch.wait == MAX_INDEX || batch.wait < computeBatches[exitIndex]))
+					batch.wait = computeBatches[exitIndex];
+
+				auto emit = [&](ECGPUResourceState src_state, bool entry, bool subresource, uint8_t mipLevel, uint8_t arraySlice, index_type_t releaseBatch, index_type_t producer)
+				{
+					for (auto j = pass.barrierOffset; j < compiled.barriers.size(); ++j)
+					{
+						auto& barrier = compiled.barriers[j];
+						if (barrier.resource == root && barrier.subresource == subresource && barrier.mipLevel == mipLevel && barrier.arraySlice == arraySlice)
+						{
+							barrier.dst_state = edge.usage;
+							for (auto& release : releases)
+							{
+								if (release.acquire == j)
+									batchBarriers[release.batch][release.index].dst_state = edge.usage;
+							}
+							return;
+						}
+					}
+					if (releaseBatch == MAX_INDEX)
+					{
+						compiled.barriers.push_back({ root, src_state, edge.usage, mipLevel, arraySlice, subresource, entry, QueueTransfer::None, pass.queue, entry ? MAX_INDEX : splitAfter(producer) });
+						return;
+					}
+
+					// both halves of an ownership transfer must describe the same transition
+					auto source = compiled.batches[releaseBatch].queue;
+					releases.push_back({ (uint32_t)compiled.barriers.size(), releaseBatch, (uint32_t)batchBarriers[releaseBatch].size() });
+					compiled.barriers.push_back({ root, src_state, edge.usage, mipLevel, arraySlice, subresource, entry, QueueTransfer::Acquire, source });
+					batchBarriers[releaseBatch].push_back({ root, src_state, edge.usage, mipLevel, arraySlice, subresource, entry, QueueTransfer::Release, pass.queue });
+				};
+
+				auto touch = [&](uint32_t j, bool subresource, uint8_t mipLevel, uint8_t arraySlice, index_type_t producer)
+				{
+					index_type_t releaseBatch = MAX_INDEX;
+					if (queues[j] != pass.queue && handover)
+						releaseBatch = knowns[j] ? queueBatches[j] : pass.batch - 1;
+
+					if (!knowns[j])
+						emit(CGPU_RESOURCE_STATE_UNDEFINED, true, subresource, mipLevel, arraySlice, releaseBatch, MAX_INDEX);
+					else if (states[j] != edge.usage || force || releaseBatch != MAX_INDEX)
+						emit(states[j], false, subresource, mipLevel, arraySlice, releaseBatch, producer);
+				};
+
+				if (resource.manageType != ManageType::SubResource)
+				{
+					bool uniform = true;
+					for (uint32_t j = 1; j < exit.stateCount && uniform; ++j)
+						uniform = knowns[j] == knowns[0] && (!knowns[0] || states[j] == states[0]) && queues[j] == queues[0] && queueBatches[j] == queueBatches[0];
+
+					if (uniform)
+						touch(0, false, 0, 0, *std::max_element(producers, producers + exit.stateCount));
+					else
+					{
+						for (uint32_t j = 0; j < exit.stateCount; ++j)
+							touch(j, true, j % mipCount, j / mipCount, producers[j]);
+					}
+					std::fill(states, states + exit.stateCount, edge.usage);
+					std::fill(knowns, knowns + exit.stateCount, true);
+					std::fill(queues, queues + exit.stateCount, pass.queue);
+					std::fill(queueBatches, queueBatches + exit.stateCount, pass.batch);
+					std::fill(producers, producers + exit.stateCount, groupHead);
+				}
+				else
+				{
+					auto j = resource.mipLevel + resource.arraySlice * mipCount;
+					touch(j, true, resource.mipLevel, resource.arraySlice, producers[j]);
+					states[j] = edge.usage;
+					knowns[j] = true;
+					queues[j] = pass.queue;
+					queueBatches[j] = pass.batch;
+					producers[j] = groupHead;
+				}
+			};
+
+			for (auto& edge : pass.reads)
+				request(edge);
+			for (auto& edge : pass.writes)
+				request(edge);
+			pass.barrierCount = compiled.barriers.size() - pass.barrierOffset;
+
+			// a barrier that keeps the state only orders accesses and has nothing to overlap
+			for (auto j = pass.barrierOffset; j < compiled.barriers.size(); ++j)
+			{
+				auto& barrier = compiled.barriers[j];
+				if (barrier.src_state == barrier.dst_state)
+					barrier.splitAfter = MAX_INDEX;
+				if (barrier.splitAfter != MAX_INDEX)
+					++compiled.schedule.split_barrier_count;
+			}
 		}
 
-		for (index_type_t i = 0; i < passCount; ++i)
+		index_type_t lastBatch = compiled.batches.size() - 1;
+		for (index_type_t i = 0; i < compiled.exitStates.size(); ++i)
 		{
-			auto const& node = nodes[i];
-			for (index_type_t j = 0; j < node.ins.size(); ++j)
+			auto& exit = compiled.exitStates[i];
+			auto states = compiled.states.begin() + exit.stateOffset;
+			exit.consistent = std::all_of(states, states + exit.stateCount, [&](auto state) { return state == states[0]; });
+
+			// imported resources leave the frame owned by the graphics queue
+			if (exit.aliasBlock != MAX_INDEX)
+				continue;
+			auto mipCount = std::max<uint32_t>(compiled.resources[exit.resource].mipCount, 1);
+			for (uint32_t j = 0; j < exit.stateCount; ++j)
 			{
-				auto the_in = node.ins[j];
-				nodes[the_in].outs.push_back(i);
+				auto slot = exit.stateOffset + j;
+				if (!known[slot] || owners[slot] == CGPU_QUEUE_TYPE_GRAPHICS)
+					continue;
+				bool subresource = exit.stateCount > 1;
+				batchBarriers[ownerBatches[slot]].push_back({ exit.resource, states[j], states[j], uint8_t(j % mipCount), uint8_t(j / mipCount), subresource, false, QueueTransfer::Release, CGPU_QUEUE_TYPE_GRAPHICS });
+				batchBarriers[lastBatch].push_back({ exit.resource, states[j], states[j], uint8_t(j % mipCount), uint8_t(j / mipCount), subresource, false, QueueTransfer::Acquire, owners[slot] });
 			}
-			for (index_type_t j = 0; j < node.outs.size(); ++j)
+		}
+
+		// a binary semaphore is signalled once, so it may be waited on once; a queue that already waited on a later batch of the
+		// other queue is ordered after everything that queue submitted before it
+		index_type_t lastWaited[2] = { MAX_INDEX, MAX_INDEX };
+		for (index_type_t i = 0; i < compiled.batches.size(); ++i)
+		{
+			auto& batch = compiled.batches[i];
+			if (batch.queue == CGPU_QUEUE_TYPE_COMPUTE)
+				batch.wait = i - 1;
+			else if (i == lastBatch && i > 0)
+				batch.wait = i - 1;
+			auto& cursor = lastWaited[batch.queue == CGPU_QUEUE_TYPE_COMPUTE];
+			if (batch.wait != MAX_INDEX && cursor != MAX_INDEX && batch.wait <= cursor)
+				batch.wait = MAX_INDEX;
+			if (batch.wait != MAX_INDEX)
 			{
-				auto the_out = node.outs[j];
-				nodes[the_out].ins.push_back(i);
+				cursor = batch.wait;
+				compiled.batches[batch.wait].signal = true;
 			}
+
+			batch.barrierOffset = compiled.barriers.size();
+			batch.barrierCount = batchBarriers[i].size();
+			compiled.barriers.insert(compiled.barriers.end(), batchBarriers[i].begin(), batchBarriers[i].end());
 		}
+	}
 
-		for (auto i = 0; i < nodes.size(); ++i)
+	struct CompileNode
+	{
+		bool is_culled() const
+		{
+			return ref_count == 0 && !is_persistent;
+		}
+
+		index_type_t index = 0;
+		uint32_t ref_count = 0;
+		bool is_pass;
+		bool is_persistent{ false };
+	};
+
+	// compressed sparse rows, the edges of row i are edges[offsets[i]] to edges[offsets[i + 1] - 1]
+	struct EdgeRows
+	{
+		EdgeRows(std::pmr::memory_resource* const memory_resource)
+			: offsets(memory_resource), edges(memory_resource)
 		{
-			auto& node = nodes[i];
-			node.ref_count = node.outs.size();
 		}
 
+		std::span<const uint32_t> row(index_type_t i) const
+		{
+			return { edges.data() + offsets[i], edges.data() + offsets[i + 1] };
+		}
+
+		std::pmr::vector<uint32_t> offsets;
+		std::pmr::vector<uint32_t> edges;
+	};
+
+	template<typename RowOf>
+	void build_edge_rows(EdgeRows& rows, size_t rowCount, const std::pmr::vector<uint32_t>& edges, RowOf rowOf)
+	{
+		// counting sort, stable so every row keeps declaration order
+		rows.offsets.assign(rowCount + 1, 0);
+		for (auto edge : edges)
+			rows.offsets[rowOf(edge) + 1]++;
+		for (size_t i = 0; i < rowCount; ++i)
+			rows.offsets[i + 1] += rows.offsets[i];
+
+		rows.edges.resize(edges.size());
+		for (auto edge : edges)
+			rows.edges[rows.offsets[rowOf(edge)]++] = edge;
+		for (size_t i = rowCount; i > 0; --i)
+			rows.offsets[i] = rows.offsets[i - 1];
+		rows.offsets[0] = 0;
+	}
+
+	struct CompileGraph
+	{
+		CompileGraph(std::pmr::memory_resource* const memory_resource)
+			: nodes(memory_resource), passReads(memory_resource), passWrites(memory_resource), resourceReads(memory_resource), resourceWrites(memory_resource)
+		{
+		}
+
+		std::pmr::vector<CompileNode> nodes;
+		EdgeRows passReads;
+		EdgeRows passWrites;
+		EdgeRows resourceReads;
+		EdgeRows resourceWrites;
+	};
+
+	CompileGraph cull_graph(const rendergraph_t& renderGraph, std::pmr::memory_resource* const memory_resource)
+	{
+		auto resourceCount = renderGraph.resources.size();
+		auto passCount = renderGraph.passes.size();
+		auto& edges = renderGraph.edges;
+
+		CompileGraph graph(memory_resource);
+		build_edge_rows(graph.passReads, passCount, renderGraph.read_edges, [&](uint32_t edge) { return edges[edge].to; });
+		build_edge_rows(graph.passWrites, passCount, renderGraph.write_edges, [&](uint32_t edge) { return edges[edge].from; });
+		build_edge_rows(graph.resourceReads, resourceCount, renderGraph.read_edges, [&](uint32_t edge) { return edges[edge].from; });
+		build_edge_rows(graph.resourceWrites, resourceCount, renderGraph.write_edges, [&](uint32_t edge) { return edges[edge].to; });
+
+		// a pass is referenced by the resources it writes, a resource by the passes reading it
+		auto& nodes = graph.nodes;
+		nodes.reserve(passCount + resourceCount);
+		for (index_type_t i = 0; i < passCount; ++i)
+		{
+			auto type = renderGraph.passes[i].type;
+			nodes.push_back({ i, (uint32_t)graph.passWrites.row(i).size(), true, type == PASS_TYPE_PRESENT || type == PASS_TYPE_HOLDON });
+		}
+		for (index_type_t i = 0; i < resourceCount; ++i)
+			nodes.push_back({ i, (uint32_t)graph.resourceReads.row(i).size(), false, renderGraph.resources[i].manageType != ManageType::Managed });
+
 		std::pmr::vector<index_type_t> cullingStack(memory_resource);
 		cullingStack.reserve(nodes.size());
 		for (auto i = 0; i < nodes.size(); ++i)
@@ -87,45 +565,68 @@ namespace HGEGraphics
 				cullingStack.push_back(i);
 		}
 
+		auto release = [&](index_type_t inNodeIndex)
+		{
+			auto& inNode = nodes[inNodeIndex];
+			assert(inNode.ref_count > 0);
+			inNode.ref_count--;
+			if (inNode.ref_count == 0 && !inNode.is_persistent)
+				cullingStack.push_back(inNodeIndex);
+		};
+
 		while (!cullingStack.empty())
 		{
 			auto index = cullingStack.back();
 			cullingStack.pop_back();
-			auto const& node = nodes[index];
 
-			for (auto i = 0; i < node.ins.size(); ++i)
+			if (index < passCount)
 			{
-				auto inNodeIndex = node.ins[i];
-				auto& inNode = nodes[inNodeIndex];
-				assert(inNode.ref_count > 0);
-				inNode.ref_count--;
-				if (inNode.ref_count == 0 && !inNode.is_persistent)
-					cullingStack.push_back(inNodeIndex);
+				for (auto edge : graph.passReads.row(index))
+					release(edges[edge].from + passCount);
+			}
+			else
+			{
+				for (auto edge : graph.resourceWrites.row(index - passCount))
+					release(edges[edge].from);
 			}
 		}
 
+		return graph;
+	}
+
+	CompiledRenderGraph emit_compiled_graph(const rendergraph_t& renderGraph, const CompileGraph& graph, const std::pmr::vector<index_type_t>& order, std::pmr::memory_resource* const memory_resource)
+	{
+		auto resourceCount = renderGraph.resources.size();
+		auto passCount = renderGraph.passes.size();
+		auto& nodes = graph.nodes;
+
 		CompiledRenderGraph compiled(memory_resource);
-		auto usedPassCount = std::count_if(nodes.begin(), nodes.begin() + passCount, [](auto& node) {return !node.is_culled(); });
 		auto usedResourceCount = std::count_if(nodes.begin() + passCount, nodes.end(), [](auto& node) {return !node.is_culled(); });
-		compiled.passes.reserve(usedPassCount);
-		for (auto i = 0; i < passCount; ++i)
+		compiled.passes.reserve(passCount);
+		std::pmr::vector<index_type_t> position(passCount, memory_resource);
+		for (auto k = 0; k < passCount; ++k)
 		{
+			auto i = order[k];
+			position[i] = k;
 			auto const& node = nodes[i];
 			auto const& pass = renderGraph.passes[node.index];
 			if (!node.is_culled())
 			{
 				auto& compiledPass = compiled.passes.emplace_back(pass.name, memory_resource);
 				compiledPass.type = pass.type;
+				compiledPass.source = i;
 
-				compiledPass.reads.reserve(pass.reads.size());
-				for (auto edgeIndex : pass.reads)
+				auto reads = graph.passReads.row(i);
+				compiledPass.reads.reserve(reads.size());
+				for (auto edgeIndex : reads)
 				{
 					auto& edge = renderGraph.edges[edgeIndex];
 					compiledPass.reads.emplace_back(edge.from, edge.usage);
 				}
 
-				compiledPass.writes.reserve(pass.writes.size());
-				for (auto edgeIndex : pass.writes)
+				auto writes = graph.passWrites.row(i);
+				compiledPass.writes.reserve(writes.size());
+				for (auto edgeIndex : writes)
 				{
 					auto& edge = renderGraph.edges[edgeIndex];
 					compiledPass.writes.emplace_back(edge.to, edge.usage);
@@ -148,6 +649,8 @@ namespace HGEGraphics
 				else if (pass.type == PASS_TYPE_UPLOAD_TEXTURE)
 				{
 					compiledPass.staging_buffer = pass.upload_texture_context.staging_buffer.index;
+					compiledPass.staging_offset = pass.upload_texture_context.staging_offset;
+					compiledPass.staging_size = pass.upload_texture_context.staging_size;
 					compiledPass.dest_texture = pass.upload_texture_context.dest_texture.index;
 					compiledPass.uploadTextureExecutable = pass.upload_texture_context.executable;
 					compiledPass.size = pass.upload_texture_context.size;
@@ -155,10 +658,14 @@ namespace HGEGraphics
 					compiledPass.data = pass.upload_texture_context.data;
 					compiledPass.mipmap = pass.upload_texture_context.mipmap;
 					compiledPass.slice = pass.upload_texture_context.slice;
+					compiledPass.mipCount = pass.upload_texture_context.mipCount;
+					compiledPass.sliceCount = pass.upload_texture_context.sliceCount;
 				}
 				else if (pass.type == PASS_TYPE_UPLOAD_BUFFER)
 				{
 					compiledPass.staging_buffer = pass.upload_buffer_context.staging_buffer.index;
+					compiledPass.staging_offset = pass.upload_buffer_context.staging_offset;
+					compiledPass.staging_size = pass.upload_buffer_context.staging_size;
 					compiledPass.dest_buffer = pass.upload_buffer_context.dest_buffer.index;
 					compiledPass.uploadTextureExecutable = pass.upload_buffer_context.executable;
 					compiledPass.size = pass.upload_buffer_context.size;
@@ -169,10 +676,18 @@ namespace HGEGraphics
 			}
 			else
 			{
-				compiled.passes.emplace_back();
+				compiled.passes.emplace_back().source = i;
 			}
 		}
 
+		struct Lifetime
+		{
+			index_type_t resource;
+			index_type_t first;
+			index_type_t last;
+		};
+		std::pmr::vector<Lifetime> lifetimes(memory_resource);
+
 		compiled.resources.reserve(usedResourceCount);
 		for (auto i = 0; i < resourceCount; ++i)
 		{
@@ -181,23 +696,27 @@ namespace HGEGraphics
 			if (!node.is_culled())
 			{
 				if (resource.resourceType == ResourceType::Texture)
-					compiled.resources.emplace_back(resource.name, resource.manageType, resource.width, resource.height, resource.depth, resource.format, resource.texture, resource.mipCount, resource.arraySize, resource.parent, resource.mipLevel, resource.arraySlice);
+					compiled.resources.emplace_back(resource.name, resource.manageType, resource.width, resource.height, resource.depth, resource.format, resource.texture, resource.mipCount, resource.arraySize, resource.sampleCount, resource.textureType, resource.bucketed, resource.parent, resource.mipLevel, resource.arraySlice);
 				else if (resource.resourceType == ResourceType::Buffer)
 					compiled.resources.emplace_back(resource.name, resource.manageType, resource.size, resource.buffer, resource.bufferType, resource.memoryUsage);
+				if (resource.manageType != ManageType::SubResource)
+					compiled.resources.back().allocationSize = estimate_resource_size(resource);
 			
 				if (resource.manageType == ManageType::Managed)
 				{
 					index_type_t first = MAX_INDEX;
 					index_type_t last = 0;
-					if (!node.ins.empty())
+					for (auto edge : graph.resourceWrites.row(i))
 					{
-						first = std::min(first, node.ins.front());
-						last = std::max(last, node.ins.back());
+						auto pass = renderGraph.edges[edge].from;
+						first = std::min(first, position[pass]);
+						last = std::max(last, position[pass]);
 					}
-					if (!node.outs.empty())
+					for (auto edge : graph.resourceReads.row(i))
 					{
-						first = std::min(first, node.outs.front());
-						last = std::max(last, node.outs.back());
+						auto pass = renderGraph.edges[edge].to;
+						first = std::min(first, position[pass]);
+						last = std::max(last, position[pass]);
 					}
 					if (resource.holdOnLast)
 						last = passCount - 1;
@@ -206,6 +725,7 @@ namespace HGEGraphics
 					compiled.passes[first].devirtualize.push_back(i);
 					assert(last >= 0 && last < compiled.passes.size());
 					compiled.passes[last].destroy.push_back(i);
+					lifetimes.push_back({ (index_type_t)i, first, last });
 				}
 			}
 			else
@@ -214,21 +734,430 @@ namespace HGEGraphics
 			}
 		}
 
+		std::sort(lifetimes.begin(), lifetimes.end(), [](const Lifetime& a, const Lifetime& b) { return a.first < b.first; });
+		std::pmr::vector<index_type_t> blockFirst(memory_resource);
+		compiled.aliasBlocks.reserve(lifetimes.size());
+		compiled.transientMemory = {};
+		for (auto& lifetime : lifetimes)
+		{
+			auto const& resource = renderGraph.resources[lifetime.resource];
+			auto& compiledResource = compiled.resources[lifetime.resource];
+
+			index_type_t found = MAX_INDEX;
+			for (index_type_t j = 0; j < compiled.aliasBlocks.size(); ++j)
+			{
+				auto const& block = compiled.aliasBlocks[j];
+				if (block.lastPass >= lifetime.first || !can_alias(renderGraph.resources[block.resource], resource))
+					continue;
+				if (found == MAX_INDEX)
+				{
+					found = j;
+					continue;
+				}
+				auto const& best = compiled.aliasBlocks[found];
+				bool bestFits = best.size >= compiledResource.allocationSize;
+				bool blockFits = block.size >= compiledResource.allocationSize;
+				if ((blockFits && (!bestFits || block.size < best.size)) || (!blockFits && !bestFits && block.size > best.size))
+					found = j;
+			}
+
+			if (found == MAX_INDEX)
+			{
+				found = compiled.aliasBlocks.size();
+				compiled.aliasBlocks.push_back({ resource.resourceType, lifetime.resource, lifetime.last, compiledResource.allocationSize, nullptr, nullptr, MAX_INDEX });
+				blockFirst.push_back(lifetime.first);
+			}
+			else
+			{
+				auto& block = compiled.aliasBlocks[found];
+				block.lastPass = lifetime.last;
+				block.size = std::max(block.size, compiledResource.allocationSize);
+			}
+			compiledResource.aliasBlock = found;
+			if (resource.resourceType == ResourceType::Buffer)
+			{
+				compiled.transientMemory.requested_bytes += compiledResource.allocationSize;
+				compiled.transientMemory.resource_count++;
+			}
+		}
+
+		std::pmr::vector<int64_t> liveBytes(compiled.passes.size() + 1, 0, memory_resource);
+		for (index_type_t j = 0; j < compiled.aliasBlocks.size(); ++j)
+		{
+			if (compiled.aliasBlocks[j].resourceType != ResourceType::Buffer)
+				continue;
+			compiled.transientMemory.allocated_bytes += compiled.aliasBlocks[j].size;
+			compiled.transientMemory.block_count++;
+			liveBytes[blockFirst[j]] += compiled.aliasBlocks[j].size;
+			liveBytes[compiled.aliasBlocks[j].lastPass + 1] -= compiled.aliasBlocks[j].size;
+		}
+		int64_t live = 0;
+		for (auto delta : liveBytes)
+		{
+			live += delta;
+			compiled.transientMemory.peak_bytes = std::max<uint64_t>(compiled.transientMemory.peak_bytes, live);
+		}
+
+		assign_queues(compiled, renderGraph.async_compute);
+		infer_attachment_actions(compiled, memory_resource);
+		merge_render_passes(compiled, memory_resource);
+		plan_barriers(compiled, memory_resource);
+
 		return compiled;
 	}
-	CompiledResourceNode::CompiledResourceNode(const char8_t* name, ManageType type, uint16_t width, uint16_t height, uint16_t depth, ECGPUFormat format, Texture* imported_texture, uint8_t mipCount, uint8_t arraySize, index_type_t parent, uint8_t mipLevel, uint8_t arraySlice)
+	// the transitions an order needs by the rule the scheduler ranks passes with, cheap enough to compare orders without emitting them
+	uint32_t count_transitions(const rendergraph_t& renderGraph, const CompileGraph& graph, const std::pmr::vector<index_type_t>& order, std::pmr::memory_resource* const memory_resource)
+	{
+		auto rootOf = [&](index_type_t resource) -> index_type_t
+		{
+			auto const& node = renderGraph.resources[resource];
+			return node.manageType == ManageType::SubResource ? node.parent : resource;
+		};
+
+		std::pmr::vector<ECGPUResourceState> states(renderGraph.resources.size(), CGPU_RESOURCE_STATE_UNDEFINED, memory_resource);
+		uint32_t count = 0;
+		auto visit = [&](index_type_t resource, ECGPUResourceState usage)
+		{
+			if (usage == CGPU_RESOURCE_STATE_UNDEFINED)
+				return;
+			auto& state = states[rootOf(resource)];
+			if (state != usage || is_forced_barrier(renderGraph.resources[resource].resourceType, usage))
+				++count;
+			state = usage;
+		};
+		for (auto passIndex : order)
+		{
+			if (graph.nodes[passIndex].is_culled())
+				continue;
+			for (auto edgeIndex : graph.passReads.row(passIndex))
+				visit(renderGraph.edges[edgeIndex].from, renderGraph.edges[edgeIndex].usage);
+			for (auto edgeIndex : graph.passWrites.row(passIndex))
+				visit(renderGraph.edges[edgeIndex].to, renderGraph.edges[edgeIndex].usage);
+		}
+		return count;
+	}
+
+	std::pmr::vector<index_type_t> schedule_passes(const rendergraph_t& renderGraph, const CompileGraph& graph, std::pmr::memory_resource* const memory_resource)
+	{
+		auto& nodes = graph.nodes;
+		auto resourceCount = renderGraph.resources.size();
+		auto passCount = renderGraph.passes.size();
+
+		auto rootOf = [&](index_type_t resource) -> index_type_t
+		{
+			auto const& node = renderGraph.resources[resource];
+			return node.manageType == ManageType::SubResource ? node.parent : resource;
+		};
+
+		std::pmr::vector<std::pmr::vector<index_type_t>> successors(passCount, memory_resource);
+		std::pmr::vector<uint32_t> indegree(passCount, 0, memory_resource);
+		auto depend = [&](index_type_t from, index_type_t to)
+		{
+			if (from == MAX_INDEX || from == to)
+				return;
+			successors[from].push_back(to);
+			indegree[to]++;
+		};
+
+		std::pmr::vector<index_type_t> lastWriter(resourceCount, MAX_INDEX, memory_resource);
+		std::pmr::vector<std::pmr::vector<index_type_t>> readers(resourceCount, memory_resource);
+
+		for (index_type_t i = 0; i < passCount; ++i)
+		{
+			if (nodes[i].is_culled())
+				continue;
+			for (auto edgeIndex : graph.passReads.row(i))
+			{
+				auto root = rootOf(renderGraph.edges[edgeIndex].from);
+				depend(lastWriter[root], i);
+				readers[root].push_back(i);
+			}
+			for (auto edgeIndex : graph.passWrites.row(i))
+			{
+				auto root = rootOf(renderGraph.edges[edgeIndex].to);
+				depend(lastWriter[root], i);
+				for (auto reader : readers[root])
+					depend(reader, i);
+				readers[root].clear();
+				lastWriter[root] = i;
+			}
+		}
+
+		std::pmr::vector<ECGPUResourceState> states(resourceCount, CGPU_RESOURCE_STATE_UNDEFINED, memory_resource);
+		auto transitions = [&](index_type_t passIndex) -> uint32_t
+		{
+			uint32_t count = 0;
+			auto visit = [&](index_type_t resource, ECGPUResourceState usage)
+			{
+				if (usage != CGPU_RESOURCE_STATE_UNDEFINED && (states[rootOf(resource)] != usage || is_forced_barrier(renderGraph.resources[resource].resourceType, usage)))
+					++count;
+			};
+			for (auto edgeIndex : graph.passReads.row(passIndex))
+				visit(renderGraph.edges[edgeIndex].from, renderGraph.edges[edgeIndex].usage);
+			for (auto edgeIndex : graph.passWrites.row(passIndex))
+				visit(renderGraph.edges[edgeIndex].to, renderGraph.edges[edgeIndex].usage);
+			return count;
+		};
+
+		std::pmr::vector<index_type_t> ready(memory_resource);
+		for (index_type_t i = 0; i < passCount; ++i)
+		{
+			if (!nodes[i].is_culled() && indegree[i] == 0)
+				ready.push_back(i);
+		}
+
+		std::pmr::vector<index_type_t> order(memory_resource);
+		order.reserve(passCount);
+		index_type_t previous = MAX_INDEX;
+		while (!ready.empty())
+		{
+			// uploads first, then fewest transitions, then keep producer and consumer apart, then declaration order
+			auto score = [&](index_type_t passIndex)
+			{
+				auto type = renderGraph.passes[passIndex].type;
+				bool upload = type == PASS_TYPE_UPLOAD_TEXTURE || type == PASS_TYPE_UPLOAD_BUFFER;
+				bool consumer = previous != MAX_INDEX && std::find(successors[previous].begin(), successors[previous].end(), passIndex) != successors[previous].end();
+				return std::make_tuple(!upload, transitions(passIndex), consumer, passIndex);
+			};
+
+			auto best = ready.begin();
+			auto bestScore = score(*best);
+			for (auto iter = ready.begin() + 1; iter != ready.end(); ++iter)
+			{
+				auto iterScore = score(*iter);
+				if (iterScore < bestScore)
+				{
+					best = iter;
+					bestScore = iterScore;
+				}
+			}
+
+			auto passIndex = *best;
+			ready.erase(best);
+			order.push_back(passIndex);
+			previous = passIndex;
+
+			for (auto edgeIndex : graph.passReads.row(passIndex))
+			{
+				auto& edge = renderGraph.edges[edgeIndex];
+				if (edge.usage != CGPU_RESOURCE_STATE_UNDEFINED)
+					states[rootOf(edge.from)] = edge.usage;
+			}
+			for (auto edgeIndex : graph.passWrites.row(passIndex))
+			{
+				auto& edge = renderGraph.edges[edgeIndex];
+				if (edge.usage != CGPU_RESOURCE_STATE_UNDEFINED)
+					states[rootOf(edge.to)] = edge.usage;
+			}
+
+			for (auto successor : successors[passIndex])
+			{
+				if (--indegree[successor] == 0)
+					ready.push_back(successor);
+			}
+		}
+
+		for (index_type_t i = 0; i < passCount; ++i)
+		{
+			if (nodes[i].is_culled())
+				order.push_back(i);
+		}
+		assert(order.size() == passCount);
+		return order;
+	}
+
+	CompiledRenderGraph Compiler::Compile(const rendergraph_t& renderGraph, std::pmr::memory_resource* const memory_resource)
+	{
+		auto graph = cull_graph(renderGraph, memory_resource);
+
+		std::pmr::vector<index_type_t> order(renderGraph.passes.size(), memory_resource);
+		for (index_type_t i = 0; i < order.size(); ++i)
+			order[i] = i;
+
+		uint32_t declaredTransitions = count_transitions(renderGraph, graph, order, memory_resource);
+		if (!renderGraph.reorder_passes)
+		{
+			auto compiled = emit_compiled_graph(renderGraph, graph, order, memory_resource);
+			compiled.schedule.reordered = false;
+			compiled.schedule.declared_barrier_count = compiled.schedule.scheduled_barrier_count = declaredTransitions;
+			return compiled;
+		}
+
+		order = schedule_passes(renderGraph, graph, memory_resource);
+		auto compiled = emit_compiled_graph(renderGraph, graph, order, memory_resource);
+		compiled.schedule.reordered = true;
+		compiled.schedule.declared_barrier_count = declaredTransitions;
+		compiled.schedule.scheduled_barrier_count = count_transitions(renderGraph, graph, order, memory_resource);
+		return compiled;
+	}
+
+	void build_signature(const rendergraph_t& renderGraph, std::pmr::vector<uint32_t>& signature)
+	{
+		signature.clear();
+		auto push = [&signature](uint32_t value) { signature.push_back(value); };
+
+		push(renderGraph.reorder_passes);
+		push(renderGraph.async_compute);
+		push(renderGraph.resources.size());
+		for (auto const& resource : renderGraph.resources)
+		{
+			push(uint32_t(resource.resourceType) | (uint32_t(resource.manageType) << 8) | (uint32_t(resource.holdOnLast) << 16));
+			push(resource.width | (uint32_t(resource.height) << 16));
+			push(resource.depth | (uint32_t(resource.mipCount) << 16) | (uint32_t(resource.arraySize) << 24));
+			push(resource.format);
+			push(resource.sampleCount | (uint32_t(resource.bucketed) << 8));
+			push(resource.textureType);
+			push(resource.size);
+			push(resource.parent);
+			push(resource.mipLevel | (uint32_t(resource.arraySlice) << 8));
+			push(resource.bufferType);
+			push(resource.memoryUsage);
+		}
+
+		push(renderGraph.edges.size());
+		for (auto const& edge : renderGraph.edges)
+		{
+			push(edge.from);
+			push(edge.to);
+			push(edge.usage);
+		}
+
+		push(renderGraph.read_edges.size());
+		for (auto edge : renderGraph.read_edges)
+			push(edge);
+		push(renderGraph.write_edges.size());
+		for (auto edge : renderGraph.write_edges)
+			push(edge);
+
+		push(renderGraph.passes.size());
+		for (auto const& pass : renderGraph.passes)
+		{
+			push(pass.type);
+
+			if (pass.type == PASS_TYPE_RENDER)
+			{
+				push(pass.render_context.colorAttachmentCount);
+				for (auto j = 0; j < pass.render_context.colorAttachmentCount; ++j)
+				{
+					auto const& attachment = pass.render_context.colorAttachments[j];
+					push(attachment.resourceIndex);
+					push(attachment.load_action | (uint32_t(attachment.store_action) << 8) | (uint32_t(attachment.auto_load) << 16) | (uint32_t(attachment.auto_store) << 17));
+				}
+				auto const& depth = pass.render_context.depthAttachment;
+				push(depth.valid);
+				push(depth.resourceIndex);
+				push(depth.depth_load_action | (uint32_t(depth.depth_store_action) << 8) | (uint32_t(depth.stencil_load_action) << 16) | (uint32_t(depth.stencil_store_action) << 24));
+				push(depth.auto_load | (uint32_t(depth.auto_store) << 1));
+			}
+			else if (pass.type == PASS_TYPE_UPLOAD_TEXTURE)
+			{
+				push(pass.upload_texture_context.staging_buffer.index);
+				push(pass.upload_texture_context.dest_texture.index);
+				push(pass.upload_texture_context.mipmap | (uint32_t(pass.upload_texture_context.slice) << 8) | (uint32_t(pass.upload_texture_context.mipCount) << 16) | (uint32_t(pass.upload_texture_context.sliceCount) << 24));
+			}
+			else if (pass.type == PASS_TYPE_UPLOAD_BUFFER)
+			{
+				push(pass.upload_buffer_context.staging_buffer.index);
+				push(pass.upload_buffer_context.dest_buffer.index);
+			}
+		}
+	}
+
+	void patch_compiled_graph(const rendergraph_t& renderGraph, CompiledRenderGraph& compiled)
+	{
+		for (auto& compiledPass : compiled.passes)
+		{
+			if (compiledPass.name == nullptr)
+				continue;
+			auto const& pass = renderGraph.passes[compiledPass.source];
+
+			compiledPass.name = pass.name;
+			compiledPass.passdata = pass.passdata;
+			if (pass.type == PASS_TYPE_RENDER)
+			{
+				for (auto j = 0; j < pass.render_context.colorAttachmentCount; ++j)
+					compiledPass.colorAttachments[j].clearColor = pass.render_context.colorAttachments[j].clearColor;
+				compiledPass.depthAttachment.clearDepth = pass.render_context.depthAttachment.clearDepth;
+				compiledPass.depthAttachment.clearStencil = pass.render_context.depthAttachment.clearStencil;
+				compiledPass.executable = pass.render_context.executable;
+			}
+			else if (pass.type == PASS_TYPE_COMPUTE)
+			{
+				compiledPass.executable = pass.compute_context.executable;
+			}
+			else if (pass.type == PASS_TYPE_UPLOAD_TEXTURE)
+			{
+				// arena offsets move every frame while the staging block stays the same resource
+				compiledPass.staging_offset = pass.upload_texture_context.staging_offset;
+				compiledPass.staging_size = pass.upload_texture_context.staging_size;
+				compiledPass.uploadTextureExecutable = pass.upload_texture_context.executable;
+				compiledPass.size = pass.upload_texture_context.size;
+				compiledPass.offset = pass.upload_texture_context.offset;
+				compiledPass.data = pass.upload_texture_context.data;
+			}
+			else if (pass.type == PASS_TYPE_UPLOAD_BUFFER)
+			{
+				compiledPass.staging_offset = pass.upload_buffer_context.staging_offset;
+				compiledPass.staging_size = pass.upload_buffer_context.staging_size;
+				compiledPass.uploadTextureExecutable = pass.upload_buffer_context.executable;
+				compiledPass.size = pass.upload_buffer_context.size;
+				compiledPass.offset = pass.upload_buffer_context.offset;
+				compiledPass.data = pass.upload_buffer_context.data;
+			}
+		}
+
+		for (index_type_t i = 0; i < renderGraph.resources.size(); ++i)
+		{
+			auto const& resource = renderGraph.resources[i];
+			auto& compiledResource = compiled.resources[i];
+			compiledResource.name = resource.name;
+			if (resource.manageType == ManageType::Imported)
+			{
+				if (resource.resourceType == ResourceType::Texture)
+					compiledResource.imported_texture = resource.texture;
+				else
+					compiledResource.imported_buffer = resource.buffer;
+			}
+		}
+	}
+
+	CompiledRenderGraph& Compiler::Compile(const rendergraph_t& renderGraph, CompileCache& cache)
+	{
+		build_signature(renderGraph, cache.pending_signature);
+		uint32_t hash = cache.pending_signature.empty() ? 0 : murmur3(cache.pending_signature.data(), cache.pending_signature.size(), 0);
+		if (cache.compiled && hash == cache.hash && cache.pending_signature == cache.signature)
+		{
+			++cache.hits;
+			patch_compiled_graph(renderGraph, *cache.compiled);
+			return *cache.compiled;
+		}
+
+		++cache.misses;
+		cache.compiled.reset();
+		cache.compiled.emplace(Compile(renderGraph, &cache.memory_resource));
+		cache.signature.swap(cache.pending_signature);
+		cache.hash = hash;
+		return *cache.compiled;
+	}
+
+	CompileCache::CompileCache(std::pmr::memory_resource* const memory_resource)
+		: memory_resource(memory_resource), signature(memory_resource), pending_signature(memory_resource)
+	{
+	}
+
+	CompiledResourceNode::CompiledResourceNode(const char8_t* name, ManageType type, uint16_t width, uint16_t height, uint16_t depth, ECGPUFormat format, Texture* imported_texture, uint8_t mipCount, uint8_t arraySize, uint8_t sampleCount, CGPUResourceTypes textureType, bool bucketed, index_type_t parent, uint8_t mipLevel, uint8_t arraySlice)
 		: name(name), resourceType(ResourceType::Texture), manageType(type), width(width), height(height), depth(depth), format(format), imported_texture(imported_texture), imported_buffer(CGPU_NULLPTR), managered_texture(nullptr), size(0), managed_buffer(nullptr), bufferType(CGPU_RESOURCE_TYPE_NONE), memoryUsage(CGPU_MEM_USAGE_UNKNOWN)
-		, mipCount(mipCount), arraySize(arraySize), parent(parent), mipLevel(mipLevel), arraySlice(arraySlice)
+		, mipCount(mipCount), arraySize(arraySize), sampleCount(sampleCount), textureType(textureType), bucketed(bucketed), parent(parent), mipLevel(mipLevel), arraySlice(arraySlice), aliasBlock(MAX_INDEX), allocationSize(0)
 	{
 	}
 	CompiledResourceNode::CompiledResourceNode(const char8_t* name, ManageType type, uint32_t size, Buffer* imported_buffer, CGPUResourceTypes bufferType, ECGPUMemoryUsage memoryUsage)
 		: name(name), resourceType(ResourceType::Buffer), manageType(type), size(size), width(0), height(0), depth(0), format(CGPU_FORMAT_UNDEFINED), imported_texture(CGPU_NULLPTR), imported_buffer(imported_buffer), managered_texture(nullptr), managed_buffer(nullptr), bufferType(bufferType), memoryUsage(memoryUsage)
-		, mipCount(0), arraySize(0), parent(0), mipLevel(0), arraySlice(0)
+		, mipCount(0), arraySize(0), sampleCount(0), textureType(CGPU_RESOURCE_TYPE_NONE), bucketed(false), parent(0), mipLevel(0), arraySlice(0), aliasBlock(MAX_INDEX), allocationSize(0)
 	{
 	}
 	CompiledResourceNode::CompiledResourceNode()
 		: name(nullptr), resourceType(ResourceType::Texture), manageType(ManageType::Managed), width(0), height(0), depth(0), format(CGPU_FORMAT_UNDEFINED), imported_texture(nullptr), imported_buffer(CGPU_NULLPTR), managered_texture(nullptr), size(0), managed_buffer(nullptr), bufferType(CGPU_RESOURCE_TYPE_NONE), memoryUsage(CGPU_MEM_USAGE_UNKNOWN)
-		, mipCount(0), arraySize(0), parent(0), mipLevel(0), arraySlice(0)
+		, mipCount(0), arraySize(0), sampleCount(0), textureType(CGPU_RESOURCE_TYPE_NONE), bucketed(false), parent(0), mipLevel(0), arraySlice(0), aliasBlock(MAX_INDEX), allocationSize(0)
 	{
 	}
 	CompiledRenderPassNode::CompiledRenderPassNode(const char8_t* name, std::pmr::memory_resource* const memory_resource)
@@ -236,11 +1165,11 @@ namespace HGEGraphics
 	{
 	}
 	CompiledRenderPassNode::CompiledRenderPassNode()
-		: name(nullptr), type(PASS_TYPE_HOLDON), passdata(nullptr)
+		: name(nullptr), type(PASS_TYPE_HOLDON), source(0), passdata(nullptr)
 	{
 	}
 	CompiledRenderGraph::CompiledRenderGraph(std::pmr::memory_resource* const memory_resource)
-		: passes(memory_resource), resources(memory_resource)
+		: passes(memory_resource), resources(memory_resource), aliasBlocks(memory_resource), barriers(memory_resource), exitStates(memory_resource), states(memory_resource), batches(memory_resource), transientMemory({}), schedule({}), merge({}), attachmentActions({})
 	{
 	}
 
@@ -252,22 +1181,24 @@ namespace HGEGraphics
 		return buffer;
 	}
 
+	static Texture* resolve_texture(CompiledRenderGraph* crg, const CompiledResourceNode& resourceNode)
+	{
+		if (resourceNode.manageType == ManageType::Managed)
+			return resourceNode.managered_texture->texture;
+		else if (resourceNode.manageType == ManageType::Imported)
+			return resourceNode.imported_texture;
+
+		auto& parentResource = crg->resources[resourceNode.parent];
+		assert(parentResource.parent == 0 && parentResource.resourceType == ResourceType::Texture);
+		return parentResource.manageType == ManageType::Managed ? parentResource.managered_texture->texture : parentResource.imported_texture;
+	}
+
 	CGPUTextureViewId rendergraph_resolve_texture_view(RenderPassEncoder* encoder, texture_handle_t texture_handle)
 	{
 		auto crg = encoder->compiled_graph;
 		auto& resourceNode = crg->resources[texture_handle.index];
 		CGPUTextureViewDescriptor desc = {};
-		Texture* texture;
-		if (resourceNode.manageType == ManageType::Managed)
-			texture = resourceNode.managered_texture->texture;
-		else if (resourceNode.manageType == ManageType::Imported)
-			texture = resourceNode.imported_texture;
-		else
-		{
-			auto& parentResource = crg->resources[resourceNode.parent];
-			assert(parentResource.parent == 0 && parentResource.resourceType == ResourceType::Texture);
-			texture = parentResource.manageType == ManageType::Managed ? parentResource.managered_texture->texture : parentResource.imported_texture;
-		}
+		Texture* texture = resolve_texture(crg, resourceNode);
 		desc.texture = texture->handle;
 		desc.format = texture->handle->info->format;
 		desc.usages = CGPU_TVU_SRV;
@@ -277,7 +1208,24 @@ namespace HGEGraphics
 		desc.array_layer_count = resourceNode.manageType != ManageType::SubResource ? texture->handle->info->array_size_minus_one + 1 : 1;
 		desc.base_mip_level = resourceNode.mipLevel;
 		desc.mip_level_count = resourceNode.manageType != ManageType::SubResource ? texture->handle->info->mip_levels : 1;
-		auto textureView = encoder->context->textureViewPool.getResource(desc);
-		return textureView->handle;
+		return encoder->worker->getTextureView(encoder->context, desc);
+	}
+
+	CGPUTextureViewId rendergraph_resolve_texture_uav(RenderPassEncoder* encoder, texture_handle_t texture_handle)
+	{
+		auto crg = encoder->compiled_graph;
+		auto& resourceNode = crg->resources[texture_handle.index];
+		CGPUTextureViewDescriptor desc = {};
+		Texture* texture = resolve_texture(crg, resourceNode);
+		desc.texture = texture->handle;
+		desc.format = texture->handle->info->format;
+		desc.usages = CGPU_TVU_UAV;
+		desc.aspects = CGPU_TVA_COLOR;
+		desc.dims = texture->handle->info->depth > 1 ? CGPU_TEX_DIMENSION_3D : CGPU_TEX_DIMENSION_2D;
+		desc.base_array_layer = resourceNode.arraySlice;
+		desc.array_layer_count = 1;
+		desc.base_mip_level = resourceNode.mipLevel;
+		desc.mip_level_count = 1;
+		return encoder->worker->getTextureView(encoder->context, desc);
 	}
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "renderer.h"
 #include <cassert>
+#include <algorithm>
 
 namespace HGEGraphics
 {
@@ -26,142 +27,213 @@ namespace HGEGraphics
 		}
 	}
 
-	void place_barriers(ExecutorContext& context, CompiledRenderGraph& compiledRenderGraph, const CompiledRenderPassNode& pass, RuntimePass& runtime, CGPUCommandBufferId cmd)
+	struct ResolvedBarriers
 	{
-		uint32_t texture_barrier_count = 0;
-		uint32_t buffer_barrier_count = 0;
-		const size_t length = 16;
-		CGPUTextureBarrier texture_barriers[length];
-		CGPUBufferBarrier buffer_barriers[length];
-		auto place_texture_barriers_impl = [&](decltype(compiledRenderGraph.resources)& resources, const decltype(pass.reads)& edges, CGPUCommandBufferId cmd)
+		uint32_t textureOffset, textureCount;
+		uint32_t bufferOffset, bufferCount;
+	};
+
+	struct SplitBarrier
+	{
+		index_type_t after;
+		index_type_t before;
+		ResolvedBarriers resolved;
+	};
+
+	struct SplitBarriers
+	{
+		SplitBarriers(std::pmr::memory_resource* const memory_resource)
+			: barriers(memory_resource), begins(memory_resource)
+		{
+		}
+
+		// ordered by the pass that ends them, begins pairs the group that begins them with their slot
+		std::pmr::vector<SplitBarrier> barriers;
+		std::pmr::vector<std::pair<index_type_t, uint32_t>> begins;
+	};
+
+	bool split_barriers_supported(const ExecutorContext& context)
+	{
+		return context.splitBarrierBackend.begin && context.splitBarrierBackend.end;
+	}
+
+	// resolves the barriers of a range that begin after the given pass group, MAX_INDEX picks the ones placed whole
+	ResolvedBarriers resolve_barriers(ExecutorContext& context, CompiledRenderGraph& compiledRenderGraph, uint32_t barrierOffset, uint32_t barrierCount, index_type_t splitAfter)
+	{
+		auto& texture_barriers = context.texture_barriers;
+		auto& buffer_barriers = context.buffer_barriers;
+		bool split = split_barriers_supported(context);
+		ResolvedBarriers resolved = { (uint32_t)texture_barriers.size(), 0, (uint32_t)buffer_barriers.size(), 0 };
+		for (uint32_t i = barrierOffset; i < barrierOffset + barrierCount; ++i)
 		{
-			auto add_barrier = [](uint32_t& buffer_barrier_count, CGPUBufferBarrier buffer_barriers[], uint32_t& texture_barrier_count, CGPUTextureBarrier texture_barriers[], CGPUCommandBufferId cmd)
+			auto& barrier = compiledRenderGraph.barriers[i];
+			if ((split ? barrier.splitAfter : MAX_INDEX) != splitAfter)
+				continue;
+			auto& resource = compiledRenderGraph.resources[barrier.resource];
+			bool force = barrier.transfer != QueueTransfer::None || is_forced_barrier(resource.resourceType, barrier.dst_state);
+			if (resource.resourceType == ResourceType::Texture)
 			{
-				if (texture_barrier_count >= length || buffer_barrier_count >= length)
+				auto texture = getTexture(compiledRenderGraph.resources, resource);
+				auto add_barrier = [&](ECGPUResourceState src_state, bool subresource, uint8_t mipLevel, uint8_t arraySlice)
 				{
-					CGPUResourceBarrierDescriptor barrier_desc = { .buffer_barriers = buffer_barriers, .buffer_barriers_count = buffer_barrier_count, .texture_barriers = texture_barriers, .texture_barriers_count = texture_barrier_count, };
-					cgpu_cmd_resource_barrier(cmd, &barrier_desc);
-					texture_barrier_count = 0;
-					buffer_barrier_count = 0;
-				}
-			};
+					texture_barriers.push_back({
+						.texture = texture->handle,
+						.src_state = src_state,
+						.dst_state = barrier.dst_state,
+						.queue_acquire = barrier.transfer == QueueTransfer::Acquire,
+						.queue_release = barrier.transfer == QueueTransfer::Release,
+						.queue_type = barrier.queue,
+						.subresource_barrier = subresource,
+						.mip_level = mipLevel,
+						.array_layer = arraySlice,
+					});
+				};
 
-			for (auto& edge : edges)
-			{
-				auto& resource = resources[edge.index];
-				if (resource.resourceType == ResourceType::Texture && edge.usage != CGPU_RESOURCE_STATE_UNDEFINED)
+				if (!barrier.entry)
 				{
-					auto texture = getTexture(resources, resource);
-					auto force_barrier = edge.usage == CGPU_RESOURCE_STATE_RENDER_TARGET || edge.usage == CGPU_RESOURCE_STATE_DEPTH_WRITE || edge.usage == CGPU_RESOURCE_STATE_COPY_DEST;
-					if (resource.manageType != ManageType::SubResource)
-					{
-						if (texture->states_consistent == true || texture->cur_states.size() == 1)
-						{
-							auto cur_state = texture->cur_states[0];
-							if (cur_state != edge.usage || force_barrier)
-							{
-								texture_barriers[texture_barrier_count++] = {
-									.texture = texture->handle,
-									.src_state = cur_state,
-									.dst_state = edge.usage,
-									.subresource_barrier = 0,
-									.mip_level = 0,
-									.array_layer = 0,
-								};
-								add_barrier(buffer_barrier_count, buffer_barriers, texture_barrier_count, texture_barriers, cmd);
-								for (auto& state : texture->cur_states)
-									state = edge.usage;
-							}
-						}
-						else
-						{
-							for (size_t i = 0; i < texture->cur_states.size(); ++i)
-							{
-								auto& cur_state = texture->cur_states[i];
-								if (cur_state != edge.usage || force_barrier)
-								{
-									texture_barriers[texture_barrier_count++] = {
-										.texture = texture->handle,
-										.src_state = cur_state,
-										.dst_state = edge.usage,
-										.subresource_barrier = 1,
-										.mip_level = uint8_t(i % resource.mipCount),
-										.array_layer = uint8_t(i / resource.mipCount),
-									};
-									add_barrier(buffer_barrier_count, buffer_barriers, texture_barrier_count, texture_barriers, cmd);
-									cur_state = edge.usage;
-								}
-							}
-						}
-						texture->states_consistent = true;
-					}
-					else
-					{
-						auto& cur_state = texture->cur_states[resource.mipLevel + resource.arraySlice * resource.mipCount];
-						if (cur_state != edge.usage || force_barrier)
-						{
-							texture_barriers[texture_barrier_count++] = {
-								.texture = texture->handle,
-								.src_state = cur_state,
-								.dst_state = edge.usage,
-								.subresource_barrier = 1,
-								.mip_level = resource.mipLevel,
-								.array_layer = resource.arraySlice,
-							};
-							add_barrier(buffer_barrier_count, buffer_barriers, texture_barrier_count, texture_barriers, cmd);
-							cur_state = edge.usage;
-							texture->states_consistent = false;
-						}
-					}
+					add_barrier(barrier.src_state, barrier.subresource, barrier.mipLevel, barrier.arraySlice);
+				}
+				else if (barrier.subresource)
+				{
+					auto cur_state = texture->cur_states.uniform() ? texture->cur_states.get(0) : texture->cur_states.get(barrier.mipLevel + barrier.arraySlice * resource.mipCount);
+					if (cur_state != barrier.dst_state || force)
+						add_barrier(cur_state, true, barrier.mipLevel, barrier.arraySlice);
+				}
+				else if (texture->cur_states.uniform())
+				{
+					auto cur_state = texture->cur_states.get(0);
+					if (cur_state != barrier.dst_state || force)
+						add_barrier(cur_state, false, 0, 0);
 				}
-				else if (resource.resourceType == ResourceType::Buffer && edge.usage != CGPU_RESOURCE_STATE_UNDEFINED)
+				else
 				{
-					auto buffer = resource.manageType == ManageType::Managed ? resource.managed_buffer->handle : resource.imported_buffer->handle;
-					auto cur_state = resource.manageType == ManageType::Managed ? resource.managed_buffer->cur_state : resource.imported_buffer->cur_state;
-					auto force_barrier = edge.usage == CGPU_RESOURCE_STATE_COPY_DEST;
-					if (cur_state != edge.usage || force_barrier)
+					// runs already in the target state are skipped whole, cgpu barriers name one subresource at a time
+					for (uint32_t r = 0; r < texture->cur_states.runs(); ++r)
 					{
-						buffer_barriers[buffer_barrier_count++] = {
-							.buffer = buffer,
-							.src_state = cur_state,
-							.dst_state = edge.usage,
-						};
-						add_barrier(buffer_barrier_count, buffer_barriers, texture_barrier_count, texture_barriers, cmd);
-						if (resource.manageType == ManageType::Managed)
-							resource.managed_buffer->cur_state = edge.usage;
-						else
-							resource.imported_buffer->cur_state = edge.usage;
+						auto& run = texture->cur_states.run(r);
+						if (run.state == barrier.dst_state && !force)
+							continue;
+						for (uint32_t j = run.begin; j < run.end; ++j)
+							add_barrier(run.state, true, uint8_t(j % resource.mipCount), uint8_t(j / resource.mipCount));
 					}
 				}
 			}
-		};
+			else if (resource.resourceType == ResourceType::Buffer)
+			{
+				auto buffer = resource.manageType == ManageType::Managed ? resource.managed_buffer->handle : resource.imported_buffer->handle;
+				auto cur_state = barrier.entry ? (resource.manageType == ManageType::Managed ? resource.managed_buffer->cur_state : resource.imported_buffer->cur_state) : barrier.src_state;
+				if (!barrier.entry || cur_state != barrier.dst_state || force)
+				{
+					buffer_barriers.push_back({
+						.buffer = buffer,
+						.src_state = cur_state,
+						.dst_state = barrier.dst_state,
+						.queue_acquire = barrier.transfer == QueueTransfer::Acquire,
+						.queue_release = barrier.transfer == QueueTransfer::Release,
+						.queue_type = barrier.queue,
+					});
+				}
+			}
+		}
+
+		resolved.textureCount = (uint32_t)texture_barriers.size() - resolved.textureOffset;
+		resolved.bufferCount = (uint32_t)buffer_barriers.size() - resolved.bufferOffset;
+		return resolved;
+	}
 
-		place_texture_barriers_impl(compiledRenderGraph.resources, pass.reads, cmd);
-		place_texture_barriers_impl(compiledRenderGraph.resources, pass.writes, cmd);
+	CGPUResourceBarrierDescriptor barrier_descriptor(ExecutorContext& context, const ResolvedBarriers& resolved)
+	{
+		return { .buffer_barriers = context.buffer_barriers.data() + resolved.bufferOffset, .buffer_barriers_count = resolved.bufferCount, .texture_barriers = context.texture_barriers.data() + resolved.textureOffset, .texture_barriers_count = resolved.textureCount, };
+	}
 
-		if (texture_barrier_count > 0 || buffer_barrier_count > 0)
+	void place_barriers(ExecutorContext& context, const ResolvedBarriers& resolved, CGPUCommandBufferId cmd)
+	{
+		if (resolved.textureCount > 0 || resolved.bufferCount > 0)
 		{
-			CGPUResourceBarrierDescriptor barrier_desc = { .buffer_barriers = buffer_barriers, .buffer_barriers_count = buffer_barrier_count, .texture_barriers = texture_barriers, .texture_barriers_count = texture_barrier_count, };
+			auto barrier_desc = barrier_descriptor(context, resolved);
 			cgpu_cmd_resource_barrier(cmd, &barrier_desc);
-			texture_barrier_count = 0;
-			buffer_barrier_count = 0;
 		}
 	}
 
-	void execute_render_pass(ExecutorContext& context, CompiledRenderGraph& compiledRenderGraph, const CompiledRenderPassNode& pass, RuntimePass& runtime, CGPUCommandBufferId cmd)
+	void resolve_split_barriers(ExecutorContext& context, CompiledRenderGraph& compiledRenderGraph, const CompiledRenderPassNode& pass, index_type_t passIndex, SplitBarriers& splits)
+	{
+		auto first = compiledRenderGraph.barriers.begin() + pass.barrierOffset;
+		auto last = first + pass.barrierCount;
+		for (auto iter = first; iter != last; ++iter)
+		{
+			if (iter->splitAfter == MAX_INDEX || std::find_if(first, iter, [&](auto& barrier) { return barrier.splitAfter == iter->splitAfter; }) != iter)
+				continue;
+			splits.barriers.push_back({ iter->splitAfter, passIndex, resolve_barriers(context, compiledRenderGraph, pass.barrierOffset, pass.barrierCount, iter->splitAfter) });
+		}
+	}
+
+	void begin_split_barriers(ExecutorContext& context, const SplitBarriers& splits, index_type_t after, CGPUCommandBufferId cmd)
+	{
+		auto iter = std::lower_bound(splits.begins.begin(), splits.begins.end(), std::make_pair(after, 0u));
+		for (; iter != splits.begins.end() && iter->first == after; ++iter)
+		{
+			auto barrier_desc = barrier_descriptor(context, splits.barriers[iter->second].resolved);
+			context.splitBarrierBackend.begin(context.splitBarrierBackend.user, cmd, iter->second, &barrier_desc);
+		}
+	}
+
+	void end_split_barriers(ExecutorContext& context, const SplitBarriers& splits, index_type_t before, CGPUCommandBufferId cmd)
+	{
+		auto iter = std::lower_bound(splits.barriers.begin(), splits.barriers.end(), before, [](auto& split, index_type_t before) { return split.before < before; });
+		for (; iter != splits.barriers.end() && iter->before == before; ++iter)
+		{
+			auto barrier_desc = barrier_descriptor(context, iter->resolved);
+			context.splitBarrierBackend.end(context.splitBarrierBackend.user, cmd, uint32_t(iter - splits.barriers.begin()), &barrier_desc);
+		}
+	}
+
+	void commit_texture_states(CompiledRenderGraph& compiledRenderGraph, const CompiledExitState& exit, Texture* texture)
+	{
+		auto states = compiledRenderGraph.states.begin() + exit.stateOffset;
+		if (exit.consistent)
+		{
+			texture->cur_states.reset(texture->cur_states.size(), states[0]);
+			return;
+		}
+
+		uint32_t count = std::min<uint32_t>(exit.stateCount, texture->cur_states.size());
+		for (uint32_t i = 0; i < count;)
+		{
+			uint32_t end = i + 1;
+			while (end < count && states[end] == states[i])
+				++end;
+			if (states[i] != CGPU_RESOURCE_STATE_UNDEFINED)
+				texture->cur_states.set(i, end, states[i]);
+			i = end;
+		}
+	}
+
+	void commit_buffer_state(CompiledRenderGraph& compiledRenderGraph, const CompiledExitState& exit, ECGPUResourceState& cur_state)
+	{
+		auto state = compiledRenderGraph.states[exit.stateOffset];
+		if (state != CGPU_RESOURCE_STATE_UNDEFINED)
+			cur_state = state;
+	}
+
+	void execute_render_pass(ExecutorContext& context, ExecutorWorker& worker, CompiledRenderGraph& compiledRenderGraph, const CompiledRenderPassNode& pass, RuntimePass& runtime, CGPUCommandBufferId cmd)
 	{
 		int attachment_count = pass.colorAttachmentCount + (pass.depthAttachment.valid ? 1 : 0);
 		if (attachment_count > 0)
 		{
+			auto group = compiledRenderGraph.passes.begin() + (&pass - compiledRenderGraph.passes.data());
+			auto& last = group[pass.mergedPassCount - 1];
+
+			auto& first = compiledRenderGraph.resources[pass.colorAttachmentCount > 0 ? pass.colorAttachments[0].resourceIndex : pass.depthAttachment.resourceIndex];
+
 			CGPURenderPassDescriptor rpDesc = {};
-			rpDesc.sample_count = ECGPUSampleCount::CGPU_SAMPLE_COUNT_1;
+			rpDesc.sample_count = (ECGPUSampleCount)std::max<uint8_t>(first.sampleCount, 1);
 			for (size_t i = 0; i < pass.colorAttachmentCount; ++i)
 			{
 				rpDesc.color_attachments[i] =
 				{
 					.format = compiledRenderGraph.resources[pass.colorAttachments[i].resourceIndex].format,
 					.load_action = pass.colorAttachments[i].load_action,
-					.store_action = pass.colorAttachments[i].store_action,
+					.store_action = last.colorAttachments[i].store_action,
 				};
 			}
 
@@ -171,12 +243,13 @@ namespace HGEGraphics
 				{
 					.format = compiledRenderGraph.resources[pass.depthAttachment.resourceIndex].format,
 					.depth_load_action = pass.depthAttachment.depth_load_action,
-					.depth_store_action = pass.depthAttachment.depth_store_action,
+					.depth_store_action = last.depthAttachment.depth_store_action,
 					.stencil_load_action = pass.depthAttachment.stencil_load_action,
-					.stencil_store_action = pass.depthAttachment.stencil_store_action,
+					.stencil_store_action = last.depthAttachment.stencil_store_action,
 				};
 			}
 
+			std::unique_lock<std::mutex> poolLock(*context.poolMutex);
 			runtime.renderPass = context.renderPassPool.getRenderPass(rpDesc);
 			CGPUFramebufferDescriptor fbDesc = {};
 			fbDesc.renderpass = runtime.renderPass->renderPass;
@@ -192,7 +265,7 @@ namespace HGEGraphics
 				desc.usages = CGPU_TVU_RTV_DSV;
 				desc.aspects = CGPU_TVA_COLOR;
 				desc.dims = CGPU_TEX_DIMENSION_2D;
-				desc.base_array_layer = 0;
+				desc.base_array_layer = resource.arraySlice;
 				desc.array_layer_count = 1;
 				desc.base_mip_level = resource.mipLevel;
 				desc.mip_level_count = 1;
@@ -210,7 +283,7 @@ namespace HGEGraphics
 				desc.usages = CGPU_TVU_RTV_DSV;
 				desc.aspects = CGPU_TVA_DEPTH | CGPU_TVA_STENCIL;
 				desc.dims = CGPU_TEX_DIMENSION_2D;
-				desc.base_array_layer = 0;
+				desc.base_array_layer = resource.arraySlice;
 				desc.array_layer_count = 1;
 				desc.base_mip_level = resource.mipLevel;
 				desc.mip_level_count = 1;
@@ -219,10 +292,12 @@ namespace HGEGraphics
 			}
 
 			auto mipedSize = [](uint64_t size, uint64_t mip) { return std::max<uint64_t>(size >> mip, 1ull); };
-			fbDesc.width = mipedSize(fbDesc.attachments[0]->info.texture->info->width, fbDesc.attachments[0]->info.base_mip_level);
-			fbDesc.height = mipedSize(fbDesc.attachments[0]->info.texture->info->height, fbDesc.attachments[0]->info.base_mip_level);
+			// bucketed textures can be larger than the resource, the pass only covers the resource's own extent
+			fbDesc.width = mipedSize(first.width, first.mipLevel);
+			fbDesc.height = mipedSize(first.height, first.mipLevel);
 			fbDesc.layers = 1;
 			runtime.framebuffer = context.framebufferPool.getFramebuffer(fbDesc);
+			poolLock.unlock();
 
 			CGPUClearValue clear_values[9];
 
@@ -269,37 +344,51 @@ namespace HGEGraphics
 			cgpu_render_encoder_bind_state_buffer(encoder, state_buffer);
 			auto raster_state_encoder = cgpu_open_raster_state_encoder(state_buffer, encoder);
 
-			cgpu_render_encoder_set_viewport(encoder,
-				0.0f, 0.0f,
-				(float)fbDesc.width, (float)fbDesc.height,
-				0.f, 1.f);
-			cgpu_render_encoder_set_scissor(encoder, 0, 0, fbDesc.width, fbDesc.height);
-
-			if (pass.executable)
+			for (uint32_t k = 0; k < pass.mergedPassCount; ++k)
 			{
-				RenderPassEncoder rg_encoder = {
-					.encoder = encoder,
-					.state_buffer = state_buffer,
-					.raster_state_encoder = raster_state_encoder,
-					.render_pass = runtime.renderPass->renderPass,
-					.subpass = 0,
-					.render_target_count = (uint32_t)pass.colorAttachmentCount,
-					.context = &context,
-					.compiled_graph = &compiledRenderGraph,
-					.last_render_pipeline = 0,
-					.last_bind_resources = {0},
-				};
-				pass.executable(&rg_encoder, pass.passdata);
+				auto& member = group[k];
+				cgpu_render_encoder_set_viewport(encoder,
+					0.0f, 0.0f,
+					(float)fbDesc.width, (float)fbDesc.height,
+					0.f, 1.f);
+				cgpu_render_encoder_set_scissor(encoder, 0, 0, fbDesc.width, fbDesc.height);
+
+				if (member.executable)
+				{
+					RenderPassEncoder rg_encoder = {
+						.encoder = encoder,
+						.state_buffer = state_buffer,
+						.raster_state_encoder = raster_state_encoder,
+						.render_pass = runtime.renderPass->renderPass,
+						.render_pass_desc = &runtime.renderPass->_descriptor,
+						.subpass = 0,
+						.render_target_count = (uint32_t)member.colorAttachmentCount,
+						.context = &context,
+						.worker = &worker,
+						.compiled_graph = &compiledRenderGraph,
+						.last_render_pipeline = 0,
+						.last_descriptor_sets = {},
+					};
+					worker.resetGlobals();
+					member.executable(&rg_encoder, member.passdata);
+				}
+				// stamped inside the shared render pass so every merged member keeps its own duration
+				if (context.profiler)
+					context.profiler->GetTimeStamp(cmd, member.name);
 			}
 
 			cgpu_close_raster_state_encoder(raster_state_encoder);
 			cgpu_free_state_buffer(state_buffer);
 			cgpu_cmd_end_render_pass(cmd, encoder);
 		}
-
+		else if (context.profiler)
+		{
+			for (uint32_t k = 0; k < pass.mergedPassCount; ++k)
+				context.profiler->GetTimeStamp(cmd, (&pass)[k].name);
+		}
 	}
 
-	void execute_compute_pass(ExecutorContext& context, CompiledRenderGraph& compiledRenderGraph, const CompiledRenderPassNode& pass, RuntimePass& runtime, CGPUCommandBufferId cmd)
+	void execute_compute_pass(ExecutorContext& context, ExecutorWorker& worker, CompiledRenderGraph& compiledRenderGraph, const CompiledRenderPassNode& pass, RuntimePass& runtime, CGPUCommandBufferId cmd)
 	{
 		CGPUComputePassDescriptor pass_desc =
 		{
@@ -312,32 +401,32 @@ namespace HGEGraphics
 			RenderPassEncoder rg_encoder = {
 				.compute_encoder = encoder,
 				.context = &context,
+				.worker = &worker,
 				.compiled_graph = &compiledRenderGraph,
 				.last_render_pipeline = 0,
-				.last_bind_resources = {0},
+				.last_descriptor_sets = {},
 			};
+			worker.resetGlobals();
 			pass.executable(&rg_encoder, pass.passdata);
 		}
 
 		cgpu_cmd_end_compute_pass(cmd, encoder);
 	}
 
-	void execute_upload_texture_pass(ExecutorContext& context, CompiledRenderGraph& compiledRenderGraph, const CompiledRenderPassNode& pass, RuntimePass& runtime, CGPUCommandBufferId cmd)
+	void execute_upload_texture_pass(ExecutorContext& context, ExecutorWorker& worker, CompiledRenderGraph& compiledRenderGraph, const CompiledRenderPassNode& pass, RuntimePass& runtime, CGPUCommandBufferId cmd)
 	{
 		auto& src_resource_node = compiledRenderGraph.resources[pass.staging_buffer];
 		CGPUBufferId src_buffer = src_resource_node.manageType == ManageType::Managed ? src_resource_node.managed_buffer->handle : src_resource_node.imported_buffer->handle;
+		auto staging_address = (char*)src_buffer->info->cpu_mapped_address + pass.staging_offset;
 
 		if (pass.size > 0 && pass.data)
-		{
-			auto address = (char*)src_buffer->info->cpu_mapped_address + pass.offset;
-			memcpy(address, pass.data, pass.size);
-		}
+			memcpy(staging_address + pass.offset, pass.data, pass.size);
 
 		if (pass.uploadTextureExecutable)
 		{
 			UploadEncoder up_encoder = {
-				.size = src_buffer->info->size,
-				.address = src_buffer->info->cpu_mapped_address,
+				.size = pass.staging_size,
+				.address = staging_address,
 			};
 
 			pass.uploadTextureExecutable(&up_encoder, pass.passdata);
@@ -345,137 +434,331 @@ namespace HGEGraphics
 
 		auto& dest_resource_node = compiledRenderGraph.resources[pass.dest_texture];
 		auto dest_texture = getTexture(compiledRenderGraph.resources, dest_resource_node);
-
-		CGPUBufferToTextureTransfer b2t = {};
-		b2t.src = src_buffer;
-		b2t.src_offset = 0;
-		b2t.dst = dest_texture->handle;
-		b2t.dst_subresource.mip_level = pass.mipmap;
-		b2t.dst_subresource.base_array_layer = pass.slice;
-		b2t.dst_subresource.layer_count = 1;
-		cgpu_cmd_transfer_buffer_to_texture(cmd, &b2t);
+		auto info = dest_texture->handle->info;
+		auto mipedSize = [](uint64_t size, uint64_t mip) { return std::max<uint64_t>(size >> mip, 1ull); };
+
+		// slices of a mip are contiguous in staging memory, so each mip is a single copy
+		uint64_t src_offset = pass.staging_offset;
+		const uint64_t blockWidth = FormatUtil_WidthOfBlock(info->format);
+		const uint64_t blockHeight = FormatUtil_HeightOfBlock(info->format);
+		for (uint32_t mip = pass.mipmap; mip < pass.mipmap + pass.mipCount; ++mip)
+		{
+			CGPUBufferToTextureTransfer b2t = {};
+			b2t.src = src_buffer;
+			b2t.src_offset = src_offset;
+			b2t.dst = dest_texture->handle;
+			b2t.dst_subresource.mip_level = mip;
+			b2t.dst_subresource.base_array_layer = pass.slice;
+			b2t.dst_subresource.layer_count = pass.sliceCount;
+			cgpu_cmd_transfer_buffer_to_texture(cmd, &b2t);
+
+			const uint64_t xBlocksCount = (mipedSize(info->width, mip) + blockWidth - 1) / blockWidth;
+			const uint64_t yBlocksCount = (mipedSize(info->height, mip) + blockHeight - 1) / blockHeight;
+			const uint64_t zBlocksCount = mipedSize(info->depth, mip);
+			src_offset += xBlocksCount * yBlocksCount * zBlocksCount * FormatUtil_BitSizeOfBlock(info->format) / 8 * pass.sliceCount;
+		}
 	}
 
-	void execute_upload_buffer_pass(ExecutorContext& context, CompiledRenderGraph& compiledRenderGraph, const CompiledRenderPassNode& pass, RuntimePass& runtime, CGPUCommandBufferId cmd)
+	void execute_upload_buffer_pass(ExecutorContext& context, ExecutorWorker& worker, CompiledRenderGraph& compiledRenderGraph, const CompiledRenderPassNode& pass, RuntimePass& runtime, CGPUCommandBufferId cmd)
 	{
-		auto& src_resource_node = compiledRenderGraph.resources[pass.staging_buffer];
-		CGPUBufferId src_buffer = src_resource_node.manageType == ManageType::Managed ? src_resource_node.managed_buffer->handle : src_resource_node.imported_buffer->handle;
+		auto& dest_resource_node = compiledRenderGraph.resources[pass.dest_buffer];
+		auto dest_buffer = dest_resource_node.manageType == ManageType::Managed ? dest_resource_node.managed_buffer->handle : dest_resource_node.imported_buffer->handle;
 
-		if (pass.size > 0 && pass.data)
+		// no staging buffer means the destination is host visible and is written in place
+		bool direct = pass.staging_buffer == 0;
+		CGPUBufferId src_buffer = dest_buffer;
+		if (!direct)
 		{
-			auto address = (char*)src_buffer->info->cpu_mapped_address + pass.offset;
-			memcpy(address, pass.data, pass.size);
+			auto& src_resource_node = compiledRenderGraph.resources[pass.staging_buffer];
+			src_buffer = src_resource_node.manageType == ManageType::Managed ? src_resource_node.managed_buffer->handle : src_resource_node.imported_buffer->handle;
 		}
+		auto staging_address = (char*)src_buffer->info->cpu_mapped_address + pass.staging_offset;
+		assert(src_buffer->info->cpu_mapped_address);
+
+		if (pass.size > 0 && pass.data)
+			memcpy(staging_address + pass.offset, pass.data, pass.size);
 
 		if (pass.uploadTextureExecutable)
 		{
 			UploadEncoder up_encoder = {
-				.size = src_buffer->info->size,
-				.address = src_buffer->info->cpu_mapped_address,
+				.size = pass.staging_size,
+				.address = staging_address,
 			};
 
 			pass.uploadTextureExecutable(&up_encoder, pass.passdata);
 		}
 
-		auto& dest_resource_node = compiledRenderGraph.resources[pass.dest_buffer];
-		auto dest_buffer = dest_resource_node.manageType == ManageType::Managed ? dest_resource_node.managed_buffer->handle : dest_resource_node.imported_buffer->handle;
+		if (direct)
+			return;
 
 		CGPUBufferToBufferTransfer b2b = {};
 		b2b.src = src_buffer;
-		b2b.src_offset = 0;
+		b2b.src_offset = pass.staging_offset;
 		b2b.dst = dest_buffer;
 		b2b.dst_offset = 0;
-		b2b.size = dest_buffer->info->size;
+		b2b.size = dest_resource_node.size;
 		cgpu_cmd_transfer_buffer_to_buffer(cmd, &b2b);
 	}
 
-	void Executor::Execute(CompiledRenderGraph& compiledRenderGraph, ExecutorContext& context)
+	void devirtualize_resources(ExecutorContext& context, CompiledRenderGraph& compiledRenderGraph, const CompiledRenderPassNode& pass)
+	{
+		for (auto resourceIndex : pass.devirtualize)
+		{
+			auto& resource = compiledRenderGraph.resources[resourceIndex];
+			if (resource.manageType != ManageType::Managed)
+				continue;
+			auto& block = compiledRenderGraph.aliasBlocks[resource.aliasBlock];
+			if (resource.resourceType == ResourceType::Texture)
+			{
+				if (!block.managered_texture)
+				{
+					TextureDescriptor descriptor =
+					{
+						.width = resource.bucketed ? texture_bucket_extent(resource.width) : resource.width,
+						.height = resource.bucketed ? texture_bucket_extent(resource.height) : resource.height,
+						.depth = resource.depth,
+						.mipLevels = std::max<uint16_t>(resource.mipCount, 1),
+						.arraySize = std::max<uint16_t>(resource.arraySize, 1),
+						.sampleCount = std::max<uint16_t>(resource.sampleCount, 1),
+						.format = resource.format,
+						.usage = resource.textureType,
+					};
+					block.managered_texture = context.texturePool.getTexture(descriptor);
+				}
+				resource.managered_texture = block.managered_texture;
+			}
+			else if (resource.resourceType == ResourceType::Buffer)
+			{
+				if (!block.managed_buffer)
+				{
+					auto& owner = compiledRenderGraph.resources[block.resource];
+					CGPUBufferDescriptor desc = {};
+					desc.name = owner.name;
+					desc.flags = owner.memoryUsage != CGPU_MEM_USAGE_GPU_ONLY ? CGPU_BCF_PERSISTENT_MAP_BIT : CGPU_BCF_NONE;
+					desc.descriptors = owner.bufferType;
+					desc.memory_usage = owner.memoryUsage;
+					desc.size = block.size;
+
+					block.managed_buffer = context.bufferPool.getResource(desc);
+				}
+				resource.managed_buffer = block.managed_buffer;
+			}
+		}
+	}
+
+	void destroy_resources(ExecutorContext& context, CompiledRenderGraph& compiledRenderGraph, const CompiledRenderPassNode& pass, index_type_t passIndex)
+	{
+		for (auto resourceIndex : pass.destroy)
+		{
+			auto& resource = compiledRenderGraph.resources[resourceIndex];
+			if (resource.manageType != ManageType::Managed)
+				continue;
+			auto& block = compiledRenderGraph.aliasBlocks[resource.aliasBlock];
+			if (block.lastPass != passIndex)
+				continue;
+			if (block.exitState != MAX_INDEX)
+			{
+				auto& exit = compiledRenderGraph.exitStates[block.exitState];
+				if (resource.resourceType == ResourceType::Texture)
+					commit_texture_states(compiledRenderGraph, exit, block.managered_texture->texture);
+				else
+					commit_buffer_state(compiledRenderGraph, exit, block.managed_buffer->cur_state);
+			}
+			if (resource.resourceType == ResourceType::Texture)
+			{
+				context.texturePool.releaseResource(block.managered_texture);
+				block.managered_texture = nullptr;
+			}
+			else if (resource.resourceType == ResourceType::Buffer)
+			{
+				context.bufferPool.releaseResource(block.managed_buffer);
+				block.managed_buffer = nullptr;
+			}
+		}
+	}
+
+	struct RecordChunk
+	{
+		index_type_t batch;
+		uint32_t passBegin, passEnd;
+		bool first, last;
+		CGPUCommandBufferId cmd;
+	};
+
+	void record_chunk(ExecutorContext& context, CompiledRenderGraph& compiledRenderGraph, RecordChunk& chunk, const std::pmr::vector<ResolvedBarriers>& passBarriers, const std::pmr::vector<ResolvedBarriers>& batchBarriers, const SplitBarriers& splits, uint32_t workerIndex)
 	{
-		auto cmd = context.requestCmd();
+		auto& batch = compiledRenderGraph.batches[chunk.batch];
+		auto& worker = context.workers[workerIndex];
+		bool profile = context.profiler && batch.queue == CGPU_QUEUE_TYPE_GRAPHICS;
+		auto cmd = worker.requestCmd(batch.queue);
 
 		cgpu_cmd_begin(cmd);
 
-		if (context.profiler)
+		if (context.profiler && chunk.batch == 0 && chunk.first)
 		{
 			context.profiler->CollectTimings();
 			context.profiler->OnBeginFrame(cmd);
 		}
 
-		std::pmr::vector<RuntimePass> runtimePasses(context.memory_resource);
-
-		for (auto i = 0; i < compiledRenderGraph.passes.size(); ++i)
+		for (auto i = chunk.passBegin; i < chunk.passEnd; i += compiledRenderGraph.passes[i].mergedPassCount)
 		{
 			auto& pass = compiledRenderGraph.passes[i];
 
 			RuntimePass runtime = {};
 			runtime.passNode = &pass;
 
-			for (auto resourceIndex : pass.devirtualize)
+			for (auto k = i; k < i + pass.mergedPassCount; ++k)
 			{
-				auto& resource = compiledRenderGraph.resources[resourceIndex];
-				if (resource.resourceType == ResourceType::Texture)
-				{
-					if (resource.manageType == ManageType::Managed)
-					{
-						resource.managered_texture = context.texturePool.getTexture(resource.width, resource.height, resource.depth, resource.format);
-					}
-				}
-				else if (resource.resourceType == ResourceType::Buffer)
-				{
-					if (resource.manageType == ManageType::Managed)
-					{
-						CGPUBufferDescriptor desc = {};
-						desc.name = resource.name;
-						desc.flags = resource.memoryUsage != CGPU_MEM_USAGE_GPU_ONLY ? CGPU_BCF_PERSISTENT_MAP_BIT : CGPU_BCF_NONE;
-						desc.descriptors = resource.bufferType;
-						desc.memory_usage = resource.memoryUsage;
-						desc.size = resource.size;
-
-						resource.managed_buffer = context.bufferPool.getResource(desc);
-					}
-				}
+				end_split_barriers(context, splits, k, cmd);
+				place_barriers(context, passBarriers[k], cmd);
 			}
 
-			place_barriers(context, compiledRenderGraph, pass, runtime, cmd);
 			if (pass.type == PASS_TYPE_RENDER)
 			{
-				execute_render_pass(context, compiledRenderGraph, pass, runtime, cmd);
+				execute_render_pass(context, worker, compiledRenderGraph, pass, runtime, cmd);
 			}
 			else if (pass.type == PASS_TYPE_COMPUTE)
 			{
-				execute_compute_pass(context, compiledRenderGraph, pass, runtime, cmd);
+				execute_compute_pass(context, worker, compiledRenderGraph, pass, runtime, cmd);
 			}
 			else if (pass.type == PASS_TYPE_UPLOAD_TEXTURE)
 			{
-				execute_upload_texture_pass(context, compiledRenderGraph, pass, runtime, cmd);
+				execute_upload_texture_pass(context, worker, compiledRenderGraph, pass, runtime, cmd);
 			}
 			else if (pass.type == PASS_TYPE_UPLOAD_BUFFER)
 			{
-				execute_upload_buffer_pass(context, compiledRenderGraph, pass, runtime, cmd);
+				execute_upload_buffer_pass(context, worker, compiledRenderGraph, pass, runtime, cmd);
 			}
 
-			for (auto resourceIndex : pass.destroy)
+			if (profile && pass.type != PASS_TYPE_RENDER)
+				context.profiler->GetTimeStamp(cmd, pass.name);
+
+			begin_split_barriers(context, splits, i, cmd);
+		}
+
+		if (chunk.last)
+		{
+			place_barriers(context, batchBarriers[chunk.batch], cmd);
+			if (context.profiler && chunk.batch + 1 == compiledRenderGraph.batches.size())
+				context.profiler->OnEndFrame(cmd);
+		}
+		cgpu_cmd_end(cmd);
+		chunk.cmd = cmd;
+	}
+
+	void Executor::Execute(CompiledRenderGraph& compiledRenderGraph, ExecutorContext& context)
+	{
+		auto& passes = compiledRenderGraph.passes;
+		auto& batches = compiledRenderGraph.batches;
+
+		context.submitted_cmds.clear();
+		context.submissions.clear();
+		context.texture_barriers.clear();
+		context.buffer_barriers.clear();
+		while (context.semaphores.size() < batches.size())
+			context.semaphores.push_back(cgpu_create_semaphore(context.device));
+
+		// binding resources and resolving barriers against the tracked states has to follow submission order,
+		// so it is done up front and recording only replays the results
+		std::pmr::vector<ResolvedBarriers> passBarriers(passes.size(), context.memory_resource);
+		std::pmr::vector<ResolvedBarriers> batchBarriers(batches.size(), context.memory_resource);
+		SplitBarriers splits(context.memory_resource);
+		bool split = split_barriers_supported(context);
+		for (index_type_t b = 0; b < batches.size(); ++b)
+		{
+			auto& batch = batches[b];
+			for (auto i = batch.passOffset; i < batch.passOffset + batch.passCount; i += passes[i].mergedPassCount)
 			{
-				auto& resource = compiledRenderGraph.resources[resourceIndex];
-				if (resource.resourceType == ResourceType::Texture)
+				// merged passes share one render pass, so everything they need is prepared before it begins
+				auto& pass = passes[i];
+				for (auto k = i; k < i + pass.mergedPassCount; ++k)
 				{
-					if (resource.manageType == ManageType::Managed)
-						context.texturePool.releaseResource(resource.managered_texture);
+					devirtualize_resources(context, compiledRenderGraph, passes[k]);
+					passBarriers[k] = resolve_barriers(context, compiledRenderGraph, passes[k].barrierOffset, passes[k].barrierCount, MAX_INDEX);
+					if (split)
+						resolve_split_barriers(context, compiledRenderGraph, passes[k], k, splits);
 				}
-				else if (resource.resourceType == ResourceType::Buffer)
+				for (auto k = i; k < i + pass.mergedPassCount; ++k)
+					destroy_resources(context, compiledRenderGraph, passes[k], k);
+			}
+			batchBarriers[b] = resolve_barriers(context, compiledRenderGraph, batch.barrierOffset, batch.barrierCount, MAX_INDEX);
+		}
+		for (uint32_t i = 0; i < splits.barriers.size(); ++i)
+			splits.begins.push_back({ splits.barriers[i].after, i });
+		std::sort(splits.begins.begin(), splits.begins.end());
+
+		for (auto& exit : compiledRenderGraph.exitStates)
+		{
+			if (exit.aliasBlock != MAX_INDEX)
+				continue;
+			auto& resource = compiledRenderGraph.resources[exit.resource];
+			if (resource.resourceType == ResourceType::Texture)
+				commit_texture_states(compiledRenderGraph, exit, resource.imported_texture);
+			else
+				commit_buffer_state(compiledRenderGraph, exit, resource.imported_buffer->cur_state);
+		}
+
+		// the profiler writes its timestamps in order, so it keeps recording on one thread
+		uint32_t workerCount = context.workerPool && !context.profiler ? (uint32_t)context.workers.size() : 1;
+		std::pmr::vector<RecordChunk> chunks(context.memory_resource);
+		for (index_type_t b = 0; b < batches.size(); ++b)
+		{
+			auto& batch = batches[b];
+			uint32_t groupCount = 0;
+			for (auto i = batch.passOffset; i < batch.passOffset + batch.passCount; i += passes[i].mergedPassCount)
+				++groupCount;
+
+			uint32_t chunkCount = std::max(1u, std::min(workerCount, groupCount));
+			uint32_t groupsPerChunk = (groupCount + chunkCount - 1) / chunkCount;
+			uint32_t firstChunk = (uint32_t)chunks.size();
+			uint32_t group = 0;
+			auto begin = batch.passOffset;
+			for (auto i = batch.passOffset; i < batch.passOffset + batch.passCount; i += passes[i].mergedPassCount)
+			{
+				if (++group % groupsPerChunk == 0)
 				{
-					if (resource.manageType == ManageType::Managed)
-						context.bufferPool.releaseResource(resource.managed_buffer);
+					chunks.push_back({ b, begin, i + passes[i].mergedPassCount, false, false, CGPU_NULLPTR });
+					begin = i + passes[i].mergedPassCount;
 				}
 			}
+			if (begin < batch.passOffset + batch.passCount || (uint32_t)chunks.size() == firstChunk)
+				chunks.push_back({ b, begin, batch.passOffset + batch.passCount, false, false, CGPU_NULLPTR });
+			chunks[firstChunk].first = true;
+			chunks.back().last = true;
+		}
 
-			if (context.profiler)context.profiler->GetTimeStamp(cmd, pass.name);
-			runtimePasses.push_back(runtime);
+		if (workerCount > 1 && chunks.size() > batches.size())
+		{
+			context.workerPool->run((uint32_t)chunks.size(), [&](uint32_t index, uint32_t worker)
+			{
+				record_chunk(context, compiledRenderGraph, chunks[index], passBarriers, batchBarriers, splits, worker);
+			});
+		}
+		else
+		{
+			for (auto& chunk : chunks)
+				record_chunk(context, compiledRenderGraph, chunk, passBarriers, batchBarriers, splits, 0);
 		}
 
-		runtimePasses.clear();
+		for (auto& chunk : chunks)
+			context.submitted_cmds.push_back(chunk.cmd);
 
-		if (context.profiler)context.profiler->OnEndFrame(cmd);
-		cgpu_cmd_end(cmd);
+		uint32_t cmdOffset = 0;
+		for (index_type_t b = 0; b < batches.size(); ++b)
+		{
+			auto& batch = batches[b];
+			uint32_t cmdCount = 0;
+			while (cmdOffset + cmdCount < chunks.size() && chunks[cmdOffset + cmdCount].batch == b)
+				++cmdCount;
+
+			context.submissions.push_back({
+				.queue = batch.queue,
+				.cmds = context.submitted_cmds.data() + cmdOffset,
+				.cmd_count = cmdCount,
+				.wait_semaphore = batch.wait != MAX_INDEX ? context.semaphores[batch.wait] : CGPU_NULLPTR,
+				.signal_semaphore = batch.signal ? context.semaphores[b] : CGPU_NULLPTR,
+			});
+			cmdOffset += cmdCount;
+		}
 	}
 }
\ No newline at end of file
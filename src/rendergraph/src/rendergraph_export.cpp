@@ -0,0 +1,310 @@
+#include "rendergraph_export.h"
+
+namespace HGEGraphics
+{
+	const char* pass_type_name(pass_type type)
+	{
+		switch (type)
+		{
+		case PASS_TYPE_HOLDON: return "holdon";
+		case PASS_TYPE_RENDER: return "render";
+		case PASS_TYPE_COMPUTE: return "compute";
+		case PASS_TYPE_UPLOAD_TEXTURE: return "upload_texture";
+		case PASS_TYPE_UPLOAD_BUFFER: return "upload_buffer";
+		case PASS_TYPE_PRESENT: return "present";
+		}
+		return "unknown";
+	}
+
+	const char* manage_type_name(ManageType type)
+	{
+		switch (type)
+		{
+		case ManageType::Managed: return "managed";
+		case ManageType::Imported: return "imported";
+		case ManageType::SubResource: return "subresource";
+		}
+		return "unknown";
+	}
+
+	const char* queue_name(ECGPUQueueType queue)
+	{
+		return queue == CGPU_QUEUE_TYPE_COMPUTE ? "compute" : "graphics";
+	}
+
+	const char* transfer_name(QueueTransfer transfer)
+	{
+		switch (transfer)
+		{
+		case QueueTransfer::None: return "none";
+		case QueueTransfer::Release: return "release";
+		case QueueTransfer::Acquire: return "acquire";
+		}
+		return "unknown";
+	}
+
+	void write_state(std::ostream& out, ECGPUResourceState state)
+	{
+		struct StateName
+		{
+			uint32_t state;
+			const char* name;
+		};
+		static const StateName names[] =
+		{
+			{ CGPU_RESOURCE_STATE_SHADER_RESOURCE, "SHADER_RESOURCE" },
+			{ CGPU_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER, "VERTEX_AND_CONSTANT_BUFFER" },
+			{ CGPU_RESOURCE_STATE_INDEX_BUFFER, "INDEX_BUFFER" },
+			{ CGPU_RESOURCE_STATE_RENDER_TARGET, "RENDER_TARGET" },
+			{ CGPU_RESOURCE_STATE_UNORDERED_ACCESS, "UNORDERED_ACCESS" },
+			{ CGPU_RESOURCE_STATE_DEPTH_WRITE, "DEPTH_WRITE" },
+			{ CGPU_RESOURCE_STATE_DEPTH_READ, "DEPTH_READ" },
+			{ CGPU_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, "NON_PIXEL_SHADER_RESOURCE" },
+			{ CGPU_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, "PIXEL_SHADER_RESOURCE" },
+			{ CGPU_RESOURCE_STATE_COPY_DEST, "COPY_DEST" },
+			{ CGPU_RESOURCE_STATE_COPY_SOURCE, "COPY_SOURCE" },
+			{ CGPU_RESOURCE_STATE_PRESENT, "PRESENT" },
+			{ CGPU_RESOURCE_STATE_COMMON, "COMMON" },
+		};
+
+		if (state == CGPU_RESOURCE_STATE_UNDEFINED)
+		{
+			out << "UNDEFINED";
+			return;
+		}
+
+		uint32_t rest = state;
+		bool first = true;
+		for (auto& name : names)
+		{
+			if ((rest & name.state) != name.state)
+				continue;
+			out << (first ? "" : "|") << name.name;
+			rest &= ~name.state;
+			first = false;
+		}
+		if (rest != 0)
+			out << (first ? "" : "|") << "0x" << std::hex << rest << std::dec;
+	}
+
+	void write_string(std::ostream& out, const char8_t* str)
+	{
+		out << '"';
+		for (auto c = (const char*)str; c && *c; ++c)
+		{
+			if (*c == '"' || *c == '\\')
+				out << '\\' << *c;
+			else if ((unsigned char)*c < 0x20)
+				out << ' ';
+			else
+				out << *c;
+		}
+		out << '"';
+	}
+
+	const char8_t* pass_name(const rendergraph_t& renderGraph, const CompiledRenderPassNode& pass)
+	{
+		return renderGraph.passes[pass.source].name;
+	}
+
+	void rendergraph_export_json(const rendergraph_t& renderGraph, const CompiledRenderGraph& compiled, std::ostream& out)
+	{
+		std::pmr::vector<index_type_t> firstPass(compiled.resources.size(), MAX_INDEX, compiled.resources.get_allocator().resource());
+		std::pmr::vector<index_type_t> lastPass(compiled.resources.size(), MAX_INDEX, compiled.resources.get_allocator().resource());
+		for (index_type_t i = 0; i < compiled.passes.size(); ++i)
+		{
+			for (auto resource : compiled.passes[i].devirtualize)
+				firstPass[resource] = i;
+			for (auto resource : compiled.passes[i].destroy)
+				lastPass[resource] = i;
+		}
+
+		auto write_index = [&](index_type_t index)
+		{
+			if (index == MAX_INDEX)
+				out << "null";
+			else
+				out << index;
+		};
+
+		out << "{\n";
+		out << "\t\"transientBufferMemory\": { \"requested\": " << compiled.transientMemory.requested_bytes
+			<< ", \"allocated\": " << compiled.transientMemory.allocated_bytes
+			<< ", \"peak\": " << compiled.transientMemory.peak_bytes
+			<< ", \"resources\": " << compiled.transientMemory.resource_count
+			<< ", \"blocks\": " << compiled.transientMemory.block_count << " },\n";
+		out << "\t\"schedule\": { \"reordered\": " << (compiled.schedule.reordered ? "true" : "false")
+			<< ", \"declaredBarriers\": " << compiled.schedule.declared_barrier_count
+			<< ", \"scheduledBarriers\": " << compiled.schedule.scheduled_barrier_count
+			<< ", \"splitBarriers\": " << compiled.schedule.split_barrier_count << " },\n";
+
+		out << "\t\"passes\": [\n";
+		for (index_type_t i = 0; i < compiled.passes.size(); ++i)
+		{
+			auto& pass = compiled.passes[i];
+			bool culled = pass.name == nullptr;
+			out << "\t\t{ \"index\": " << i << ", \"source\": " << pass.source << ", \"name\": ";
+			write_string(out, pass_name(renderGraph, pass));
+			out << ", \"culled\": " << (culled ? "true" : "false");
+			if (!culled)
+			{
+				out << ", \"type\": \"" << pass_type_name(pass.type) << "\", \"queue\": \"" << queue_name(pass.queue) << "\", \"batch\": " << pass.batch;
+				out << ", \"mergedPassCount\": " << pass.mergedPassCount << ", \"merged\": " << (pass.merged ? "true" : "false");
+
+				auto write_edges = [&](const char* label, const std::pmr::vector<CompiledEdge>& edges)
+				{
+					out << ", \"" << label << "\": [";
+					for (size_t j = 0; j < edges.size(); ++j)
+					{
+						out << (j ? ", " : "") << "{ \"resource\": " << edges[j].index << ", \"usage\": \"";
+						write_state(out, edges[j].usage);
+						out << "\" }";
+					}
+					out << "]";
+				};
+				write_edges("reads", pass.reads);
+				write_edges("writes", pass.writes);
+
+				auto write_indices = [&](const char* label, const std::pmr::vector<index_type_t>& indices)
+				{
+					out << ", \"" << label << "\": [";
+					for (size_t j = 0; j < indices.size(); ++j)
+						out << (j ? ", " : "") << indices[j];
+					out << "]";
+				};
+				write_indices("devirtualize", pass.devirtualize);
+				write_indices("destroy", pass.destroy);
+
+				out << ", \"barriers\": [";
+				for (uint32_t j = 0; j < pass.barrierCount; ++j)
+				{
+					auto& barrier = compiled.barriers[pass.barrierOffset + j];
+					out << (j ? ", " : "") << "{ \"resource\": " << barrier.resource << ", \"src\": \"";
+					if (barrier.entry)
+						out << "ENTRY";
+					else
+						write_state(out, barrier.src_state);
+					out << "\", \"dst\": \"";
+					write_state(out, barrier.dst_state);
+					out << "\"";
+					if (barrier.subresource)
+						out << ", \"mip\": " << (uint32_t)barrier.mipLevel << ", \"slice\": " << (uint32_t)barrier.arraySlice;
+					if (barrier.transfer != QueueTransfer::None)
+						out << ", \"transfer\": \"" << transfer_name(barrier.transfer) << "\", \"queue\": \"" << queue_name(barrier.queue) << "\"";
+					out << " }";
+				}
+				out << "]";
+			}
+			out << " }" << (i + 1 < compiled.passes.size() ? "," : "") << "\n";
+		}
+		out << "\t],\n";
+
+		out << "\t\"resources\": [\n";
+		for (index_type_t i = 0; i < compiled.resources.size(); ++i)
+		{
+			auto& resource = compiled.resources[i];
+			auto& source = renderGraph.resources[i];
+			bool culled = resource.name == nullptr;
+			out << "\t\t{ \"index\": " << i << ", \"name\": ";
+			write_string(out, source.name);
+			out << ", \"culled\": " << (culled ? "true" : "false");
+			out << ", \"type\": \"" << (source.resourceType == ResourceType::Texture ? "texture" : "buffer") << "\", \"manage\": \"" << manage_type_name(source.manageType) << "\"";
+			if (!culled)
+			{
+				if (resource.resourceType == ResourceType::Texture)
+				{
+					out << ", \"width\": " << resource.width << ", \"height\": " << resource.height << ", \"depth\": " << resource.depth
+						<< ", \"format\": " << (uint32_t)resource.format << ", \"mips\": " << (uint32_t)resource.mipCount << ", \"arraySize\": " << (uint32_t)resource.arraySize;
+					if (resource.manageType == ManageType::SubResource)
+						out << ", \"parent\": " << resource.parent << ", \"mip\": " << (uint32_t)resource.mipLevel << ", \"slice\": " << (uint32_t)resource.arraySlice;
+				}
+				out << ", \"bytes\": " << resource.allocationSize;
+				if (resource.manageType == ManageType::Managed)
+				{
+					out << ", \"aliasBlock\": ";
+					write_index(resource.aliasBlock);
+					out << ", \"devirtualizePass\": ";
+					write_index(firstPass[i]);
+					out << ", \"destroyPass\": ";
+					write_index(lastPass[i]);
+				}
+			}
+			out << " }" << (i + 1 < compiled.resources.size() ? "," : "") << "\n";
+		}
+		out << "\t],\n";
+
+		out << "\t\"aliasBlocks\": [\n";
+		for (index_type_t i = 0; i < compiled.aliasBlocks.size(); ++i)
+		{
+			auto& block = compiled.aliasBlocks[i];
+			out << "\t\t{ \"index\": " << i << ", \"resource\": " << block.resource << ", \"lastPass\": " << block.lastPass << ", \"bytes\": " << block.size << " }"
+				<< (i + 1 < compiled.aliasBlocks.size() ? "," : "") << "\n";
+		}
+		out << "\t],\n";
+
+		out << "\t\"batches\": [\n";
+		for (index_type_t i = 0; i < compiled.batches.size(); ++i)
+		{
+			auto& batch = compiled.batches[i];
+			out << "\t\t{ \"index\": " << i << ", \"queue\": \"" << queue_name(batch.queue) << "\", \"passOffset\": " << batch.passOffset << ", \"passCount\": " << batch.passCount
+				<< ", \"releaseBarriers\": " << batch.barrierCount << ", \"wait\": ";
+			write_index(batch.wait);
+			out << ", \"signal\": " << (batch.signal ? "true" : "false") << " }" << (i + 1 < compiled.batches.size() ? "," : "") << "\n";
+		}
+		out << "\t]\n";
+		out << "}\n";
+	}
+
+	void rendergraph_export_graphviz(const rendergraph_t& renderGraph, const CompiledRenderGraph& compiled, std::ostream& out, const char* name)
+	{
+		out << "digraph \"" << (name ? name : "rendergraph") << "\" {\n";
+		out << "rankdir = LR\n";
+		out << "bgcolor = black\n";
+		out << "node [shape=rectangle, fontname=\"helvetica\", fontsize=10]\n\n";
+
+		auto write_label = [&](const char8_t* str)
+		{
+			for (auto c = (const char*)str; c && *c; ++c)
+			{
+				if (*c == '"' || *c == '\\')
+					out << '\\';
+				out << *c;
+			}
+		};
+
+		for (index_type_t i = 0; i < compiled.passes.size(); ++i)
+		{
+			auto& pass = compiled.passes[i];
+			bool culled = pass.name == nullptr;
+			out << "\"P" << pass.source << "\" [label=\"";
+			write_label(pass_name(renderGraph, pass));
+			out << "\\n#" << i;
+			if (!culled)
+				out << " " << pass_type_name(pass.type) << " " << queue_name(pass.queue) << "\\nbarriers: " << pass.barrierCount;
+			out << "\", style=filled, fillcolor=" << (culled ? "gray40" : pass.queue == CGPU_QUEUE_TYPE_COMPUTE ? "darkorange" : "darkolivegreen") << "]\n";
+		}
+
+		for (index_type_t i = 0; i < compiled.resources.size(); ++i)
+		{
+			auto& resource = compiled.resources[i];
+			auto& source = renderGraph.resources[i];
+			bool culled = resource.name == nullptr;
+			out << "\"R" << i << "\" [label=\"";
+			write_label(source.name);
+			out << "\\n" << manage_type_name(source.manageType);
+			if (!culled)
+				out << "\\n" << resource.allocationSize << " bytes";
+			if (!culled && resource.manageType == ManageType::Managed)
+				out << "\\nblock: " << resource.aliasBlock;
+			out << "\", shape=ellipse, style=filled, fillcolor=" << (culled ? "gray40" : "skyblue") << "]\n";
+		}
+
+		out << "\n";
+		for (auto edgeIndex : renderGraph.read_edges)
+			out << "R" << renderGraph.edges[edgeIndex].from << " -> P" << renderGraph.edges[edgeIndex].to << " [color=lightgreen]\n";
+		for (auto edgeIndex : renderGraph.write_edges)
+			out << "P" << renderGraph.edges[edgeIndex].from << " -> R" << renderGraph.edges[edgeIndex].to << " [color=red2]\n";
+
+		out << "}\n";
+	}
+}
@@ -11,6 +11,11 @@ namespace HGEGraphics
 		return getResource(descriptor);
 	}
 
+	RenderPass* RenerPassPool::prewarm(const CGPURenderPassDescriptor& descriptor)
+	{
+		return prewarmResource(descriptor);
+	}
+
 	RenderPass* RenerPassPool::getResource_impl(const CGPURenderPassDescriptor& key)
 	{
 		auto cgpuRenderPass = cgpu_create_render_pass(device, &key);
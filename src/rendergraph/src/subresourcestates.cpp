@@ -0,0 +1,84 @@
+#include "subresourcestates.h"
+
+#include <cassert>
+#include <algorithm>
+
+namespace HGEGraphics
+{
+	void SubresourceStates::reset(uint32_t count, ECGPUResourceState state)
+	{
+		this->count = count;
+		spilled.clear();
+		runCount = count > 0 ? 1 : 0;
+		inlineRuns[0] = { 0, count, state };
+	}
+
+	void SubresourceStates::clear()
+	{
+		count = 0;
+		runCount = 0;
+		spilled.clear();
+		spilled.shrink_to_fit();
+	}
+
+	void SubresourceStates::set(uint32_t begin, uint32_t end, ECGPUResourceState state)
+	{
+		assert(begin < end && end <= count);
+
+		// one run may be split around the new one, so the result holds at most two more runs
+		Run local[inlineCapacity + 2];
+		std::vector<Run> heap;
+		Run* result = local;
+		if (runCount > inlineCapacity)
+		{
+			heap.resize(runCount + 2);
+			result = heap.data();
+		}
+
+		uint32_t resultCount = 0;
+		auto append = [&](uint32_t b, uint32_t e, ECGPUResourceState s)
+		{
+			if (b >= e)
+				return;
+			if (resultCount > 0 && result[resultCount - 1].state == s && result[resultCount - 1].end == b)
+				result[resultCount - 1].end = e;
+			else
+				result[resultCount++] = { b, e, s };
+		};
+
+		const Run* runs = data();
+		bool inserted = false;
+		for (uint32_t i = 0; i < runCount; ++i)
+		{
+			auto const& run = runs[i];
+			append(run.begin, std::min(run.end, begin), run.state);
+			if (!inserted && run.end > begin)
+			{
+				append(begin, end, state);
+				inserted = true;
+			}
+			append(std::max(run.begin, end), run.end, run.state);
+		}
+		store(result, resultCount);
+	}
+
+	ECGPUResourceState SubresourceStates::get(uint32_t index) const
+	{
+		assert(index < count);
+		const Run* runs = data();
+		auto iter = std::upper_bound(runs, runs + runCount, index, [](uint32_t index, const Run& run) { return index < run.end; });
+		return iter->state;
+	}
+
+	void SubresourceStates::store(const Run* runs, uint32_t size)
+	{
+		if (size <= inlineCapacity)
+		{
+			std::copy(runs, runs + size, inlineRuns);
+			spilled.clear();
+		}
+		else
+			spilled.assign(runs, runs + size);
+		runCount = size;
+	}
+}
@@ -1,5 +1,7 @@
 #include "texturepool.h"
 #include "renderer.h"
+#include <bit>
+#include <algorithm>
 
 namespace HGEGraphics
 {
@@ -7,7 +9,16 @@ namespace HGEGraphics
 	{
 		return width == other.width && height == other.height
 			&& depth == other.depth && mipLevels == other.mipLevels
-			&& format == other.format;
+			&& arraySize == other.arraySize && sampleCount == other.sampleCount
+			&& format == other.format && usage == other.usage;
+	}
+
+	uint16_t texture_bucket_extent(uint16_t extent)
+	{
+		if (extent <= 64)
+			return extent;
+		uint32_t step = std::bit_floor(uint32_t(extent)) / 8;
+		return uint16_t(std::min<uint32_t>((extent + step - 1) / step * step, UINT16_MAX));
 	}
 
 	TexturePool::TexturePool(TexturePool* upstream, std::pmr::memory_resource* const memory_resource)
@@ -15,10 +26,9 @@ namespace HGEGraphics
 	{
 	}
 
-	TextureWrap* TexturePool::getTexture(uint16_t width, uint16_t height, uint16_t depth, ECGPUFormat format)
+	TextureWrap* TexturePool::getTexture(const TextureDescriptor& descriptor)
 	{
-		TextureDescriptor key = { width, height, depth, 1, format };
-		return getResource(key);
+		return getResource(descriptor);
 	}
 	CgpuTexturePool::CgpuTexturePool(CGPUDeviceId device, CGPUQueueId gfx_queue, TexturePool* upstream, std::pmr::memory_resource* const memory_resource)
 		: TexturePool(upstream, memory_resource), device(device), gfx_queue(gfx_queue), allocator(memory_resource)
@@ -35,16 +45,17 @@ namespace HGEGraphics
 			descriptor.format == CGPU_FORMAT_D16_UNORM;
 		CGPUTextureDescriptor texture_desc =
 		{
-			.flags = CGPU_TCF_FORCE_2D,
+			.flags = descriptor.depth == 1 ? CGPU_TCF_FORCE_2D : CGPU_TCF_NONE,
 			.width = descriptor.width,
 			.height = descriptor.height,
 			.depth = descriptor.depth,
-			.array_size = 1,
+			.array_size = descriptor.arraySize,
 			.format = descriptor.format,
-			.mip_levels = 1,
+			.mip_levels = descriptor.mipLevels,
+			.sample_count = (ECGPUSampleCount)descriptor.sampleCount,
 			.owner_queue = gfx_queue,
 			.start_state = CGPU_RESOURCE_STATE_UNDEFINED,
-			.descriptors = (CGPUResourceTypes)(CGPU_RESOURCE_TYPE_TEXTURE | (isDepth ? CGPU_RESOURCE_TYPE_DEPTH_STENCIL : CGPU_RESOURCE_TYPE_RENDER_TARGET)),
+			.descriptors = (CGPUResourceTypes)(CGPU_RESOURCE_TYPE_TEXTURE | (isDepth ? CGPU_RESOURCE_TYPE_DEPTH_STENCIL : CGPU_RESOURCE_TYPE_RENDER_TARGET) | descriptor.usage),
 		};
 
 		auto texture = cgpu_create_texture(device, &texture_desc);
@@ -54,11 +65,14 @@ namespace HGEGraphics
 		resource->texture = allocator.new_object<Texture>();
 		resource->texture->handle = texture;
 		resource->texture->view = nullptr;
-		resource->texture->cur_states.resize(descriptor.depth * descriptor.mipLevels);
-		std::fill(resource->texture->cur_states.begin(), resource->texture->cur_states.end(), CGPU_RESOURCE_STATE_UNDEFINED);
-		resource->texture->states_consistent = true;
+		resource->texture->cur_states.reset(texture_desc.array_size * texture_desc.mip_levels, CGPU_RESOURCE_STATE_UNDEFINED);
+		resource->texture->unordered_access = CGPU_RESOURCE_TYPE_RW_TEXTURE == (descriptor.usage & CGPU_RESOURCE_TYPE_RW_TEXTURE);
 		return resource;
 	}
+	uint64_t CgpuTexturePool::resourceBytes_impl(const TextureWrap* resource) const
+	{
+		return resource->texture->handle->info->size_in_bytes;
+	}
 	void CgpuTexturePool::destroyResource_impl(TextureWrap* resource)
 	{
 		cgpu_free_texture(resource->texture->handle);
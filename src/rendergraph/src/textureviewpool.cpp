@@ -1,4 +1,5 @@
 #include "textureviewpool.h"
+#include "renderer.h"
 
 namespace HGEGraphics
 {
@@ -17,6 +18,7 @@ namespace HGEGraphics
 	void TextureViewPool::destroyResource_impl(TextureView* resource)
 	{
 		cgpu_free_texture_view(resource->handle);
+		invalidate_resource_bindings(resource->handle);
 		allocator.delete_object(resource);
 	}
 }
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include "workerpool.h"
+
+namespace HGEGraphics
+{
+	WorkerPool::WorkerPool(uint32_t threadCount, std::pmr::memory_resource* memory_resource)
+		: threads(memory_resource), tasks(memory_resource), background(memory_resource)
+	{
+		threads.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; ++i)
+			threads.emplace_back(&WorkerPool::loop, this, i + 1);
+	}
+
+	WorkerPool::~WorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (auto& thread : threads)
+			thread.join();
+		threads.clear();
+	}
+
+	void WorkerPool::run(uint32_t count, const std::function<void(uint32_t index, uint32_t worker)>& func)
+	{
+		if (count == 0)
+			return;
+
+		uint32_t remaining = count;
+		std::unique_lock<std::mutex> lock(mutex);
+		for (uint32_t i = 0; i < count; ++i)
+			tasks.push_back({ [&func, i](uint32_t worker) { func(i, worker); }, &remaining });
+		wake.notify_all();
+
+		// the caller works on the queue too instead of idling until the others finish
+		while (remaining > 0)
+		{
+			if (!tasks.empty())
+				execute(lock, 0);
+			else
+				done.wait(lock);
+		}
+	}
+
+	void WorkerPool::post(std::function<void(uint32_t worker)> func)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			background.push_back({ std::move(func), nullptr });
+		}
+		wake.notify_one();
+	}
+
+	void WorkerPool::loop(uint32_t worker)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true)
+		{
+			// posted work is drained before stopping, its owners may be waiting on it
+			wake.wait(lock, [this] { return stopping || !tasks.empty() || !background.empty(); });
+			if (tasks.empty() && background.empty())
+				return;
+			execute(lock, worker);
+		}
+	}
+
+	void WorkerPool::execute(std::unique_lock<std::mutex>& lock, uint32_t worker)
+	{
+		auto& queue = tasks.empty() ? background : tasks;
+		auto task = std::move(queue.front());
+		queue.pop_front();
+		lock.unlock();
+		task.func(worker);
+		lock.lock();
+		if (task.remaining && --*task.remaining == 0)
+			done.notify_all();
+	}
+}
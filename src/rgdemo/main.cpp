@@ -69,6 +69,9 @@ void on_imgui(oval_device_t* device)
 	ImGui::Text("Hello, ImGui!");
 	if (ImGui::Button("Capture"))
 		oval_render_debug_capture(device);
+	ImGui::SameLine();
+	if (ImGui::Button("Export Graph"))
+		oval_export_compiled_graph(device, "rgdemo_graph");
 
 	uint32_t length;
 	const char8_t** names;
@@ -99,7 +102,7 @@ void on_draw(oval_device_t* device, HGEGraphics::rendergraph_t& rg, HGEGraphics:
 
 	auto gPassBuilder = rendergraph_add_renderpass(&rg, u8"GPass");
 
-	renderpass_add_color_attachment(&gPassBuilder, gbuffer, CGPU_LOAD_ACTION_CLEAR, 0, CGPU_STORE_ACTION_STORE);
+	renderpass_add_color_attachment_auto(&gPassBuilder, gbuffer, true, 0);
 	struct GBufferPassData
 	{
 		Application* app;
@@ -19,6 +19,12 @@ typedef struct oval_device_descriptor
     uint16_t height;
     bool enable_capture;
     bool enable_profile;
+    bool enable_async_compute;
+    bool async_pipeline_compile;
+    uint32_t recording_threads;
+    uint64_t pool_memory_budget;
+    const char* pipeline_cache_path;
+    uint32_t bindless_texture_capacity;
 } oval_device_descriptor;
 
 typedef struct oval_device_t {
@@ -34,12 +40,23 @@ oval_device_t* oval_create_device(const oval_device_descriptor* device_descripto
 void oval_runloop(oval_device_t* device);
 void oval_free_device(oval_device_t* device);
 void oval_render_debug_capture(oval_device_t* device);
+void oval_export_compiled_graph(oval_device_t* device, const char* path);
 void oval_query_render_profile(oval_device_t* device, uint32_t* length, const char8_t*** names, const float** durations);
+void oval_query_transient_buffer_memory(oval_device_t* device, uint64_t* requested_bytes, uint64_t* allocated_bytes);
+void oval_query_compile_cache(oval_device_t* device, uint64_t* hits, uint64_t* misses);
+void oval_query_pipeline_cache(oval_device_t* device, uint32_t* prewarmed, uint32_t* uncached);
+void oval_query_pipeline_compiles(oval_device_t* device, uint32_t* pending, uint32_t* skipped_draws);
+void oval_set_fallback_shader(oval_device_t* device, HGEGraphics::Shader* shader);
+void oval_query_pool_stats(oval_device_t* device, uint32_t* length, const char8_t*** names, const HGEGraphics::ResourcePoolStats** stats);
+void oval_query_barrier_count(oval_device_t* device, uint32_t* declared_order, uint32_t* scheduled_order);
+void oval_query_attachment_actions(oval_device_t* device, uint32_t* dontcare_loads, uint32_t* discarded_stores);
 
 HGEGraphics::Texture* oval_create_texture(oval_device_t* device, const CGPUTextureDescriptor& desc);
 HGEGraphics::Texture* oval_create_texture_from_buffer(oval_device_t* device, const CGPUTextureDescriptor& desc, void* data, uint64_t size);
 HGEGraphics::Texture* oval_load_texture(oval_device_t* device, const char8_t* filepath, bool mipmap);
 void oval_free_texture(oval_device_t* device, HGEGraphics::Texture* texture);
+bool oval_bindless_supported(oval_device_t* device);
+uint32_t oval_texture_bindless_index(oval_device_t* device, HGEGraphics::Texture* texture);
 HGEGraphics::Mesh* oval_load_mesh(oval_device_t* device, const char8_t* filepath);
 HGEGraphics::Mesh* oval_create_mesh_from_buffer(oval_device_t* device, uint32_t vertex_count, uint32_t index_count, ECGPUPrimitiveTopology prim_topology, const CGPUVertexLayout& vertex_layout, uint32_t index_stride, const uint8_t* vertex_data, const uint8_t* index_data, bool update_vertex_data_from_compute_shader, bool update_index_data_from_compute_shader);
 void oval_free_mesh(oval_device_t* device, HGEGraphics::Mesh* mesh);
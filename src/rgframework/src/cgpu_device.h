@@ -8,6 +8,11 @@
 #include "ktx.h"
 #include "stb_image.h"
 #include "renderer.h"
+#include "rendergraph_compiler.h"
+#include "bufferarena.h"
+#include "historypool.h"
+#include "pipelinecache.h"
+#include "bindlessheap.h"
 
 struct oval_transfer_data_to_texture
 {
@@ -44,9 +49,13 @@ struct FrameData
 {
 	CGPUFenceId inflightFence;
 	HGEGraphics::ExecutorContext execContext;
+	HGEGraphics::BufferArena constants;
+	HGEGraphics::BufferArena staging;
 
-	FrameData(CGPUDeviceId device, CGPUQueueId gfx_queue, bool profile, std::pmr::memory_resource* memory_resource)
-		: execContext(device, gfx_queue, profile, memory_resource)
+	FrameData(CGPUDeviceId device, CGPUQueueId gfx_queue, CGPUQueueId compute_queue, HGEGraphics::WorkerPool* worker_pool, bool profile, std::pmr::memory_resource* memory_resource)
+		: execContext(device, gfx_queue, compute_queue, worker_pool, profile, memory_resource),
+		constants(device, u8"constant buffer", CGPU_RESOURCE_TYPE_UNIFORM_BUFFER | CGPU_RESOURCE_TYPE_RW_BUFFER, CGPU_MEM_USAGE_CPU_TO_GPU, CGPU_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER, cgpu_query_adapter_detail(device->adapter)->uniform_buffer_alignment, 64 * 1024, memory_resource),
+		staging(device, u8"staging buffer", CGPU_RESOURCE_TYPE_NONE, CGPU_MEM_USAGE_CPU_ONLY, CGPU_RESOURCE_STATE_COPY_SOURCE, cgpu_query_adapter_detail(device->adapter)->upload_buffer_texture_alignment, 4 * 1024 * 1024, memory_resource)
 	{
 		inflightFence = cgpu_create_fence(device);
 	}
@@ -54,11 +63,15 @@ struct FrameData
 	void newFrame()
 	{
 		execContext.newFrame();
+		constants.newFrame();
+		staging.newFrame();
 	}
 
 	void free()
 	{
 		execContext.destroy();
+		constants.destroy();
+		staging.destroy();
 
 		cgpu_free_fence(inflightFence);
 		inflightFence = CGPU_NULLPTR;
@@ -106,7 +119,7 @@ struct TexturedVertex
 
 typedef struct oval_cgpu_device_t {
 	oval_cgpu_device_t(const oval_device_t& super, std::pmr::memory_resource* memory_resource)
-		: super(super), memory_resource(memory_resource), transfer_queue(memory_resource), allocator(memory_resource), wait_load_resources(memory_resource)
+		: super(super), memory_resource(memory_resource), transfer_queue(memory_resource), allocator(memory_resource), wait_load_resources(memory_resource), compile_cache(memory_resource)
 	{
 	}
 
@@ -118,12 +131,20 @@ typedef struct oval_cgpu_device_t {
 	CGPUDeviceId device;
 	CGPUQueueId gfx_queue;
 	CGPUQueueId present_queue;
+	CGPUQueueId compute_queue = CGPU_NULLPTR;
+	HGEGraphics::WorkerPool* worker_pool = nullptr;
+	HGEGraphics::HistoryPool* history_pool = nullptr;
+	HGEGraphics::PoolBudget pool_budget;
+	HGEGraphics::PipelineCache* pipeline_cache = nullptr;
+	std::string pipeline_cache_path;
+	HGEGraphics::BindlessHeap* bindless_heap = nullptr;
 
 	CGPUSurfaceId surface;
 	CGPUSwapChainId swapchain;
 	std::vector<HGEGraphics::Backbuffer> backbuffer;
 	std::vector<CGPUSemaphoreId> swapchain_prepared_semaphores;
 
+	static constexpr uint32_t frames_in_flight = 3;
 	std::vector<FrameData> frameDatas;
 	CGPUSemaphoreId render_finished_semaphore;
 	uint32_t current_frame_index;
@@ -131,6 +152,7 @@ typedef struct oval_cgpu_device_t {
 
 	HGEGraphics::Shader* blit_shader = nullptr;
 	CGPUSamplerId blit_linear_sampler = CGPU_NULLPTR;
+	HGEGraphics::ComputeShader* mipmap_shader = nullptr;
 
 	HGEGraphics::Texture* imgui_font_texture = nullptr;
 	HGEGraphics::Shader* imgui_shader = nullptr;
@@ -141,15 +163,21 @@ typedef struct oval_cgpu_device_t {
 
 	bool rdc_capture = false;
 	RENDERDOC_API_1_0_0* rdc = nullptr;
+	std::string graph_export_path;
 
 	std::pmr::vector<oval_graphics_transfer_queue*> transfer_queue;
 	std::queue<WaitLoadResource, std::pmr::deque<WaitLoadResource>> wait_load_resources;
 	oval_graphics_transfer_queue* cur_transfer_queue = nullptr;
 
 	HGEGraphics::Texture* default_texture;
+
+	HGEGraphics::CompileCache compile_cache;
+	HGEGraphics::TransientMemoryStats transient_memory_stats = {};
 } oval_cgpu_device_t;
 
 void oval_process_load_queue(oval_cgpu_device_t* device);
+void oval_prewarm_pipelines(oval_cgpu_device_t* device, HGEGraphics::Shader* shader);
+void oval_prewarm_pipelines(oval_cgpu_device_t* device, HGEGraphics::ComputeShader* shader);
 void oval_graphics_transfer_queue_execute_all(oval_cgpu_device_t* device, HGEGraphics::rendergraph_t& rg);
 void oval_graphics_transfer_queue_release_all(oval_cgpu_device_t* device);
 uint64_t load_mesh(oval_cgpu_device_t* device, oval_graphics_transfer_queue_t queue, HGEGraphics::Mesh* mesh, const char8_t* filepath);
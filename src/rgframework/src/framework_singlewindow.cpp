@@ -5,6 +5,8 @@
 #include "rendergraph.h"
 #include "rendergraph_compiler.h"
 #include "rendergraph_executor.h"
+#include "rendergraph_export.h"
+#include <fstream>
 #include "imgui_impl_sdl2.h"
 #include <time.h>
 #include "tiny_obj_loader.h"
@@ -172,17 +174,26 @@ oval_device_t* oval_create_device(const oval_device_descriptor* device_descripto
 	auto adapter = adapters[0];
 
 	// Create device
-	CGPUQueueGroupDescriptor G = {
-		.queue_type = CGPU_QUEUE_TYPE_GRAPHICS,
-		.queue_count = 1
+	bool async_compute = device_descriptor->enable_async_compute && cgpu_query_queue_count(adapter, CGPU_QUEUE_TYPE_COMPUTE) > 0;
+	CGPUQueueGroupDescriptor G[2] = {
+		{
+			.queue_type = CGPU_QUEUE_TYPE_GRAPHICS,
+			.queue_count = 1
+		},
+		{
+			.queue_type = CGPU_QUEUE_TYPE_COMPUTE,
+			.queue_count = 1
+		},
 	};
 	CGPUDeviceDescriptor device_desc = {
-		.queue_groups = &G,
-		.queue_group_count = 1
+		.queue_groups = G,
+		.queue_group_count = async_compute ? 2u : 1u
 	};
 	device_cgpu->device = cgpu_create_device(adapter, &device_desc);
 	device_cgpu->gfx_queue = cgpu_get_queue(device_cgpu->device, CGPU_QUEUE_TYPE_GRAPHICS, 0);
 	device_cgpu->present_queue = device_cgpu->gfx_queue;
+	if (async_compute)
+		device_cgpu->compute_queue = cgpu_get_queue(device_cgpu->device, CGPU_QUEUE_TYPE_COMPUTE, 0);
 	free(adapters);
 	SDL_SysWMinfo wmInfo;
 	SDL_VERSION(&wmInfo.version);
@@ -239,10 +250,43 @@ oval_device_t* oval_create_device(const oval_device_descriptor* device_descripto
 		device_cgpu->default_texture = oval_create_texture_from_buffer(&device_cgpu->super, default_texture_desc, colors, sizeof(colors));
 	}
 
-	for (uint32_t i = 0; i < 3; ++i)
+	if (device_descriptor->recording_threads > 0)
+		device_cgpu->worker_pool = new HGEGraphics::WorkerPool(device_descriptor->recording_threads, device_cgpu->memory_resource);
+
+	// history textures stay alive until every frame in flight that may read them is done, plus the one being recorded
+	device_cgpu->history_pool = new HGEGraphics::HistoryPool(device_cgpu->device, oval_cgpu_device_t::frames_in_flight + 1, device_cgpu->memory_resource);
+
+	// pipelines seen by earlier runs are created as soon as their shader is loaded
+	if (device_descriptor->pipeline_cache_path)
 	{
-		device_cgpu->frameDatas.emplace_back(device_cgpu->device, device_cgpu->gfx_queue, device_cgpu->super.descriptor.enable_profile, device_cgpu->memory_resource);
+		device_cgpu->pipeline_cache_path = device_descriptor->pipeline_cache_path;
+		device_cgpu->pipeline_cache = new HGEGraphics::PipelineCache(device_cgpu->memory_resource);
+		device_cgpu->pipeline_cache->load(device_cgpu->pipeline_cache_path.c_str());
+	}
+
+	// stays disabled without descriptor indexing, shaders then have to bind their textures per draw
+	if (device_descriptor->bindless_texture_capacity > 0)
+	{
+		device_cgpu->bindless_heap = new HGEGraphics::BindlessHeap(device_cgpu->memory_resource);
+		if (!device_cgpu->bindless_heap->init(device_cgpu->device, device_descriptor->bindless_texture_capacity))
+		{
+			delete device_cgpu->bindless_heap;
+			device_cgpu->bindless_heap = nullptr;
+		}
+	}
+
+	// 0 leaves the pools unbounded, they then only drop what has been unused for a while
+	if (device_descriptor->pool_memory_budget > 0)
+		device_cgpu->pool_budget.budget_bytes = device_descriptor->pool_memory_budget;
+
+	for (uint32_t i = 0; i < oval_cgpu_device_t::frames_in_flight; ++i)
+	{
+		device_cgpu->frameDatas.emplace_back(device_cgpu->device, device_cgpu->gfx_queue, device_cgpu->compute_queue, device_cgpu->worker_pool, device_cgpu->super.descriptor.enable_profile, device_cgpu->memory_resource);
 		device_cgpu->frameDatas[i].execContext.default_texture = device_cgpu->default_texture->view;
+		device_cgpu->frameDatas[i].execContext.setPoolBudget(&device_cgpu->pool_budget);
+		device_cgpu->frameDatas[i].execContext.setPipelineCache(device_cgpu->pipeline_cache);
+		device_cgpu->frameDatas[i].execContext.setBindlessHeap(device_cgpu->bindless_heap);
+		device_cgpu->frameDatas[i].execContext.setAsyncPipelineCompile(device_descriptor->async_pipeline_compile, nullptr);
 	}
 
 	IMGUI_CHECKVERSION();
@@ -287,6 +331,7 @@ oval_device_t* oval_create_device(const oval_device_descriptor* device_descripto
 		#include "blit.ps.spv.h"
 	};
 	device_cgpu->blit_shader = HGEGraphics::create_shader(device_cgpu->device, blit_vert_spv, sizeof(blit_vert_spv), blit_frag_spv, sizeof(blit_frag_spv), blit_blend_desc, depth_desc, rasterizer_state);
+	oval_prewarm_pipelines(device_cgpu, device_cgpu->blit_shader);
 
 	CGPUSamplerDescriptor blit_linear_sampler_desc = {
 		.min_filter = CGPU_FILTER_TYPE_LINEAR,
@@ -300,6 +345,12 @@ oval_device_t* oval_create_device(const oval_device_descriptor* device_descripto
 	};
 	device_cgpu->blit_linear_sampler = cgpu_create_sampler(device_cgpu->device, &blit_linear_sampler_desc);
 
+	uint8_t mipmap_comp_spv[] = {
+		#include "mipmap.cs.spv.h"
+	};
+	device_cgpu->mipmap_shader = HGEGraphics::create_compute_shader(device_cgpu->device, mipmap_comp_spv, sizeof(mipmap_comp_spv));
+	oval_prewarm_pipelines(device_cgpu, device_cgpu->mipmap_shader);
+
 	CGPUBlendStateDescriptor imgui_blend_desc = {
 		.src_factors = { CGPU_BLEND_CONST_SRC_ALPHA },
 		.dst_factors = { CGPU_BLEND_CONST_ONE_MINUS_SRC_ALPHA },
@@ -318,6 +369,7 @@ oval_device_t* oval_create_device(const oval_device_descriptor* device_descripto
 		#include "imgui.ps.spv.h"
 	};
 	device_cgpu->imgui_shader = HGEGraphics::create_shader(device_cgpu->device, imgui_vert_spv, sizeof(imgui_vert_spv), imgui_frag_spv, sizeof(imgui_frag_spv), imgui_blend_desc, depth_desc, rasterizer_state);
+	oval_prewarm_pipelines(device_cgpu, device_cgpu->imgui_shader);
 
 	CGPUVertexLayout imgui_vertex_layout =
 	{
@@ -390,7 +442,7 @@ HGEGraphics::Mesh* setupImGuiResourcesMesh(oval_cgpu_device_t* device, HGEGraphi
 					const ImDrawList* cmd_list = drawData->CmdLists[n];
 					upload(encoder, offset, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert), cmd_list->VtxBuffer.Data);
 
-					offset += cmd_list->VtxBuffer.Size;
+					offset += cmd_list->VtxBuffer.Size * sizeof(ImDrawVert);
 				}
 			}, 0, nullptr);
 
@@ -405,7 +457,7 @@ HGEGraphics::Mesh* setupImGuiResourcesMesh(oval_cgpu_device_t* device, HGEGraphi
 					const ImDrawList* cmd_list = drawData->CmdLists[n];
 					upload(encoder, offset, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx), cmd_list->IdxBuffer.Data);
 
-					offset += cmd_list->IdxBuffer.Size;
+					offset += cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx);
 				}
 			}, 0, nullptr);
 	}
@@ -482,6 +534,13 @@ void render(oval_cgpu_device_t* device, HGEGraphics::Backbuffer* backbuffer)
 
 	std::pmr::unsynchronized_pool_resource rg_pool(device->memory_resource);
 	rendergraph_t rg{ 1, 1, 1, device->blit_shader, device->blit_linear_sampler, &rg_pool };
+	rendergraph_set_async_compute(&rg, device->compute_queue != CGPU_NULLPTR);
+	rendergraph_set_mipmap_shader(&rg, device->mipmap_shader);
+	auto& frameData = device->frameDatas[device->current_frame_index];
+	rendergraph_set_constant_arena(&rg, &frameData.constants);
+	rendergraph_set_staging_arena(&rg, &frameData.staging);
+	device->history_pool->newFrame();
+	rendergraph_set_history_pool(&rg, device->history_pool);
 
 	oval_graphics_transfer_queue_execute_all(device, rg);
 
@@ -495,8 +554,17 @@ void render(oval_cgpu_device_t* device, HGEGraphics::Backbuffer* backbuffer)
 
 	rendergraph_present(&rg, rg_back_buffer);
 
-	auto compiled = Compiler::Compile(rg, &rg_pool);
-	Executor::Execute(compiled, device->frameDatas[device->current_frame_index].execContext);
+	auto& compiled = Compiler::Compile(rg, device->compile_cache);
+	if (!device->graph_export_path.empty())
+	{
+		std::ofstream json(device->graph_export_path + ".json");
+		rendergraph_export_json(rg, compiled, json);
+		std::ofstream dot(device->graph_export_path + ".dot");
+		rendergraph_export_graphviz(rg, compiled, dot);
+		device->graph_export_path.clear();
+	}
+	Executor::Execute(compiled, frameData.execContext);
+	device->transient_memory_stats = compiled.transientMemory;
 
 	for (auto imported : rg.imported_textures)
 	{
@@ -681,16 +749,38 @@ void oval_runloop(oval_device_t* device)
 
 		render(D, back_buffer);
 
-		CGPUQueueSubmitDescriptor submit_desc = {
-			.cmds = cur_frame_data.execContext.allocated_cmds.data(),
-			.signal_fence = cur_frame_data.inflightFence,
-			.wait_semaphores = &prepared_semaphore,
-			.signal_semaphores = &D->render_finished_semaphore,
-			.cmds_count = (uint32_t)cur_frame_data.execContext.allocated_cmds.size(),
-			.wait_semaphore_count = 1,
-			.signal_semaphore_count = 1,
-		};
-		cgpu_submit_queue(D->gfx_queue, &submit_desc);
+		auto& submissions = cur_frame_data.execContext.submissions;
+		for (size_t i = 0; i < submissions.size(); ++i)
+		{
+			auto& submission = submissions[i];
+			bool first = i == 0;
+			bool last = i + 1 == submissions.size();
+
+			CGPUSemaphoreId wait_semaphores[2];
+			uint32_t wait_semaphore_count = 0;
+			if (first)
+				wait_semaphores[wait_semaphore_count++] = prepared_semaphore;
+			if (submission.wait_semaphore)
+				wait_semaphores[wait_semaphore_count++] = submission.wait_semaphore;
+
+			CGPUSemaphoreId signal_semaphores[2];
+			uint32_t signal_semaphore_count = 0;
+			if (last)
+				signal_semaphores[signal_semaphore_count++] = D->render_finished_semaphore;
+			if (submission.signal_semaphore)
+				signal_semaphores[signal_semaphore_count++] = submission.signal_semaphore;
+
+			CGPUQueueSubmitDescriptor submit_desc = {
+				.cmds = submission.cmds,
+				.signal_fence = last ? cur_frame_data.inflightFence : CGPU_NULLPTR,
+				.wait_semaphores = wait_semaphores,
+				.signal_semaphores = signal_semaphores,
+				.cmds_count = submission.cmd_count,
+				.wait_semaphore_count = wait_semaphore_count,
+				.signal_semaphore_count = signal_semaphore_count,
+			};
+			cgpu_submit_queue(submission.queue == CGPU_QUEUE_TYPE_COMPUTE ? D->compute_queue : D->gfx_queue, &submit_desc);
+		}
 
 		CGPUQueuePresentDescriptor present_desc = {
 			.swapchain = D->swapchain,
@@ -717,8 +807,10 @@ void oval_runloop(oval_device_t* device)
 	}
 
 	cgpu_wait_queue_idle(D->gfx_queue);
+	if (D->compute_queue)
+		cgpu_wait_queue_idle(D->compute_queue);
 
-	for (int i = 0; i < 3; ++i)
+	for (uint32_t i = 0; i < oval_cgpu_device_t::frames_in_flight; ++i)
 	{
 		D->frameDatas[i].execContext.pre_destroy();
 	}
@@ -758,6 +850,10 @@ void oval_free_device(oval_device_t* device)
 		cgpu_free_sampler(D->blit_linear_sampler);
 	D->blit_linear_sampler = nullptr;
 
+	if (D->mipmap_shader)
+		free_compute_shader(D->mipmap_shader);
+	D->mipmap_shader = nullptr;
+
 	for (uint32_t i = 0; i < D->swapchain_prepared_semaphores.size(); ++i)
 	{
 		cgpu_free_semaphore(D->swapchain_prepared_semaphores[i]);
@@ -787,6 +883,26 @@ void oval_free_device(oval_device_t* device)
 		D->frameDatas[i].free();
 	}
 
+	D->history_pool->destroy();
+	delete D->history_pool;
+	D->history_pool = nullptr;
+
+	if (D->pipeline_cache)
+	{
+		D->pipeline_cache->save(D->pipeline_cache_path.c_str());
+		delete D->pipeline_cache;
+	}
+	D->pipeline_cache = nullptr;
+
+	delete D->bindless_heap;
+	D->bindless_heap = nullptr;
+
+	delete D->worker_pool;
+	D->worker_pool = nullptr;
+
+	if (D->compute_queue)
+		cgpu_free_queue(D->compute_queue);
+	D->compute_queue = CGPU_NULLPTR;
 	cgpu_free_queue(D->gfx_queue);
 	D->gfx_queue = CGPU_NULLPTR;
 	D->present_queue = CGPU_NULLPTR;
@@ -815,6 +931,12 @@ void oval_render_debug_capture(oval_device_t* device)
 	D->rdc_capture = true;
 }
 
+void oval_export_compiled_graph(oval_device_t* device, const char* path)
+{
+	auto D = (oval_cgpu_device_t*)device;
+	D->graph_export_path = path;
+}
+
 void oval_query_render_profile(oval_device_t* device, uint32_t* length, const char8_t*** names, const float** durations)
 {
 	auto D = (oval_cgpu_device_t*)device;
@@ -830,3 +952,91 @@ void oval_query_render_profile(oval_device_t* device, uint32_t* length, const ch
 		*durations = nullptr;
 	}
 }
+
+void oval_query_transient_buffer_memory(oval_device_t* device, uint64_t* requested_bytes, uint64_t* allocated_bytes)
+{
+	auto D = (oval_cgpu_device_t*)device;
+	*requested_bytes = D->transient_memory_stats.requested_bytes;
+	*allocated_bytes = D->transient_memory_stats.allocated_bytes;
+}
+
+void oval_query_compile_cache(oval_device_t* device, uint64_t* hits, uint64_t* misses)
+{
+	auto D = (oval_cgpu_device_t*)device;
+	*hits = D->compile_cache.hits;
+	*misses = D->compile_cache.misses;
+}
+
+void oval_query_pipeline_cache(oval_device_t* device, uint32_t* prewarmed, uint32_t* uncached)
+{
+	auto D = (oval_cgpu_device_t*)device;
+	*prewarmed = D->pipeline_cache ? D->pipeline_cache->prewarmed() : 0;
+	*uncached = D->pipeline_cache ? D->pipeline_cache->uncached() : 0;
+}
+
+void oval_query_pipeline_compiles(oval_device_t* device, uint32_t* pending, uint32_t* skipped_draws)
+{
+	auto D = (oval_cgpu_device_t*)device;
+	auto& cur_frame_data = D->frameDatas[D->current_frame_index];
+	cur_frame_data.execContext.queryPipelineCompiles(*pending, *skipped_draws);
+}
+
+void oval_set_fallback_shader(oval_device_t* device, HGEGraphics::Shader* shader)
+{
+	auto D = (oval_cgpu_device_t*)device;
+	for (auto& frameData : D->frameDatas)
+		frameData.execContext.setAsyncPipelineCompile(D->super.descriptor.async_pipeline_compile, shader);
+}
+
+void oval_prewarm_pipelines(oval_cgpu_device_t* device, HGEGraphics::Shader* shader)
+{
+	if (!device->pipeline_cache)
+		return;
+	for (auto& frameData : device->frameDatas)
+		device->pipeline_cache->prewarm(frameData.execContext, shader);
+}
+
+void oval_prewarm_pipelines(oval_cgpu_device_t* device, HGEGraphics::ComputeShader* shader)
+{
+	if (!device->pipeline_cache)
+		return;
+	for (auto& frameData : device->frameDatas)
+		device->pipeline_cache->prewarm(frameData.execContext, shader);
+}
+
+void oval_query_pool_stats(oval_device_t* device, uint32_t* length, const char8_t*** names, const HGEGraphics::ResourcePoolStats** stats)
+{
+	auto D = (oval_cgpu_device_t*)device;
+	auto& cur_frame_data = D->frameDatas[D->current_frame_index];
+	cur_frame_data.execContext.queryPoolStats(*length, *names, *stats);
+}
+
+void oval_query_barrier_count(oval_device_t* device, uint32_t* declared_order, uint32_t* scheduled_order)
+{
+	auto D = (oval_cgpu_device_t*)device;
+	if (D->compile_cache.compiled)
+	{
+		*declared_order = D->compile_cache.compiled->schedule.declared_barrier_count;
+		*scheduled_order = D->compile_cache.compiled->schedule.scheduled_barrier_count;
+	}
+	else
+	{
+		*declared_order = 0;
+		*scheduled_order = 0;
+	}
+}
+
+void oval_query_attachment_actions(oval_device_t* device, uint32_t* dontcare_loads, uint32_t* discarded_stores)
+{
+	auto D = (oval_cgpu_device_t*)device;
+	if (D->compile_cache.compiled)
+	{
+		*dontcare_loads = D->compile_cache.compiled->attachmentActions.dontcare_loads;
+		*discarded_stores = D->compile_cache.compiled->attachmentActions.discarded_stores;
+	}
+	else
+	{
+		*dontcare_loads = 0;
+		*discarded_stores = 0;
+	}
+}
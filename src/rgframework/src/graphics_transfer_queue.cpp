@@ -36,11 +36,13 @@ uint8_t* oval_graphics_transfer_queue_transfer_data_to_texture_full(oval_graphic
 	auto mipedSize = [](uint64_t size, uint64_t mip) { return std::max<uint64_t>(size >> mip, 1ull); };
 
 	uint64_t used_size = 0;
+	const uint64_t blockWidth = FormatUtil_WidthOfBlock(texture->handle->info->format);
+	const uint64_t blockHeight = FormatUtil_HeightOfBlock(texture->handle->info->format);
 	size_t maxMipmap = generate_mipmap ? std::min((uint32_t)generate_mipmap_from, texture->handle->info->mip_levels) : texture->handle->info->mip_levels;
 	for (size_t mipmap = 0; mipmap < maxMipmap; ++mipmap)
 	{
-		const uint64_t xBlocksCount = mipedSize(texture->handle->info->width, mipmap) / FormatUtil_WidthOfBlock(texture->handle->info->format);
-		const uint64_t yBlocksCount = mipedSize(texture->handle->info->height, mipmap) / FormatUtil_HeightOfBlock(texture->handle->info->format);
+		const uint64_t xBlocksCount = (mipedSize(texture->handle->info->width, mipmap) + blockWidth - 1) / blockWidth;
+		const uint64_t yBlocksCount = (mipedSize(texture->handle->info->height, mipmap) + blockHeight - 1) / blockHeight;
 		const uint64_t zBlocksCount = mipedSize(texture->handle->info->depth, mipmap);
 		used_size += xBlocksCount * yBlocksCount * zBlocksCount * (texture->handle->info->array_size_minus_one + 1) * FormatUtil_BitSizeOfBlock(texture->handle->info->format) / 8;
 	}
@@ -59,8 +61,10 @@ uint8_t* oval_graphics_transfer_queue_transfer_data_to_texture_slice(oval_graphi
 
 	auto mipedSize = [](uint64_t size, uint64_t mip) { return std::max<uint64_t>(size >> mip, 1ull); };
 
-	const uint64_t xBlocksCount = mipedSize(texture->handle->info->width, mipmap) / FormatUtil_WidthOfBlock(texture->handle->info->format);
-	const uint64_t yBlocksCount = mipedSize(texture->handle->info->height, mipmap) / FormatUtil_HeightOfBlock(texture->handle->info->format);
+	const uint64_t blockWidth = FormatUtil_WidthOfBlock(texture->handle->info->format);
+	const uint64_t blockHeight = FormatUtil_HeightOfBlock(texture->handle->info->format);
+	const uint64_t xBlocksCount = (mipedSize(texture->handle->info->width, mipmap) + blockWidth - 1) / blockWidth;
+	const uint64_t yBlocksCount = (mipedSize(texture->handle->info->height, mipmap) + blockHeight - 1) / blockHeight;
 	const uint64_t zBlocksCount = mipedSize(texture->handle->info->depth, mipmap);
 	uint64_t used_size = xBlocksCount * yBlocksCount * zBlocksCount * FormatUtil_BitSizeOfBlock(texture->handle->info->format) / 8;
 
@@ -86,21 +90,8 @@ void uploadTexture(HGEGraphics::rendergraph_t& rg, std::pmr::vector<HGEGraphics:
 
 	if (waited.transfer_full)
 	{
-		auto data = waited.data;
-		for (size_t mipmap = 0; mipmap < (waited.generate_mipmap ? 1 : waited.texture->handle->info->mip_levels); ++mipmap)
-		{
-			for (size_t slice = 0; slice < waited.texture->handle->info->array_size_minus_one + 1; ++slice)
-			{
-				auto mipedSize = [](uint64_t size, uint64_t mip) { return std::max<uint64_t>(size >> mip, 1ull); };
-				const uint64_t xBlocksCount = mipedSize(waited.texture->handle->info->width, mipmap) / FormatUtil_WidthOfBlock(waited.texture->handle->info->format);
-				const uint64_t yBlocksCount = mipedSize(waited.texture->handle->info->height, mipmap) / FormatUtil_HeightOfBlock(waited.texture->handle->info->format);
-				const uint64_t zBlocksCount = mipedSize(waited.texture->handle->info->depth, mipmap);
-				uint64_t size = xBlocksCount * yBlocksCount * zBlocksCount * FormatUtil_BitSizeOfBlock(waited.texture->handle->info->format) / 8;
-				uint64_t offset = 0;
-				rendergraph_add_uploadtexturepass_ex(&rg, u8"upload texture", texture_handle, mipmap, slice, size, offset, data, [](HGEGraphics::UploadEncoder* encoder, void* passdata) {}, 0, nullptr);
-				data += size;
-			}
-		}
+		uint8_t mipCount = waited.generate_mipmap ? std::min<uint32_t>(waited.generate_mipmap_from, waited.texture->handle->info->mip_levels) : waited.texture->handle->info->mip_levels;
+		rendergraph_add_uploadtexturepass_full(&rg, u8"upload texture", texture_handle, mipCount, waited.size, waited.data);
 	}
 	else
 	{
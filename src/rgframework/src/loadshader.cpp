@@ -5,8 +5,10 @@ HGEGraphics::Shader* oval_create_shader(oval_device_t* device, const std::string
 	auto D = (oval_cgpu_device_t*)device;
 	auto vertShaderCode = readfile((const char8_t*)vertPath.c_str());
 	auto fragShaderCode = readfile((const char8_t*)fragPath.c_str());
-	return HGEGraphics::create_shader(D->device, reinterpret_cast<const uint8_t*>(vertShaderCode.data()), (uint32_t)vertShaderCode.size(), reinterpret_cast<const uint8_t*>(fragShaderCode.data()), (uint32_t)fragShaderCode.size(),
+	auto shader = HGEGraphics::create_shader(D->device, reinterpret_cast<const uint8_t*>(vertShaderCode.data()), (uint32_t)vertShaderCode.size(), reinterpret_cast<const uint8_t*>(fragShaderCode.data()), (uint32_t)fragShaderCode.size(),
 		blend_desc, depth_desc, rasterizer_state);
+	oval_prewarm_pipelines(D, shader);
+	return shader;
 }
 
 void oval_free_shader(oval_device_t* device, HGEGraphics::Shader* shader)
@@ -18,7 +20,9 @@ HGEGraphics::ComputeShader* oval_create_compute_shader(oval_device_t* device, co
 {
 	auto D = (oval_cgpu_device_t*)device;
 	auto compShaderCode = readfile((const char8_t*)compPath.c_str());
-	return HGEGraphics::create_compute_shader(D->device, reinterpret_cast<const uint8_t*>(compShaderCode.data()), compShaderCode.size());
+	auto shader = HGEGraphics::create_compute_shader(D->device, reinterpret_cast<const uint8_t*>(compShaderCode.data()), compShaderCode.size());
+	oval_prewarm_pipelines(D, shader);
+	return shader;
 }
 
 void oval_free_compute_shader(oval_device_t* device, HGEGraphics::ComputeShader* shader)
@@ -38,6 +38,12 @@ std::pair<ECGPUFormat, int> detectKtxTextureFormat(ktxTexture* ktxTexture)
 	return { CGPU_FORMAT_UNDEFINED, 0 };
 }
 
+static bool format_supports_storage(oval_cgpu_device_t* device, ECGPUFormat format)
+{
+	auto detail = cgpu_query_adapter_detail(device->device->adapter);
+	return detail->format_supports[format].shader_write;
+}
+
 uint64_t load_texture_ktx(oval_cgpu_device_t* device, oval_graphics_transfer_queue_t queue, HGEGraphics::Texture* texture, const char8_t* filepath, bool mipmap)
 {
 	ktxResult result = KTX_SUCCESS;
@@ -64,7 +70,11 @@ uint64_t load_texture_ktx(oval_cgpu_device_t* device, oval_graphics_transfer_que
 	mipLevels = mipmap ? (mipLevels > 1 ? mipLevels : (static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1)) : 1;
 	CGPUResourceTypes descriptors = CGPU_RESOURCE_TYPE_TEXTURE;
 	if (generateMipmap)
+	{
 		descriptors |= CGPU_RESOURCE_TYPE_RENDER_TARGET;
+		if (format_supports_storage(device, format))
+			descriptors |= CGPU_RESOURCE_TYPE_RW_TEXTURE;
+	}
 	if (ktxTexture->isCubemap)
 	{
 		descriptors |= CGPU_RESOURCE_TYPE_TEXTURE_CUBE;
@@ -150,6 +160,13 @@ uint64_t load_texture_raw(oval_cgpu_device_t* device, oval_graphics_transfer_que
 	}
 
 	auto mipLevels = mipmap ? static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1 : 1;
+	CGPUResourceTypes descriptors = CGPU_RESOURCE_TYPE_TEXTURE;
+	if (mipmap)
+	{
+		descriptors |= CGPU_RESOURCE_TYPE_RENDER_TARGET;
+		if (format_supports_storage(device, CGPU_FORMAT_R8G8B8A8_SRGB))
+			descriptors |= CGPU_RESOURCE_TYPE_RW_TEXTURE;
+	}
 	CGPUTextureDescriptor texture_desc =
 	{
 		.name = (const char8_t*)filename,
@@ -161,7 +178,7 @@ uint64_t load_texture_raw(oval_cgpu_device_t* device, oval_graphics_transfer_que
 		.mip_levels = mipLevels,
 		.owner_queue = device->gfx_queue,
 		.start_state = CGPU_RESOURCE_STATE_UNDEFINED,
-		.descriptors = CGPUResourceTypes(mipmap ? CGPU_RESOURCE_TYPE_TEXTURE | CGPU_RESOURCE_TYPE_RENDER_TARGET : CGPU_RESOURCE_TYPE_TEXTURE),
+		.descriptors = descriptors,
 	};
 
 	HGEGraphics::init_texture(texture, device->device, texture_desc);
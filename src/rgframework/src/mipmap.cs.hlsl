@@ -0,0 +1,74 @@
+[[vk::binding(0, 0)]]
+Texture2D source : register(t0);
+[[vk::binding(1, 0)]]
+SamplerState linearSampler : register(s0);
+[[vk::binding(2, 0)]]
+RWTexture2D<float4> outMip1 : register(u0);
+[[vk::binding(3, 0)]]
+RWTexture2D<float4> outMip2 : register(u1);
+[[vk::binding(4, 0)]]
+RWTexture2D<float4> outMip3 : register(u2);
+[[vk::binding(5, 0)]]
+RWTexture2D<float4> outMip4 : register(u3);
+
+struct PushConstants
+{
+	float2 texelSize;
+	uint2 outSize;
+	uint mipCount;
+};
+
+[[vk::push_constant]]
+PushConstants pushConstants;
+
+groupshared float4 tile[64];
+
+void storeMip(RWTexture2D<float4> target, uint2 coord, uint shift, float4 color)
+{
+	uint2 size = max(pushConstants.outSize >> shift, 1);
+	if (all(coord < size))
+		target[coord] = color;
+}
+
+[shader("compute")]
+[numthreads(8, 8, 1)]
+void main(uint groupIndex : SV_GroupIndex, uint3 dispatchId : SV_DispatchThreadID)
+{
+	// a bilinear tap centered between the four source texels averages them
+	float2 uv = (dispatchId.xy + 0.5) * pushConstants.texelSize;
+	float4 color = source.SampleLevel(linearSampler, uv, 0);
+	storeMip(outMip1, dispatchId.xy, 0, color);
+	if (pushConstants.mipCount == 1)
+		return;
+
+	tile[groupIndex] = color;
+	GroupMemoryBarrierWithGroupSync();
+
+	// x and y even
+	if ((groupIndex & 0x9) == 0)
+	{
+		color = 0.25 * (color + tile[groupIndex + 1] + tile[groupIndex + 8] + tile[groupIndex + 9]);
+		storeMip(outMip2, dispatchId.xy / 2, 1, color);
+		tile[groupIndex] = color;
+	}
+	if (pushConstants.mipCount == 2)
+		return;
+	GroupMemoryBarrierWithGroupSync();
+
+	// x and y multiples of 4
+	if ((groupIndex & 0x1B) == 0)
+	{
+		color = 0.25 * (color + tile[groupIndex + 2] + tile[groupIndex + 16] + tile[groupIndex + 18]);
+		storeMip(outMip3, dispatchId.xy / 4, 2, color);
+		tile[groupIndex] = color;
+	}
+	if (pushConstants.mipCount == 3)
+		return;
+	GroupMemoryBarrierWithGroupSync();
+
+	if (groupIndex == 0)
+	{
+		color = 0.25 * (color + tile[4] + tile[32] + tile[36]);
+		storeMip(outMip4, dispatchId.xy / 8, 3, color);
+	}
+}
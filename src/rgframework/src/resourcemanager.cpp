@@ -6,7 +6,10 @@
 HGEGraphics::Texture* oval_create_texture(oval_device_t* device, const CGPUTextureDescriptor& desc)
 {
 	auto D = (oval_cgpu_device_t*)device;
-	return HGEGraphics::create_texture(D->device, desc);
+	auto texture = HGEGraphics::create_texture(D->device, desc);
+	if (D->bindless_heap)
+		D->bindless_heap->allocate(texture);
+	return texture;
 }
 
 HGEGraphics::Texture* oval_create_texture_from_buffer(oval_device_t* device, const CGPUTextureDescriptor& desc, void* data, uint64_t size)
@@ -22,9 +25,23 @@ HGEGraphics::Texture* oval_create_texture_from_buffer(oval_device_t* device, con
 
 void oval_free_texture(oval_device_t* device, HGEGraphics::Texture* texture)
 {
+	auto D = (oval_cgpu_device_t*)device;
+	if (D->bindless_heap)
+		D->bindless_heap->release(texture);
 	HGEGraphics::free_texture(texture);
 }
 
+bool oval_bindless_supported(oval_device_t* device)
+{
+	auto D = (oval_cgpu_device_t*)device;
+	return D->bindless_heap != nullptr;
+}
+
+uint32_t oval_texture_bindless_index(oval_device_t* device, HGEGraphics::Texture* texture)
+{
+	return texture->bindless_index;
+}
+
 HGEGraphics::Mesh* oval_create_mesh_from_buffer(oval_device_t* device, uint32_t vertex_count, uint32_t index_count, ECGPUPrimitiveTopology prim_topology, const CGPUVertexLayout& vertex_layout, uint32_t index_stride, const uint8_t* vertex_data, const uint8_t* index_data, bool update_vertex_data_from_compute_shader, bool update_index_data_from_compute_shader)
 {
 	auto D = (oval_cgpu_device_t*)device;
@@ -55,6 +72,7 @@ CGPUSamplerId oval_create_sampler(oval_device_t* device, const CGPUSamplerDescri
 void oval_free_sampler(oval_device_t* device, CGPUSamplerId sampler)
 {
 	cgpu_free_sampler(sampler);
+	HGEGraphics::invalidate_resource_bindings(sampler);
 }
 
 bool oval_texture_prepared(oval_device_t* device, HGEGraphics::Texture* texture)
@@ -88,6 +106,9 @@ HGEGraphics::Texture* oval_load_texture(oval_device_t* device, const char8_t* fi
 		.mipmap = mipmap,
 	};
 	resource.textureResource.texture->prepared = false;
+	// the slot shows the default texture until loading is done
+	if (D->bindless_heap)
+		D->bindless_heap->allocate(resource.textureResource.texture);
 	D->wait_load_resources.push(resource);
 	return resource.textureResource.texture;
 }
@@ -129,6 +150,8 @@ void oval_process_load_queue(oval_cgpu_device_t* device)
 			auto& textureResource = waited.textureResource;
 			uploaded += load_texture(device, queue, textureResource.texture, waited.path, textureResource.mipmap);
 			waited.textureResource.texture->prepared = true;
+			if (device->bindless_heap)
+				device->bindless_heap->touch();
 			device->allocator.deallocate_bytes((void*)waited.path, waited.path_size);
 		}
 		else if (waited.type == WaitLoadResourceType::Mesh)
@@ -183,6 +206,8 @@ uint8_t* oval_graphics_set_texture_data_slice(oval_device_t* device, HGEGraphics
 	auto D = (oval_cgpu_device_t*)device;
 
 	oval_ensure_cur_transfer_queue(D);
+	if (D->bindless_heap && !texture->prepared)
+		D->bindless_heap->touch();
 	texture->prepared = true;	// TODO: 这里应该设置吗
 	return oval_graphics_transfer_queue_transfer_data_to_texture_slice(D->cur_transfer_queue, texture, mipmap, slice, size);
 }
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace HGEGraphics::Bench
+{
+	struct Benchmark
+	{
+		const char* name;
+		void (*run)();
+	};
+
+	inline std::vector<Benchmark>& registry()
+	{
+		static std::vector<Benchmark> benchmarks;
+		return benchmarks;
+	}
+
+	struct Register
+	{
+		Register(const char* name, void (*run)())
+		{
+			registry().push_back({ name, run });
+		}
+	};
+
+	// average microseconds per call of fn over iterations calls, after one warm up call
+	template<typename Fn>
+	double measure_us(uint32_t iterations, Fn&& fn)
+	{
+		fn();
+		auto begin = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < iterations; ++i)
+			fn();
+		auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::micro>(end - begin).count() / iterations;
+	}
+}
+
+#define BENCHMARK(name) \
+	static void name(); \
+	static HGEGraphics::Bench::Register name##_register(#name, name); \
+	static void name()
@@ -0,0 +1,26 @@
+#include "bench.h"
+#include "synthetic_graph.h"
+#include "rendergraph_compiler.h"
+
+#include <memory_resource>
+
+using namespace HGEGraphics;
+
+BENCHMARK(compile_scaling)
+{
+	double previous = 0;
+	for (uint32_t passCount : { 100u, 1000u, 10000u })
+	{
+		std::pmr::unsynchronized_pool_resource memory;
+		rendergraph_t rg(passCount * 2, passCount * 2, passCount * 8, nullptr, nullptr, &memory);
+		Test::build_synthetic_graph(rg, passCount, 4, 7);
+
+		double us = Bench::measure_us(passCount >= 10000 ? 5 : 50, [&]() { auto compiled = Compiler::Compile(rg, &memory); });
+		// close to 10 means linear scaling from the previous size
+		if (previous > 0)
+			std::printf("%5u passes %10.1f us %6.3f us/pass, x%.1f\n", passCount, us, us / passCount, us / previous);
+		else
+			std::printf("%5u passes %10.1f us %6.3f us/pass\n", passCount, us, us / passCount);
+		previous = us;
+	}
+}
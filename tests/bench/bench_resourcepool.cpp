@@ -0,0 +1,84 @@
+#include "bench.h"
+#include "fake_pool.h"
+#include "graphicspipelinepool.h"
+#include "textureviewpool.h"
+#include "descriptorsetpool.h"
+
+#include <vector>
+
+using namespace HGEGraphics;
+
+namespace
+{
+	constexpr uint32_t entryCount = 10000;
+
+	PSOKey pipeline_key(uint32_t i)
+	{
+		PSOKey key = {};
+		key.shader = reinterpret_cast<Shader*>((uintptr_t)(i / 16 + 1) * 256);
+		key.vertex_layout_id = i % 16;
+		key.render_pass = reinterpret_cast<CGPURenderPassId>((uintptr_t)(i % 4 + 1) * 64);
+		key.render_target_count = 1;
+		key.prim_topology = CGPU_PRIM_TOPO_TRI_LIST;
+		return key;
+	}
+
+	CGPUTextureViewDescriptor view_key(uint32_t i)
+	{
+		CGPUTextureViewDescriptor key = {};
+		key.texture = reinterpret_cast<CGPUTextureId>((uintptr_t)(i / 8 + 1) * 256);
+		key.base_mip_level = i % 8;
+		key.mip_level_count = 1;
+		key.array_layer_count = 1;
+		return key;
+	}
+
+	// a texture and a sampler per set, kept alive for the whole run since keys point at them
+	std::vector<DescriptorBinding> set_bindings(entryCount * 2);
+
+	DescriptorSetKey descriptor_set_key(uint32_t i)
+	{
+		auto bindings = set_bindings.data() + i * 2;
+		bindings[0] = { reinterpret_cast<const void*>((uintptr_t)(i + 1) * 64), 0, 0, 0, CGPU_RESOURCE_TYPE_TEXTURE };
+		bindings[1] = { reinterpret_cast<const void*>((uintptr_t)(i % 8 + 1) * 32), 0, 0, 1, CGPU_RESOURCE_TYPE_SAMPLER };
+
+		DescriptorSetKey key = {};
+		key.root_signature = reinterpret_cast<CGPURootSignatureId>((uintptr_t)(i % 32 + 1) * 256);
+		key.binding_count = 2;
+		key.content_hash = hash_descriptor_bindings(bindings, 2);
+		key.bindings = bindings;
+		return key;
+	}
+
+	// lookups of cached entries in a shuffled order, then the per frame cost of keeping every entry alive
+	template<typename Descriptor, typename Hasher, typename Eq, typename MakeKey>
+	void bench_pool(const char* name, MakeKey make_key)
+	{
+		Test::FakePool<Descriptor, true, Hasher, Eq> pool(entryCount);
+		std::vector<Descriptor> keys;
+		keys.reserve(entryCount);
+		for (uint32_t i = 0; i < entryCount; ++i)
+			keys.push_back(make_key((i * 7919u) % entryCount));
+
+		double fill = Bench::measure_us(1, [&]()
+		{
+			pool.destroy();
+			for (auto& key : keys)
+				pool.getResource(key);
+		});
+		double hit = Bench::measure_us(20, [&]()
+		{
+			for (auto& key : keys)
+				pool.getResource(key);
+		});
+		double frame = Bench::measure_us(20, [&]() { pool.newFrame(); });
+		std::printf("%-16s %u entries, fill %8.1f us, hit %6.1f ns, newFrame %6.2f us\n", name, entryCount, fill, hit * 1000 / entryCount, frame);
+	}
+}
+
+BENCHMARK(resourcepool_10k_entries)
+{
+	bench_pool<PSOKey, PSOKeyHasher, PSOKeyEq>("pipelines", pipeline_key);
+	bench_pool<CGPUTextureViewDescriptor, TextureViewDescriptorHasher, TextureViewDescriptorEq>("texture views", view_key);
+	bench_pool<DescriptorSetKey, DescriptorSetKeyHasher, DescriptorSetKeyEq>("descriptor sets", descriptor_set_key);
+}
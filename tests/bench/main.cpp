@@ -0,0 +1,18 @@
+#include "bench.h"
+
+#include <cstring>
+
+int main(int argc, char** argv)
+{
+	using namespace HGEGraphics::Bench;
+
+	// an argument runs only the benchmarks whose name contains it
+	for (auto& benchmark : registry())
+	{
+		if (argc > 1 && !strstr(benchmark.name, argv[1]))
+			continue;
+		std::printf("== %s\n", benchmark.name);
+		benchmark.run();
+	}
+	return 0;
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "resourcepool.h"
+#include "renderer.h"
+#include <atomic>
+#include <vector>
+
+namespace HGEGraphics::Test
+{
+	template<typename Descriptor>
+	struct FakeResource
+	{
+		Descriptor descriptor() const
+		{
+			return _descriptor;
+		}
+		Descriptor _descriptor;
+		uint32_t id;
+		uint64_t bytes;
+	};
+
+	// creates plain objects instead of device resources and remembers what it destroyed
+	template<typename Descriptor, bool neverRelease, class Hasher = std::hash<Descriptor>, class Eq = std::equal_to<Descriptor>>
+	class FakePool
+		: public ResourcePool<Descriptor, FakeResource<Descriptor>, neverRelease, true, Hasher, Eq>
+	{
+	public:
+		using Resource = FakeResource<Descriptor>;
+
+		FakePool(uint64_t frame_before_out_of_data, uint64_t bytes = 0)
+			: ResourcePool<Descriptor, Resource, neverRelease, true, Hasher, Eq>(frame_before_out_of_data, nullptr, std::pmr::new_delete_resource()), bytes(bytes)
+		{
+		}
+
+		~FakePool()
+		{
+			this->destroy();
+		}
+
+		uint64_t bytes;
+		uint32_t created = 0;
+		std::vector<uint32_t> destroyed;
+
+	protected:
+		virtual Resource* getResource_impl(const Descriptor& descriptor) override
+		{
+			return new Resource{ descriptor, created++, bytes };
+		}
+		virtual void destroyResource_impl(Resource* resource) override
+		{
+			destroyed.push_back(resource->id);
+			delete resource;
+		}
+		virtual uint64_t resourceBytes_impl(const Resource* resource) const override
+		{
+			return resource->bytes;
+		}
+	};
+
+	// hands out made up handles instead of creating pipelines on a device
+	class FakePipelinePool : public GraphicsPipelinePool
+	{
+	public:
+		FakePipelinePool()
+			: GraphicsPipelinePool(CGPU_NULLPTR, nullptr, std::pmr::new_delete_resource())
+		{
+		}
+
+		~FakePipelinePool()
+		{
+			destroy();
+		}
+
+		std::atomic<uint32_t> created{ 0 };
+		std::atomic<uint32_t> freed{ 0 };
+
+	protected:
+		virtual CGPURenderPipelineId createPipeline(const PSOKey& key, const CGPUVertexLayout& vertex_layout) override
+		{
+			return reinterpret_cast<CGPURenderPipelineId>((uintptr_t)++created * 16);
+		}
+		virtual void freePipeline(CGPURenderPipelineId pipeline) override
+		{
+			freed += pipeline != CGPU_NULLPTR;
+		}
+	};
+
+	class FakeDescriptorSetPool : public DescriptorSetPool
+	{
+	public:
+		FakeDescriptorSetPool()
+			: DescriptorSetPool(CGPU_NULLPTR, std::pmr::new_delete_resource())
+		{
+		}
+
+		~FakeDescriptorSetPool()
+		{
+			destroy();
+		}
+
+		uint32_t created = 0;
+
+	protected:
+		virtual CGPUDescriptorSetId createSet(const DescriptorSetKey& key) override
+		{
+			return reinterpret_cast<CGPUDescriptorSetId>((uintptr_t)++created * 16);
+		}
+		virtual void freeSet(CGPUDescriptorSetId set) override
+		{
+		}
+	};
+
+	class FakeRenderPassPool : public RenerPassPool
+	{
+	public:
+		FakeRenderPassPool()
+			: RenerPassPool(CGPU_NULLPTR, std::pmr::new_delete_resource())
+		{
+		}
+
+		~FakeRenderPassPool()
+		{
+			destroy();
+		}
+
+		uint32_t created = 0;
+
+	protected:
+		virtual RenderPass* getResource_impl(const CGPURenderPassDescriptor& descriptor) override
+		{
+			return new RenderPass{ reinterpret_cast<CGPURenderPassId>((uintptr_t)++created * 16), descriptor };
+		}
+		virtual void destroyResource_impl(RenderPass* resource) override
+		{
+			delete resource;
+		}
+	};
+}
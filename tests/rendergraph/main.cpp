@@ -0,0 +1,23 @@
+#include "test.h"
+
+#include <cstdint>
+#include <cstring>
+
+int main(int argc, char** argv)
+{
+	using namespace HGEGraphics::Test;
+
+	// an argument runs only the tests whose name contains it
+	uint32_t ran = 0;
+	for (auto& test : registry())
+	{
+		if (argc > 1 && !strstr(test.name, argv[1]))
+			continue;
+		int before = failures();
+		test.run();
+		std::printf("%s %s\n", failures() == before ? "pass" : "FAIL", test.name);
+		++ran;
+	}
+	std::printf("%u tests, %d failed checks\n", ran, failures());
+	return failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "rendergraph.h"
+#include <vector>
+
+namespace HGEGraphics::Test
+{
+	inline texture_handle_t declare_target(rendergraph_t& rg, bool storage)
+	{
+		auto target = rendergraph_declare_texture(&rg);
+		rg_texture_set_extent(&rg, target, 256, 256);
+		rg_texture_set_format(&rg, target, CGPU_FORMAT_R8G8B8A8_UNORM);
+		if (storage)
+			rg_texture_set_usage(&rg, target, CGPU_RESOURCE_TYPE_RW_TEXTURE);
+		return target;
+	}
+
+	// every pass writes its own target and samples the targets of the two live passes before it, a hold pass at the end keeps the chain alive
+	// every computeEvery-th pass is a compute pass, every deadEvery-th pass writes a target nobody reads and is culled
+	inline void build_synthetic_graph(rendergraph_t& rg, uint32_t passCount, uint32_t computeEvery, uint32_t deadEvery)
+	{
+		std::vector<texture_handle_t> live;
+		live.reserve(passCount);
+		for (uint32_t i = 0; i < passCount; ++i)
+		{
+			bool compute = computeEvery > 0 && i % computeEvery == computeEvery - 1;
+			bool dead = deadEvery > 0 && i % deadEvery == deadEvery - 1;
+			auto target = declare_target(rg, compute);
+			auto builder = compute ? rendergraph_add_computepass(&rg, u8"compute") : rendergraph_add_renderpass(&rg, u8"render");
+			if (compute)
+				computepass_readwrite_texture(&builder, target);
+			else
+				renderpass_add_color_attachment(&builder, target, CGPU_LOAD_ACTION_CLEAR, 0, CGPU_STORE_ACTION_STORE);
+			for (uint32_t back = 1; back <= 2 && back <= live.size(); ++back)
+			{
+				if (compute)
+					computepass_sample(&builder, live[live.size() - back]);
+				else
+					renderpass_sample(&builder, live[live.size() - back]);
+			}
+			if (!dead)
+				live.push_back(target);
+		}
+
+		auto hold = rendergraph_add_holdpass(&rg, u8"hold");
+		for (uint32_t back = 1; back <= 2 && back <= live.size(); ++back)
+			renderpass_sample(&hold, live[live.size() - back]);
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdio>
+#include <vector>
+
+namespace HGEGraphics::Test
+{
+	struct TestCase
+	{
+		const char* name;
+		void (*run)();
+	};
+
+	inline std::vector<TestCase>& registry()
+	{
+		static std::vector<TestCase> tests;
+		return tests;
+	}
+
+	inline int& failures()
+	{
+		static int count = 0;
+		return count;
+	}
+
+	struct Register
+	{
+		Register(const char* name, void (*run)())
+		{
+			registry().push_back({ name, run });
+		}
+	};
+}
+
+#define TEST_CASE(name) \
+	static void name(); \
+	static HGEGraphics::Test::Register name##_register(#name, name); \
+	static void name()
+
+#define CHECK(expr) \
+	do \
+	{ \
+		if (!(expr)) \
+		{ \
+			std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #expr); \
+			++HGEGraphics::Test::failures(); \
+		} \
+	} while (0)
@@ -0,0 +1,178 @@
+#include "test.h"
+#include "synthetic_graph.h"
+#include "rendergraph_compiler.h"
+
+#include <memory_resource>
+#include <vector>
+
+using namespace HGEGraphics;
+using namespace HGEGraphics::Test;
+
+// stands in for the queues and binary semaphores the executor submits batches to, in the same way Executor::Execute does
+struct RecordingQueueBackend
+{
+	struct Submission
+	{
+		ECGPUQueueType queue;
+		index_type_t wait;
+		bool signal;
+	};
+
+	std::vector<Submission> submissions;
+	std::vector<bool> signalled;
+	uint32_t invalid_waits = 0;
+
+	void submit(const std::pmr::vector<CompiledQueueBatch>& batches)
+	{
+		signalled.assign(batches.size(), false);
+		for (index_type_t b = 0; b < batches.size(); ++b)
+		{
+			auto& batch = batches[b];
+			// waiting consumes the signal, a second wait on it would never be satisfied
+			if (batch.wait != MAX_INDEX)
+			{
+				if (batch.wait >= b || !signalled[batch.wait])
+					++invalid_waits;
+				else
+					signalled[batch.wait] = false;
+			}
+			if (batch.signal)
+				signalled[b] = true;
+			submissions.push_back({ batch.queue, batch.wait, batch.signal });
+		}
+	}
+
+	// work of from is complete before to starts, either by queue order or through a chain of waits
+	bool ordered(index_type_t from, index_type_t to) const
+	{
+		if (from == to)
+			return true;
+		if (to == 0 || to <= from)
+			return false;
+		for (index_type_t prev = to; prev-- > 0;)
+		{
+			if (submissions[prev].queue == submissions[to].queue)
+			{
+				if (ordered(from, prev))
+					return true;
+				break;
+			}
+		}
+		auto wait = submissions[to].wait;
+		return wait != MAX_INDEX && ordered(from, wait);
+	}
+};
+
+// every access to a resource has to be ordered after the last write to it and the last write after earlier reads
+static uint32_t unordered_accesses(const CompiledRenderGraph& compiled, const RecordingQueueBackend& backend)
+{
+	std::vector<index_type_t> writers(compiled.resources.size(), MAX_INDEX);
+	std::vector<std::vector<index_type_t>> readers(compiled.resources.size());
+	uint32_t count = 0;
+	for (auto& pass : compiled.passes)
+	{
+		if (pass.name == nullptr)
+			continue;
+		for (auto& edge : pass.reads)
+		{
+			if (writers[edge.index] != MAX_INDEX && !backend.ordered(writers[edge.index], pass.batch))
+				++count;
+			readers[edge.index].push_back(pass.batch);
+		}
+		for (auto& edge : pass.writes)
+		{
+			for (auto reader : readers[edge.index])
+				count += !backend.ordered(reader, pass.batch);
+			readers[edge.index].clear();
+			writers[edge.index] = pass.batch;
+		}
+	}
+	return count;
+}
+
+TEST_CASE(async_compute_waits_once_per_semaphore)
+{
+	std::pmr::unsynchronized_pool_resource memory;
+	rendergraph_t rg(32, 32, 128, nullptr, nullptr, &memory);
+	rendergraph_set_async_compute(&rg, true);
+
+	auto x = declare_target(rg, false);
+	auto y = declare_target(rg, false);
+	auto z = declare_target(rg, false);
+	auto a = declare_target(rg, true);
+	auto b = declare_target(rg, true);
+	auto c = declare_target(rg, true);
+	auto d = declare_target(rg, true);
+
+	// G0 | C1 writes a and b | G2 reads a | C3 | G4 reads b | C5 | G6
+	{
+		auto builder = rendergraph_add_renderpass(&rg, u8"g0");
+		renderpass_add_color_attachment(&builder, x, CGPU_LOAD_ACTION_CLEAR, 0, CGPU_STORE_ACTION_STORE);
+	}
+	{
+		auto builder = rendergraph_add_computepass(&rg, u8"c1");
+		computepass_readwrite_texture(&builder, a);
+		computepass_readwrite_texture(&builder, b);
+	}
+	{
+		auto builder = rendergraph_add_renderpass(&rg, u8"g2");
+		renderpass_sample(&builder, a);
+		renderpass_add_color_attachment(&builder, y, CGPU_LOAD_ACTION_CLEAR, 0, CGPU_STORE_ACTION_STORE);
+	}
+	{
+		auto builder = rendergraph_add_computepass(&rg, u8"c3");
+		computepass_readwrite_texture(&builder, c);
+	}
+	{
+		auto builder = rendergraph_add_renderpass(&rg, u8"g4");
+		renderpass_sample(&builder, b);
+		renderpass_add_color_attachment(&builder, y, CGPU_LOAD_ACTION_LOAD, 0, CGPU_STORE_ACTION_STORE);
+	}
+	{
+		auto builder = rendergraph_add_computepass(&rg, u8"c5");
+		computepass_readwrite_texture(&builder, d);
+	}
+	{
+		auto builder = rendergraph_add_renderpass(&rg, u8"g6");
+		renderpass_sample(&builder, c);
+		renderpass_sample(&builder, d);
+		renderpass_add_color_attachment(&builder, z, CGPU_LOAD_ACTION_CLEAR, 0, CGPU_STORE_ACTION_STORE);
+	}
+	{
+		auto builder = rendergraph_add_holdpass(&rg, u8"hold");
+		renderpass_sample(&builder, x);
+		renderpass_sample(&builder, y);
+		renderpass_sample(&builder, z);
+	}
+
+	auto compiled = Compiler::Compile(rg, &memory);
+	CHECK(compiled.batches.size() == 7);
+	for (index_type_t i = 0; i < compiled.batches.size(); ++i)
+		CHECK(compiled.batches[i].queue == (i % 2 ? CGPU_QUEUE_TYPE_COMPUTE : CGPU_QUEUE_TYPE_GRAPHICS));
+
+	RecordingQueueBackend backend;
+	backend.submit(compiled.batches);
+	CHECK(backend.invalid_waits == 0);
+	CHECK(unordered_accesses(compiled, backend) == 0);
+
+	// g2 consumes c1's signal, g4 is ordered after c1 through it and must not wait again
+	CHECK(compiled.batches[2].wait == 1);
+	CHECK(compiled.batches[4].wait == MAX_INDEX || compiled.batches[4].wait == 3);
+	CHECK(compiled.batches[6].wait == 5);
+}
+
+TEST_CASE(async_compute_synthetic_graph)
+{
+	std::pmr::unsynchronized_pool_resource memory;
+	rendergraph_t rg(256, 256, 1024, nullptr, nullptr, &memory);
+	rendergraph_set_async_compute(&rg, true);
+	build_synthetic_graph(rg, 120, 3, 7);
+
+	auto compiled = Compiler::Compile(rg, &memory);
+	CHECK(compiled.batches.size() > 2);
+
+	RecordingQueueBackend backend;
+	backend.submit(compiled.batches);
+	CHECK(backend.invalid_waits == 0);
+	CHECK(unordered_accesses(compiled, backend) == 0);
+}
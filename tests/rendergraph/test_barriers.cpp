@@ -0,0 +1,134 @@
+#include "test.h"
+#include "synthetic_graph.h"
+#include "rendergraph_compiler.h"
+
+#include <memory_resource>
+
+using namespace HGEGraphics;
+using namespace HGEGraphics::Test;
+
+static uint32_t count_barriers(const CompiledRenderGraph& compiled, const CompiledRenderPassNode& pass, index_type_t resource)
+{
+	uint32_t count = 0;
+	for (auto j = pass.barrierOffset; j < pass.barrierOffset + pass.barrierCount; ++j)
+		count += compiled.barriers[j].resource == resource;
+	return count;
+}
+
+TEST_CASE(barriers_follow_a_chain)
+{
+	std::pmr::unsynchronized_pool_resource memory;
+	rendergraph_t rg(16, 16, 64, nullptr, nullptr, &memory);
+	auto a = declare_target(rg, false);
+	auto b = declare_target(rg, false);
+	{
+		auto builder = rendergraph_add_renderpass(&rg, u8"write a");
+		renderpass_add_color_attachment(&builder, a, CGPU_LOAD_ACTION_CLEAR, 0, CGPU_STORE_ACTION_STORE);
+	}
+	{
+		auto builder = rendergraph_add_renderpass(&rg, u8"a to b");
+		renderpass_sample(&builder, a);
+		renderpass_sample(&builder, a);
+		renderpass_add_color_attachment(&builder, b, CGPU_LOAD_ACTION_CLEAR, 0, CGPU_STORE_ACTION_STORE);
+	}
+	{
+		auto builder = rendergraph_add_holdpass(&rg, u8"hold");
+		renderpass_sample(&builder, b);
+	}
+
+	auto compiled = Compiler::Compile(rg, &memory);
+	CHECK(compiled.passes.size() == 3);
+
+	// first use of a transient starts from undefined and is flagged so the executor skips the state lookup
+	auto& first = compiled.passes[0];
+	CHECK(first.barrierCount == 1);
+	CHECK(compiled.barriers[first.barrierOffset].entry);
+	CHECK(compiled.barriers[first.barrierOffset].src_state == CGPU_RESOURCE_STATE_UNDEFINED);
+	CHECK(compiled.barriers[first.barrierOffset].dst_state == CGPU_RESOURCE_STATE_RENDER_TARGET);
+
+	// sampling a twice still transitions it once
+	auto& second = compiled.passes[1];
+	CHECK(count_barriers(compiled, second, a.index) == 1);
+	CHECK(count_barriers(compiled, second, b.index) == 1);
+	for (auto j = second.barrierOffset; j < second.barrierOffset + second.barrierCount; ++j)
+	{
+		auto& barrier = compiled.barriers[j];
+		if (barrier.resource == a.index)
+		{
+			CHECK(!barrier.entry);
+			CHECK(barrier.src_state == CGPU_RESOURCE_STATE_RENDER_TARGET);
+			CHECK(barrier.dst_state == CGPU_RESOURCE_STATE_SHADER_RESOURCE);
+		}
+	}
+	CHECK(count_barriers(compiled, compiled.passes[2], b.index) == 1);
+}
+
+TEST_CASE(barriers_collapse_uniform_subresources)
+{
+	std::pmr::unsynchronized_pool_resource memory;
+	rendergraph_t rg(16, 16, 64, nullptr, nullptr, &memory);
+	auto mipped = declare_target(rg, true);
+	rg_texture_set_mip_count(&rg, mipped, 4);
+	{
+		auto builder = rendergraph_add_computepass(&rg, u8"write");
+		computepass_readwrite_texture(&builder, mipped);
+	}
+	{
+		auto builder = rendergraph_add_holdpass(&rg, u8"hold");
+		renderpass_sample(&builder, mipped);
+	}
+
+	auto compiled = Compiler::Compile(rg, &memory);
+	auto& hold = compiled.passes[1];
+	CHECK(hold.barrierCount == 1);
+	CHECK(!compiled.barriers[hold.barrierOffset].subresource);
+}
+
+TEST_CASE(barriers_track_single_mips)
+{
+	std::pmr::unsynchronized_pool_resource memory;
+	rendergraph_t rg(16, 16, 64, nullptr, nullptr, &memory);
+	auto mipped = declare_target(rg, true);
+	rg_texture_set_mip_count(&rg, mipped, 4);
+	auto mip1 = rendergraph_declare_texture_subresource(&rg, mipped, 1, 0);
+	{
+		auto builder = rendergraph_add_computepass(&rg, u8"write");
+		computepass_readwrite_texture(&builder, mipped);
+	}
+	{
+		auto builder = rendergraph_add_computepass(&rg, u8"write mip 1");
+		computepass_sample(&builder, mipped);
+		computepass_readwrite_texture(&builder, mip1);
+	}
+	{
+		auto builder = rendergraph_add_holdpass(&rg, u8"hold");
+		renderpass_sample(&builder, mipped);
+	}
+
+	auto compiled = Compiler::Compile(rg, &memory);
+	// only mip 1 leaves the shader resource state, so the hold pass moves just that one back
+	auto& hold = compiled.passes[2];
+	CHECK(hold.barrierCount == 1);
+	auto& barrier = compiled.barriers[hold.barrierOffset];
+	CHECK(barrier.subresource);
+	CHECK(barrier.mipLevel == 1);
+	CHECK(barrier.src_state == CGPU_RESOURCE_STATE_UNORDERED_ACCESS);
+	CHECK(barrier.dst_state == CGPU_RESOURCE_STATE_SHADER_RESOURCE);
+}
+
+TEST_CASE(barriers_of_synthetic_graph)
+{
+	std::pmr::unsynchronized_pool_resource memory;
+	rendergraph_t rg(1024, 1024, 4096, nullptr, nullptr, &memory);
+	build_synthetic_graph(rg, 500, 5, 0);
+
+	auto compiled = Compiler::Compile(rg, &memory);
+	// every pass makes its own target writable and the previous one readable, nothing else needs a transition
+	for (uint32_t k = 1; k + 1 < compiled.passes.size(); ++k)
+	{
+		auto& pass = compiled.passes[k];
+		CHECK(pass.barrierCount <= 2);
+		for (auto j = pass.barrierOffset; j < pass.barrierOffset + pass.barrierCount; ++j)
+			CHECK(compiled.barriers[j].src_state != compiled.barriers[j].dst_state || compiled.barriers[j].dst_state == CGPU_RESOURCE_STATE_UNORDERED_ACCESS);
+	}
+}
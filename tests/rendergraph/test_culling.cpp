@@ -0,0 +1,106 @@
+#include "test.h"
+#include "synthetic_graph.h"
+#include "rendergraph_compiler.h"
+
+#include <memory_resource>
+#include <vector>
+
+using namespace HGEGraphics;
+using namespace HGEGraphics::Test;
+
+// reference culling straight from the edge list, repeatedly dropping passes whose outputs nobody alive reads and resources no alive pass reads
+static std::vector<bool> reference_live_passes(const rendergraph_t& rg)
+{
+	std::vector<bool> livePasses(rg.passes.size(), true);
+	std::vector<bool> liveResources(rg.resources.size(), true);
+	bool changed = true;
+	while (changed)
+	{
+		changed = false;
+		std::vector<bool> read(rg.resources.size(), false);
+		for (auto edgeIndex : rg.read_edges)
+		{
+			auto& edge = rg.edges[edgeIndex];
+			if (livePasses[edge.to])
+				read[edge.from] = true;
+		}
+		std::vector<bool> written(rg.passes.size(), false);
+		for (auto edgeIndex : rg.write_edges)
+		{
+			auto& edge = rg.edges[edgeIndex];
+			if (liveResources[edge.to])
+				written[edge.from] = true;
+		}
+		for (index_type_t i = 0; i < rg.resources.size(); ++i)
+		{
+			bool persistent = rg.resources[i].manageType != ManageType::Managed;
+			if (liveResources[i] && !read[i] && !persistent)
+				liveResources[i] = !(changed = true);
+		}
+		for (index_type_t i = 0; i < rg.passes.size(); ++i)
+		{
+			bool persistent = rg.passes[i].type == PASS_TYPE_HOLDON || rg.passes[i].type == PASS_TYPE_PRESENT;
+			if (livePasses[i] && !written[i] && !persistent)
+				livePasses[i] = !(changed = true);
+		}
+	}
+	return livePasses;
+}
+
+TEST_CASE(culling_matches_reference)
+{
+	for (uint32_t passCount : { 10u, 100u, 1000u })
+	{
+		std::pmr::unsynchronized_pool_resource memory;
+		rendergraph_t rg(passCount * 2, passCount * 2, passCount * 8, nullptr, nullptr, &memory);
+		build_synthetic_graph(rg, passCount, 4, 3);
+
+		auto live = reference_live_passes(rg);
+		auto compiled = Compiler::Compile(rg, &memory);
+		CHECK(compiled.passes.size() == rg.passes.size());
+		uint32_t mismatches = 0;
+		uint32_t culled = 0;
+		for (auto& pass : compiled.passes)
+		{
+			mismatches += (pass.name != nullptr) != live[pass.source];
+			culled += pass.name == nullptr;
+		}
+		CHECK(mismatches == 0);
+		CHECK(culled > 0);
+	}
+}
+
+TEST_CASE(compiled_edges_keep_declaration_order)
+{
+	std::pmr::unsynchronized_pool_resource memory;
+	rendergraph_t rg(64, 64, 256, nullptr, nullptr, &memory);
+	build_synthetic_graph(rg, 20, 0, 0);
+
+	auto compiled = Compiler::Compile(rg, &memory);
+	uint32_t mismatches = 0;
+	for (auto& pass : compiled.passes)
+	{
+		if (pass.name == nullptr)
+			continue;
+		std::vector<CompiledEdge> reads;
+		std::vector<CompiledEdge> writes;
+		for (auto edgeIndex : rg.read_edges)
+		{
+			auto& edge = rg.edges[edgeIndex];
+			if (edge.to == pass.source)
+				reads.push_back({ edge.from, edge.usage });
+		}
+		for (auto edgeIndex : rg.write_edges)
+		{
+			auto& edge = rg.edges[edgeIndex];
+			if (edge.from == pass.source)
+				writes.push_back({ edge.to, edge.usage });
+		}
+		mismatches += reads.size() != pass.reads.size() || writes.size() != pass.writes.size();
+		for (size_t j = 0; j < std::min(reads.size(), pass.reads.size()); ++j)
+			mismatches += reads[j].index != pass.reads[j].index || reads[j].usage != pass.reads[j].usage;
+		for (size_t j = 0; j < std::min(writes.size(), pass.writes.size()); ++j)
+			mismatches += writes[j].index != pass.writes[j].index || writes[j].usage != pass.writes[j].usage;
+	}
+	CHECK(mismatches == 0);
+}
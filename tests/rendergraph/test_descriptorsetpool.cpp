@@ -0,0 +1,73 @@
+#include "test.h"
+#include "fake_pool.h"
+
+using namespace HGEGraphics;
+using namespace HGEGraphics::Test;
+
+namespace
+{
+	const void* fake_resource(uintptr_t i)
+	{
+		return reinterpret_cast<const void*>(i * 64);
+	}
+
+	DescriptorSetKey set_key(const DescriptorBinding* bindings, uint32_t count)
+	{
+		DescriptorSetKey key = {};
+		key.root_signature = reinterpret_cast<CGPURootSignatureId>((uintptr_t)256);
+		key.binding_count = count;
+		key.content_hash = hash_descriptor_bindings(bindings, count);
+		key.bindings = bindings;
+		return key;
+	}
+}
+
+// the hash only finds candidates, a set written with other resources must never be handed out as written
+TEST_CASE(descriptorsetpool_matches_bindings_not_hash)
+{
+	FakeDescriptorSetPool pool;
+	DescriptorBinding a[] = { { fake_resource(1), 0, 0, 0, CGPU_RESOURCE_TYPE_TEXTURE } };
+	DescriptorBinding b[] = { { fake_resource(2), 0, 0, 0, CGPU_RESOURCE_TYPE_TEXTURE } };
+	auto key_a = set_key(a, 1);
+	auto key_b = set_key(b, 1);
+	key_b.content_hash = key_a.content_hash;
+
+	bool written;
+	auto set_a = pool.getDescriptorSet(key_a, written);
+	CHECK(!written);
+	auto set_b = pool.getDescriptorSet(key_b, written);
+	CHECK(!written && set_b != set_a);
+
+	// the cached key keeps its own copy of the bindings
+	a[0].resource = fake_resource(3);
+	DescriptorBinding again[] = { { fake_resource(1), 0, 0, 0, CGPU_RESOURCE_TYPE_TEXTURE } };
+	CHECK(pool.getDescriptorSet(set_key(again, 1), written) == set_a && written);
+	CHECK(pool.created == 2);
+}
+
+TEST_CASE(descriptorsetpool_invalidates_only_sets_using_a_freed_resource)
+{
+	FakeDescriptorSetPool pool;
+	auto sampler = fake_resource(10);
+	DescriptorBinding a[] = { { fake_resource(11), 0, 0, 0, CGPU_RESOURCE_TYPE_TEXTURE }, { sampler, 0, 0, 1, CGPU_RESOURCE_TYPE_SAMPLER } };
+	DescriptorBinding b[] = { { fake_resource(12), 0, 0, 0, CGPU_RESOURCE_TYPE_TEXTURE }, { sampler, 0, 0, 1, CGPU_RESOURCE_TYPE_SAMPLER } };
+
+	bool written;
+	auto set_a = pool.getDescriptorSet(set_key(a, 2), written);
+	auto set_b = pool.getDescriptorSet(set_key(b, 2), written);
+
+	// set_a may already be bound this frame, so it comes back as a new set instead of being rewritten
+	invalidate_resource_bindings(fake_resource(11));
+	CHECK(pool.getDescriptorSet(set_key(b, 2), written) == set_b && written);
+	auto rewritten = pool.getDescriptorSet(set_key(a, 2), written);
+	CHECK(!written && rewritten != set_a);
+	CHECK(pool.created == 3);
+
+	invalidate_resource_bindings(sampler);
+	pool.newFrame();
+	pool.getDescriptorSet(set_key(a, 2), written);
+	CHECK(!written);
+	pool.getDescriptorSet(set_key(b, 2), written);
+	CHECK(!written);
+	CHECK(pool.created == 3);
+}
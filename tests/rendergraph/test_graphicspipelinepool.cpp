@@ -0,0 +1,75 @@
+#include "test.h"
+#include "fake_pool.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace HGEGraphics;
+using namespace HGEGraphics::Test;
+
+namespace
+{
+	PSOKey pipeline_key(Shader* shader, CGPURenderPassId render_pass)
+	{
+		PSOKey key = {};
+		key.shader = shader;
+		key.render_pass = render_pass;
+		key.render_target_count = 1;
+		key.prim_topology = CGPU_PRIM_TOPO_TRI_LIST;
+		return key;
+	}
+}
+
+// the pool and the compile counters are freed as soon as destroy returns, which must not race the workers
+TEST_CASE(async_compiles_finish_before_pool_destroy)
+{
+	WorkerPool workers(4, std::pmr::new_delete_resource());
+	std::vector<Shader> shaders(64);
+	CGPUVertexLayout vertex_layout = {};
+	CGPURenderPassDescriptor render_pass = {};
+	uint32_t pending = 0;
+	uint32_t leaked = 0;
+	for (int round = 0; round < 20; ++round)
+	{
+		auto jobs = new PipelineCompileJobs();
+		auto pool = new FakePipelinePool();
+		pool->setAsyncCompile(&workers, jobs);
+		for (auto& shader : shaders)
+			pool->prewarm(pipeline_key(&shader, CGPU_NULLPTR), vertex_layout, render_pass);
+		pool->destroy();
+		pending += jobs->pending.load();
+		leaked += pool->created != pool->freed;
+		delete pool;
+		delete jobs;
+	}
+	CHECK(pending == 0);
+	CHECK(leaked == 0);
+}
+
+TEST_CASE(vertex_layout_ids_compare_content)
+{
+	std::u8string position = u8"POSITION";
+	std::u8string texcoord = u8"TEXCOORD";
+	CGPUVertexLayout layout = { .attribute_count = 2 };
+	layout.attributes[0] = { position.c_str(), 1, CGPU_FORMAT_R32G32B32_SFLOAT, 0, 0, 12, CGPU_INPUT_RATE_VERTEX };
+	layout.attributes[1] = { texcoord.c_str(), 1, CGPU_FORMAT_R32G32_SFLOAT, 0, 12, 8, CGPU_INPUT_RATE_VERTEX };
+	auto id = intern_vertex_layout(layout);
+
+	// same content behind other name pointers
+	CGPUVertexLayout copy = { .attribute_count = 2 };
+	copy.attributes[0] = { u8"POSITION", 1, CGPU_FORMAT_R32G32B32_SFLOAT, 0, 0, 12, CGPU_INPUT_RATE_VERTEX };
+	copy.attributes[1] = { u8"TEXCOORD", 1, CGPU_FORMAT_R32G32_SFLOAT, 0, 12, 8, CGPU_INPUT_RATE_VERTEX };
+	position.assign(u8"NORMAL");
+	CHECK(intern_vertex_layout(copy) == id);
+
+	std::vector<uint64_t> ids;
+	for (uint32_t offset = 0; offset < 256; ++offset)
+	{
+		copy.attributes[1].offset = offset;
+		ids.push_back(intern_vertex_layout(copy));
+	}
+	std::sort(ids.begin(), ids.end());
+	CHECK(std::unique(ids.begin(), ids.end()) == ids.end());
+	CHECK(intern_vertex_layout(layout) != id);
+}
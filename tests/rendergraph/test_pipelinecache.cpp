@@ -0,0 +1,104 @@
+#include "test.h"
+#include "fake_pool.h"
+#include "pipelinecache.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+using namespace HGEGraphics;
+using namespace HGEGraphics::Test;
+
+namespace
+{
+	const ECGPUPrimitiveTopology topologies[] = { CGPU_PRIM_TOPO_TRI_LIST, CGPU_PRIM_TOPO_LINE_LIST };
+
+	struct Launch
+	{
+		// semantic names live in strings of this launch only, so nothing can rely on their addresses
+		std::u8string position = u8"POSITION";
+		std::u8string texcoord = u8"TEXCOORD";
+		CGPUVertexLayout layout = {};
+		CGPURenderPassDescriptor render_pass = {};
+		PipelineCache cache{ std::pmr::new_delete_resource() };
+		FakeRenderPassPool render_passes;
+		FakePipelinePool pipelines;
+
+		Launch()
+		{
+			layout.attribute_count = 2;
+			layout.attributes[0] = { position.c_str(), 1, CGPU_FORMAT_R32G32B32_SFLOAT, 0, 0, 12, CGPU_INPUT_RATE_VERTEX };
+			layout.attributes[1] = { texcoord.c_str(), 1, CGPU_FORMAT_R32G32_SFLOAT, 0, 12, 8, CGPU_INPUT_RATE_VERTEX };
+			render_pass.sample_count = CGPU_SAMPLE_COUNT_1;
+			render_pass.color_attachments[0] = { CGPU_FORMAT_R8G8B8A8_UNORM, CGPU_LOAD_ACTION_CLEAR, CGPU_STORE_ACTION_STORE };
+			pipelines.setPipelineCache(&cache);
+		}
+
+		void draw(Shader* shader)
+		{
+			RenderPassEncoder encoder = {};
+			encoder.render_pass = render_passes.getRenderPass(render_pass)->renderPass;
+			encoder.render_pass_desc = &render_pass;
+			encoder.render_target_count = 1;
+			for (auto topology : topologies)
+				pipelines.getGraphicsPipeline(&encoder, shader, topology, layout, intern_vertex_layout(layout));
+		}
+
+		void newFrame()
+		{
+			render_passes.newFrame();
+			pipelines.newFrame();
+		}
+	};
+}
+
+TEST_CASE(second_launch_creates_no_uncached_pipelines)
+{
+	auto path = (std::filesystem::temp_directory_path() / "rendergraph_test_pipelines.bin").string();
+	Shader shaders[2] = {};
+	shaders[0].hash = 11;
+	shaders[1].hash = 22;
+	shaders[1].depth_desc.depth_test = true;
+	shaders[1].depth_desc.depth_write = true;
+
+	{
+		Launch first;
+		for (auto& shader : shaders)
+			first.draw(&shader);
+		CHECK(first.cache.uncached() == 4);
+		CHECK(first.cache.save(path.c_str()));
+	}
+
+	Launch second;
+	CHECK(second.cache.load(path.c_str()));
+	std::remove(path.c_str());
+	for (auto& shader : shaders)
+		second.cache.prewarm(second.pipelines, second.render_passes, &shader);
+	CHECK(second.cache.prewarmed() == 4);
+	CHECK(second.pipelines.created == 4);
+
+	// the first draw comes well after the pools would age out an unused entry
+	for (int frame = 0; frame < 40; ++frame)
+		second.newFrame();
+	for (auto& shader : shaders)
+		second.draw(&shader);
+	second.newFrame();
+	CHECK(second.pipelines.stats().hits == 4);
+	CHECK(second.pipelines.created == 4);
+	CHECK(second.render_passes.created == 1);
+	CHECK(second.cache.uncached() == 0);
+}
+
+TEST_CASE(pipeline_cache_rejects_other_versions)
+{
+	auto path = (std::filesystem::temp_directory_path() / "rendergraph_test_pipelines_old.bin").string();
+	{
+		uint32_t header[] = { 0x4350564f, 2, 0, 0 };
+		auto file = std::fopen(path.c_str(), "wb");
+		std::fwrite(header, sizeof(header), 1, file);
+		std::fclose(file);
+	}
+	PipelineCache cache(std::pmr::new_delete_resource());
+	CHECK(!cache.load(path.c_str()));
+	std::remove(path.c_str());
+}
@@ -0,0 +1,143 @@
+#include "test.h"
+#include "fake_pool.h"
+
+#include <algorithm>
+#include <map>
+#include <random>
+
+using namespace HGEGraphics;
+using namespace HGEGraphics::Test;
+
+TEST_CASE(resourcepool_released_resources_are_reused)
+{
+	FakePool<uint32_t, false> pool(2);
+	auto a = pool.getResource(7);
+	auto b = pool.getResource(7);
+	CHECK(a != b);
+	CHECK(pool.created == 2);
+	pool.releaseResource(a);
+	CHECK(pool.getResource(7) == a);
+	CHECK(pool.getResource(8) != a);
+	CHECK(pool.created == 3);
+	pool.releaseResource(a);
+	pool.releaseResource(b);
+}
+
+TEST_CASE(resourcepool_ages_out_unused_entries)
+{
+	FakePool<uint32_t, true> pool(2);
+	auto kept = pool.getResource(1);
+	auto dropped = pool.getResource(2)->id;
+	for (int frame = 0; frame < 3; ++frame)
+	{
+		pool.newFrame();
+		CHECK(pool.getResource(1) == kept);
+	}
+	CHECK(pool.destroyed.size() == 1 && pool.destroyed[0] == dropped);
+	CHECK(pool.getResource(2) != nullptr);
+	CHECK(pool.created == 3);
+	CHECK(pool.stats().hits == 1);
+}
+
+// random acquires, releases and frames against a plain model of what the pool holds
+TEST_CASE(resourcepool_matches_reference)
+{
+	const uint64_t frames = 3;
+	FakePool<uint32_t, false> pool(frames);
+	std::mt19937 random(1234);
+
+	struct Cached
+	{
+		uint32_t id;
+		uint64_t released;
+	};
+	std::multimap<uint32_t, Cached> cached;
+	std::vector<FakeResource<uint32_t>*> acquired;
+	uint64_t frame = 0;
+	uint32_t mismatches = 0;
+
+	for (int step = 0; step < 20000; ++step)
+	{
+		auto op = random() % 10;
+		if (op < 5)
+		{
+			uint32_t descriptor = random() % 64;
+			auto created = pool.created;
+			auto resource = pool.getResource(descriptor);
+			if (pool.created == created)
+			{
+				// a hit has to hand out one of the cached resources for the descriptor
+				auto range = cached.equal_range(descriptor);
+				auto iter = std::find_if(range.first, range.second, [&](auto& entry) { return entry.second.id == resource->id; });
+				if (iter == range.second)
+					++mismatches;
+				else
+					cached.erase(iter);
+			}
+			else
+				mismatches += cached.count(descriptor) != 0;
+			acquired.push_back(resource);
+		}
+		else if (op < 9 && !acquired.empty())
+		{
+			auto index = random() % acquired.size();
+			auto resource = acquired[index];
+			acquired[index] = acquired.back();
+			acquired.pop_back();
+			pool.releaseResource(resource);
+			cached.insert({ resource->_descriptor, { resource->id, frame } });
+		}
+		else
+		{
+			pool.newFrame();
+			++frame;
+			std::vector<uint32_t> expected;
+			for (auto iter = cached.begin(); iter != cached.end();)
+			{
+				if (frame > iter->second.released + frames)
+				{
+					expected.push_back(iter->second.id);
+					iter = cached.erase(iter);
+				}
+				else
+					++iter;
+			}
+			std::sort(expected.begin(), expected.end());
+			std::sort(pool.destroyed.begin(), pool.destroyed.end());
+			mismatches += expected != pool.destroyed;
+			pool.destroyed.clear();
+		}
+	}
+	CHECK(mismatches == 0);
+
+	for (auto resource : acquired)
+		pool.releaseResource(resource);
+}
+
+TEST_CASE(resourcepool_budget_evicts_only_memory)
+{
+	PoolBudget budget;
+	budget.budget_bytes = 250;
+	FakePool<uint32_t, true> views(10);
+	FakePool<uint32_t, true> textures(10, 100);
+	views.setBudget(&budget);
+	textures.setBudget(&budget);
+	for (uint32_t i = 0; i < 4; ++i)
+	{
+		views.getResource(i);
+		textures.getResource(i);
+	}
+	CHECK(budget.used_bytes == 400);
+
+	// used in the last frame, so nothing can go yet
+	views.newFrame();
+	textures.newFrame();
+	CHECK(textures.destroyed.empty());
+
+	textures.getResource(3);
+	views.newFrame();
+	textures.newFrame();
+	CHECK(views.destroyed.empty());
+	CHECK(textures.destroyed.size() == 2 && budget.used_bytes == 200);
+	CHECK(textures.getResource(3) && textures.created == 4);
+}
@@ -0,0 +1,69 @@
+#include "test.h"
+#include "subresourcestates.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace HGEGraphics;
+
+namespace
+{
+	const ECGPUResourceState states[] = { CGPU_RESOURCE_STATE_UNDEFINED, CGPU_RESOURCE_STATE_SHADER_RESOURCE, CGPU_RESOURCE_STATE_RENDER_TARGET, CGPU_RESOURCE_STATE_UNORDERED_ACCESS, CGPU_RESOURCE_STATE_COPY_DEST };
+
+	// runs cover every subresource in order and neighbouring runs never share a state
+	bool runs_are_canonical(const SubresourceStates& encoded)
+	{
+		uint32_t next = 0;
+		for (uint32_t i = 0; i < encoded.runs(); ++i)
+		{
+			auto& run = encoded.run(i);
+			if (run.begin != next || run.end <= run.begin)
+				return false;
+			if (i > 0 && encoded.run(i - 1).state == run.state)
+				return false;
+			next = run.end;
+		}
+		return next == encoded.size();
+	}
+}
+
+TEST_CASE(subresourcestates_matches_dense_reference)
+{
+	std::mt19937 random(42);
+	uint32_t mismatches = 0;
+	for (uint32_t count : { 1u, 4u, 12u, 6u * 11u, 256u })
+	{
+		SubresourceStates encoded;
+		encoded.reset(count, CGPU_RESOURCE_STATE_UNDEFINED);
+		std::vector<ECGPUResourceState> dense(count, CGPU_RESOURCE_STATE_UNDEFINED);
+		for (int step = 0; step < 2000; ++step)
+		{
+			uint32_t begin = random() % count;
+			// mostly single subresources, like a pass touching one mip, sometimes whole ranges
+			uint32_t end = random() % 4 ? begin + 1 : begin + 1 + random() % (count - begin);
+			auto state = states[random() % std::size(states)];
+			encoded.set(begin, end, state);
+			std::fill(dense.begin() + begin, dense.begin() + end, state);
+
+			for (uint32_t i = 0; i < count; ++i)
+				mismatches += encoded.get(i) != dense[i];
+			mismatches += !runs_are_canonical(encoded);
+			mismatches += encoded.uniform() != (std::count(dense.begin(), dense.end(), dense[0]) == count);
+		}
+	}
+	CHECK(mismatches == 0);
+}
+
+TEST_CASE(subresourcestates_spills_and_collapses)
+{
+	SubresourceStates encoded;
+	encoded.reset(16, CGPU_RESOURCE_STATE_UNDEFINED);
+	for (uint32_t i = 0; i < 16; i += 2)
+		encoded.set(i, i + 1, CGPU_RESOURCE_STATE_SHADER_RESOURCE);
+	CHECK(encoded.runs() == 16);
+	CHECK(encoded.get(14) == CGPU_RESOURCE_STATE_SHADER_RESOURCE && encoded.get(15) == CGPU_RESOURCE_STATE_UNDEFINED);
+	encoded.set(0, 16, CGPU_RESOURCE_STATE_RENDER_TARGET);
+	CHECK(encoded.uniform() && encoded.runs() == 1);
+	CHECK(encoded.get(9) == CGPU_RESOURCE_STATE_RENDER_TARGET);
+}
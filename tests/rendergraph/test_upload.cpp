@@ -0,0 +1,24 @@
+#include "test.h"
+#include "rendergraph.h"
+
+#include <memory_resource>
+
+using namespace HGEGraphics;
+
+// mips smaller than a block still upload one whole block per row and column
+TEST_CASE(upload_staging_rounds_up_to_blocks)
+{
+	std::pmr::unsynchronized_pool_resource memory;
+	rendergraph_t rg(16, 16, 64, nullptr, nullptr, &memory);
+	auto texture = rendergraph_declare_texture(&rg);
+	rg_texture_set_extent(&rg, texture, 8, 8);
+	rg_texture_set_format(&rg, texture, CGPU_FORMAT_DXBC1_RGBA_UNORM);
+	rg_texture_set_mip_count(&rg, texture, 4);
+
+	// 2x2, 1x1 and 1x1 blocks of 8 bytes
+	rendergraph_add_uploadtexturepass_full(&rg, u8"upload", texture, 4, 56, nullptr);
+	CHECK(rg.passes.back().upload_texture_context.staging_size == 56);
+
+	rendergraph_add_uploadtexturepass_ex(&rg, u8"upload mip", texture, 3, 0, 8, 0, nullptr, nullptr, 0, nullptr);
+	CHECK(rg.passes.back().upload_texture_context.staging_size == 8);
+}
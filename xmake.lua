@@ -33,6 +33,9 @@ target("rendergraph")
     add_headerfiles("src/rendergraph/include/*.h")
     add_headerfiles("src/rendergraph/src/*.h", {install = false})
     add_files("src/rendergraph/src/*.cpp")
+    if is_plat("linux") then
+        add_syslinks("pthread")
+    end
 
 includes("src/khr/xmake.lua")
 
@@ -102,3 +105,19 @@ target("computeparticle")
         add_rules("androidcpp", {android_sdk_version = "34", android_manifest = "examples/AndroidManifest.xml", android_res = "examples/res", android_assets = "examples/assets", attachedjar = path.join("androidsdl", "libsdl-2.30.7.jar"), apk_output_path = ".", package_name = "com.xmake.androidcpp", activity_name = "org.libsdl.app.SDLActivity"})
     end
     add_files("examples/computeparticle/*.cpp")
+
+if not is_plat("android") then
+    target("rendergraph_test")
+        set_kind("binary")
+        set_group("tests")
+        add_deps("rendergraph")
+        add_files("tests/rendergraph/*.cpp")
+        add_tests("default")
+
+    target("rendergraph_bench")
+        set_kind("binary")
+        set_group("tests")
+        add_deps("rendergraph")
+        add_includedirs("tests/rendergraph")
+        add_files("tests/bench/*.cpp")
+end